@@ -0,0 +1,110 @@
+#include "alloc_tracker.h"
+
+#if NYX_ALLOC_TRACKING
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Replacement global allocation functions. They forward to malloc / free and
+// count every call in alloctrack::threadCounters.
+
+static void* trackedAlloc(std::size_t size)
+{
+    alloctrack::threadCounters.allocs++;
+    alloctrack::threadCounters.bytes += size;
+    return std::malloc(size ? size : 1);
+}
+
+static void* trackedAlignedAlloc(std::size_t size, std::size_t align)
+{
+    alloctrack::threadCounters.allocs++;
+    alloctrack::threadCounters.bytes += size;
+    if (size == 0)
+        size = 1;
+#ifdef _WIN32
+    return _aligned_malloc(size, align);
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, align < sizeof(void*) ? sizeof(void*) : align, size) != 0)
+        return nullptr;
+    return p;
+#endif
+}
+
+static void trackedFree(void* p)
+{
+    if (!p)
+        return;
+    alloctrack::threadCounters.frees++;
+    std::free(p);
+}
+
+static void trackedAlignedFree(void* p)
+{
+    if (!p)
+        return;
+    alloctrack::threadCounters.frees++;
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size)
+{
+    void* p = trackedAlloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    void* p = trackedAlloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size); }
+
+void operator delete(void* p) noexcept { trackedFree(p); }
+void operator delete[](void* p) noexcept { trackedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { trackedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    void* p = trackedAlignedAlloc(size, (std::size_t)align);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    void* p = trackedAlignedAlloc(size, (std::size_t)align);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return trackedAlignedAlloc(size, (std::size_t)align); }
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return trackedAlignedAlloc(size, (std::size_t)align); }
+
+void operator delete(void* p, std::align_val_t) noexcept { trackedAlignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { trackedAlignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { trackedAlignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { trackedAlignedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { trackedAlignedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { trackedAlignedFree(p); }
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+// Heap allocation counters. alloc_tracker.cpp replaces the global operator
+// new / delete and bumps these on every call. Counters are per thread, so the
+// main loop can tell exactly what its own frame allocated without the audio
+// threads getting mixed in.
+//
+// Build with NYX_ALLOC_TRACKING=0 to keep the default allocator untouched;
+// the counters then just stay at zero.
+
+#ifndef NYX_ALLOC_TRACKING
+#define NYX_ALLOC_TRACKING 1
+#endif
+
+#include <cstdint>
+
+namespace alloctrack {
+
+struct Counters {
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t bytes;     // bytes requested, frees are not subtracted
+};
+
+// Trivially constructible so it is safe to touch from inside operator new
+inline thread_local Counters threadCounters = { 0, 0, 0 };
+
+inline uint64_t threadAllocs() { return threadCounters.allocs; }
+inline uint64_t threadBytes() { return threadCounters.bytes; }
+
+} // namespace alloctrack
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef ANIM_IMPORT_H
+#define ANIM_IMPORT_H
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <learnopengl/animdata.h>
+
+#include "anim_runtime.h"
+#include "vertex_format.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Assimp -> anim_runtime.h conversion. Only used at load time.
+
+inline glm::mat4 aiToGlm(const aiMatrix4x4& m)
+{
+    // Assimp is row major, glm is column major
+    glm::mat4 r;
+    r[0][0] = m.a1; r[1][0] = m.a2; r[2][0] = m.a3; r[3][0] = m.a4;
+    r[0][1] = m.b1; r[1][1] = m.b2; r[2][1] = m.b3; r[3][1] = m.b4;
+    r[0][2] = m.c1; r[1][2] = m.c2; r[2][2] = m.c3; r[3][2] = m.c4;
+    r[0][3] = m.d1; r[1][3] = m.d2; r[2][3] = m.d3; r[3][3] = m.d4;
+    return r;
+}
+
+// Flattens the node tree so every parent comes before its children. Bone ids
+// and offsets come from the Model's bone map so the palette lines up with the
+// bone ids stored in its vertices.
+inline void importSkeleton(const aiNode* root, const std::map<std::string, BoneInfo>& bones, Skeleton& out)
+{
+    out.joints.clear();
+    out.boneCount = 0;
+
+    std::vector<std::pair<const aiNode*, int>> stack;
+    stack.push_back({ root, -1 });
+    while (!stack.empty())
+    {
+        const aiNode* node = stack.back().first;
+        int parent = stack.back().second;
+        stack.pop_back();
+
+        SkeletonJoint joint;
+        joint.name = node->mName.C_Str();
+        joint.parent = parent;
+        joint.bindLocal = aiToGlm(node->mTransformation);
+        joint.boneId = -1;
+        joint.offset = glm::mat4(1.0f);
+
+        auto it = bones.find(joint.name);
+        if (it != bones.end())
+        {
+            joint.boneId = it->second.id;
+            joint.offset = it->second.offset;
+            out.boneCount = std::max(out.boneCount, joint.boneId + 1);
+        }
+
+        int index = (int)out.joints.size();
+        out.joints.push_back(joint);
+
+        // push in reverse so children come out in file order
+        for (int c = (int)node->mNumChildren - 1; c >= 0; --c)
+            stack.push_back({ node->mChildren[c], index });
+    }
+}
+
+inline void importClip(const aiAnimation* anim, const Skeleton& skeleton, AnimClip& out)
+{
+    out.name = anim->mName.C_Str();
+    out.duration = (float)anim->mDuration;
+    out.ticksPerSecond = anim->mTicksPerSecond != 0.0 ? (float)anim->mTicksPerSecond : 25.0f;
+    out.trackOfJoint.assign(skeleton.joints.size(), -1);
+    out.tracks.clear();
+    out.tracks.reserve(anim->mNumChannels);
+
+    for (unsigned int c = 0; c < anim->mNumChannels; ++c)
+    {
+        const aiNodeAnim* channel = anim->mChannels[c];
+        int joint = skeleton.findJoint(channel->mNodeName.C_Str());
+        if (joint < 0)
+        {
+            std::cout << "Warning: clip " << out.name << " animates unknown node " << channel->mNodeName.C_Str() << std::endl;
+            continue;
+        }
+
+        JointTrack track;
+        track.positions.reserve(channel->mNumPositionKeys);
+        for (unsigned int k = 0; k < channel->mNumPositionKeys; ++k)
+        {
+            const aiVectorKey& key = channel->mPositionKeys[k];
+            track.positions.push_back({ glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z), (float)key.mTime });
+        }
+        track.rotations.reserve(channel->mNumRotationKeys);
+        for (unsigned int k = 0; k < channel->mNumRotationKeys; ++k)
+        {
+            const aiQuatKey& key = channel->mRotationKeys[k];
+            track.rotations.push_back({ glm::quat(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z), (float)key.mTime });
+        }
+        track.scales.reserve(channel->mNumScalingKeys);
+        for (unsigned int k = 0; k < channel->mNumScalingKeys; ++k)
+        {
+            const aiVectorKey& key = channel->mScalingKeys[k];
+            track.scales.push_back({ glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z), (float)key.mTime });
+        }
+
+        out.trackOfJoint[joint] = (int)out.tracks.size();
+        out.tracks.push_back(std::move(track));
+    }
+}
+
+// ==================== SKINNED MESHES ====================
+
+struct ImportedMesh {
+    std::vector<SkinnedVertex> vertices;
+    std::vector<unsigned int> indices;
+    std::string diffusePath;                // first diffuse texture, empty when it has none
+};
+
+struct ImportedModel {
+    std::vector<ImportedMesh> meshes;
+    std::map<std::string, BoneInfo> bones;  // by node name, what loadAnimClip maps clips onto
+};
+
+inline void importMesh(const aiMesh* mesh, const aiScene* scene, const std::string& directory, ImportedModel& model)
+{
+    ImportedMesh out;
+    out.vertices.resize(mesh->mNumVertices);
+    for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+    {
+        SkinnedVertex& vertex = out.vertices[i];
+        vertex.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        vertex.normal = mesh->mNormals ? glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z) : glm::vec3(0.0f);
+        vertex.texCoords = glm::vec2(0.0f);
+        vertex.tangent = vertex.bitangent = glm::vec3(0.0f);
+        if (mesh->mTextureCoords[0])
+            vertex.texCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+        if (mesh->mTangents && mesh->mBitangents)
+        {
+            vertex.tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+            vertex.bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+        }
+        for (int k = 0; k < MAX_SKIN_INFLUENCES; ++k)
+        {
+            vertex.boneIds[k] = -1;
+            vertex.weights[k] = 0.0f;
+        }
+    }
+
+    for (unsigned int f = 0; f < mesh->mNumFaces; ++f)
+        for (unsigned int k = 0; k < mesh->mFaces[f].mNumIndices; ++k)
+            out.indices.push_back(mesh->mFaces[f].mIndices[k]);
+
+    // Bones get ids in the order they are first seen, as learnopengl's Model
+    // numbers them; a vertex keeps its first MAX_SKIN_INFLUENCES weights
+    for (unsigned int b = 0; b < mesh->mNumBones; ++b)
+    {
+        const aiBone* bone = mesh->mBones[b];
+        auto it = model.bones.find(bone->mName.C_Str());
+        if (it == model.bones.end())
+        {
+            BoneInfo info;
+            info.id = (int)model.bones.size();
+            info.offset = aiToGlm(bone->mOffsetMatrix);
+            it = model.bones.emplace(bone->mName.C_Str(), info).first;
+        }
+        for (unsigned int w = 0; w < bone->mNumWeights; ++w)
+        {
+            unsigned int id = bone->mWeights[w].mVertexId;
+            if (id >= out.vertices.size())
+                continue;
+            SkinnedVertex& vertex = out.vertices[id];
+            for (int k = 0; k < MAX_SKIN_INFLUENCES; ++k)
+                if (vertex.boneIds[k] < 0)
+                {
+                    vertex.boneIds[k] = it->second.id;
+                    vertex.weights[k] = bone->mWeights[w].mWeight;
+                    break;
+                }
+        }
+    }
+
+    const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+    aiString texture;
+    if (material->GetTextureCount(aiTextureType_DIFFUSE) > 0 &&
+        material->GetTexture(aiTextureType_DIFFUSE, 0, &texture) == aiReturn_SUCCESS)
+        out.diffusePath = directory + "/" + texture.C_Str();
+
+    model.meshes.push_back(std::move(out));
+}
+
+// Every mesh of an imported scene with its skin weights, in node order, and
+// the bone map. Textures are only named ('directory' + the material's
+// path): the game uploads them through its TextureCache and the cook tool
+// converts them, so nothing is decoded.
+inline void importModelScene(const aiScene* scene, const std::string& directory, ImportedModel& out)
+{
+    out.meshes.clear();
+    out.bones.clear();
+    std::vector<const aiNode*> stack(1, scene->mRootNode);
+    while (!stack.empty())
+    {
+        const aiNode* node = stack.back();
+        stack.pop_back();
+        for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+            importMesh(scene->mMeshes[node->mMeshes[i]], scene, directory, out);
+        for (int c = (int)node->mNumChildren - 1; c >= 0; --c)
+            stack.push_back(node->mChildren[c]);
+    }
+}
+
+// Reads 'path' for its meshes only. The game goes through AssetRegistry
+// (asset_registry.h), which takes everything it needs from one import.
+inline bool importSkinnedModel(const std::string& path, ImportedModel& out)
+{
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace);
+    if (!scene || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || !scene->mRootNode)
+    {
+        std::cout << "ERROR::ASSIMP:: could not load " << path << std::endl;
+        return false;
+    }
+    importModelScene(scene, path.substr(0, path.find_last_of('/')), out);
+    return true;
+}
+
+#endif
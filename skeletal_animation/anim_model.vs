@@ -14,7 +14,10 @@ uniform mat4 model;
 
 const int MAX_BONES = 100;
 const int MAX_BONE_INFLUENCE = 4;
-uniform mat4 finalBonesMatrices[MAX_BONES];
+// filled from the per-frame stream buffer, one range per skinned instance
+layout(std140) uniform BonePalette {
+    mat4 finalBonesMatrices[MAX_BONES];
+};
 
 out vec2 TexCoords;
 
@@ -32,9 +35,12 @@ void main()
         }
         vec4 localPosition = finalBonesMatrices[boneIds[i]] * vec4(pos,1.0f);
         totalPosition += localPosition * weights[i];
-        vec3 localNormal = mat3(finalBonesMatrices[boneIds[i]]) * norm;
    }
 	
+    // Vertices without any weight stay in bind pose, as in anim_model_dq.vs
+    if(totalPosition.w <= 0.0f)
+        totalPosition = vec4(pos,1.0f);
+
     mat4 viewModel = view * model;
     gl_Position =  projection * viewModel * totalPosition;
 	TexCoords = tex;
@@ -0,0 +1,76 @@
+#version 330 core
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec3 norm;
+layout(location = 2) in vec2 tex;
+layout(location = 3) in vec3 tangent;
+layout(location = 4) in vec3 bitangent;
+layout(location = 5) in ivec4 boneIds;
+layout(location = 6) in vec4 weights;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+
+const int MAX_BONES = 100;
+const int MAX_BONE_INFLUENCE = 4;
+// filled from the per-frame stream buffer, one range per skinned instance:
+// bone i is the unit dual quaternion (real, dual) at [2i], [2i + 1] (dual_quat.h)
+layout(std140) uniform BonePalette {
+    vec4 boneDualQuats[MAX_BONES * 2];
+};
+
+out vec2 TexCoords;
+
+void main()
+{
+    // Every rotation is turned into the hemisphere of the largest influence,
+    // so the two signs of one rotation do not cancel out. Slots without
+    // weight are skipped (compact vertices fill unused ones with bone 0).
+    int reference = -1;
+    bool bindPose = false;
+    for(int i = 0 ; i < MAX_BONE_INFLUENCE ; i++)
+    {
+        if(boneIds[i] == -1 || weights[i] <= 0.0f)
+            continue;
+        if(boneIds[i] >= MAX_BONES)
+        {
+            bindPose = true;
+            break;
+        }
+        if(reference == -1 || weights[i] > weights[reference])
+            reference = i;
+    }
+
+    vec4 real = vec4(0.0f);
+    vec4 dual = vec4(0.0f);
+    if(!bindPose && reference != -1)
+    {
+        vec4 first = boneDualQuats[boneIds[reference] * 2];
+        for(int i = 0 ; i < MAX_BONE_INFLUENCE ; i++)
+        {
+            if(boneIds[i] == -1 || weights[i] <= 0.0f)
+                continue;
+            vec4 boneReal = boneDualQuats[boneIds[i] * 2];
+            vec4 boneDual = boneDualQuats[boneIds[i] * 2 + 1];
+            float w = dot(boneReal, first) < 0.0f ? -weights[i] : weights[i];
+            real += boneReal * w;
+            dual += boneDual * w;
+        }
+    }
+
+    // No influences (or a bone out of range): bind pose, as in anim_model.vs
+    vec3 skinned = pos;
+    float len = length(real);
+    if(!bindPose && len > 1e-6f)
+    {
+        real /= len;
+        dual /= len;
+        skinned += 2.0f * cross(real.xyz, cross(real.xyz, pos) + real.w * pos);
+        skinned += 2.0f * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+    }
+
+    mat4 viewModel = view * model;
+    gl_Position =  projection * viewModel * vec4(skinned, 1.0f);
+    TexCoords = tex;
+}
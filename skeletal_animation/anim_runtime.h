@@ -0,0 +1,204 @@
+#ifndef ANIM_RUNTIME_H
+#define ANIM_RUNTIME_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// Skeletal animation runtime that does not touch GL or Assimp.
+//
+// The learnopengl Animator walks the node tree recursively every update,
+// copying node names and the whole bone map per node, so every frame it
+// allocates. Here the hierarchy is flattened once at load time (parents
+// before children) and clips store one track per joint, so an update is two
+// linear passes over preallocated arrays.
+
+const int MAX_SKIN_BONES = 100;   // must match MAX_BONES in anim_model.vs
+
+struct SkeletonJoint {
+    std::string name;
+    int parent;             // index into Skeleton::joints, -1 for the root
+    glm::mat4 bindLocal;    // node transform used when a clip has no track for it
+    int boneId;             // index into the bone palette, -1 if no vertex uses it
+    glm::mat4 offset;       // inverse bind matrix for boneId
+};
+
+struct Skeleton {
+    std::vector<SkeletonJoint> joints;
+    int boneCount = 0;      // palette entries actually referenced (max boneId + 1)
+
+    int findJoint(const std::string& name) const
+    {
+        for (int i = 0; i < (int)joints.size(); ++i)
+            if (joints[i].name == name)
+                return i;
+        return -1;
+    }
+};
+
+struct KeyPosition {
+    glm::vec3 value;
+    float time;
+};
+
+struct KeyRotation {
+    glm::quat value;
+    float time;
+};
+
+struct KeyScale {
+    glm::vec3 value;
+    float time;
+};
+
+struct JointTrack {
+    std::vector<KeyPosition> positions;
+    std::vector<KeyRotation> rotations;
+    std::vector<KeyScale> scales;
+};
+
+struct AnimClip {
+    std::string name;
+    float duration = 0.0f;          // in ticks
+    float ticksPerSecond = 25.0f;
+    std::vector<int> trackOfJoint;  // per skeleton joint, -1 = use bindLocal
+    std::vector<JointTrack> tracks;
+};
+
+// Key index for 'time', starting the search at the last used key. Playback
+// moves forward almost every call so this is O(1) amortized instead of the
+// linear scan from key 0 that the learnopengl Bone does.
+template<class Key>
+inline int findKey(const std::vector<Key>& keys, float time, int& cursor)
+{
+    int last = (int)keys.size() - 2;
+    if (cursor > last || cursor < 0 || keys[cursor].time > time)
+        cursor = 0;
+    while (cursor < last && keys[cursor + 1].time <= time)
+        cursor++;
+    return cursor;
+}
+
+inline float keyFactor(float t0, float t1, float time)
+{
+    float span = t1 - t0;
+    if (span <= 0.0f)
+        return 0.0f;
+    return glm::clamp((time - t0) / span, 0.0f, 1.0f);
+}
+
+inline glm::vec3 samplePosition(const std::vector<KeyPosition>& keys, float time, int& cursor)
+{
+    if (keys.size() == 1)
+        return keys[0].value;
+    int i = findKey(keys, time, cursor);
+    return glm::mix(keys[i].value, keys[i + 1].value, keyFactor(keys[i].time, keys[i + 1].time, time));
+}
+
+inline glm::quat sampleRotation(const std::vector<KeyRotation>& keys, float time, int& cursor)
+{
+    if (keys.size() == 1)
+        return glm::normalize(keys[0].value);
+    int i = findKey(keys, time, cursor);
+    return glm::normalize(glm::slerp(keys[i].value, keys[i + 1].value, keyFactor(keys[i].time, keys[i + 1].time, time)));
+}
+
+inline glm::vec3 sampleScale(const std::vector<KeyScale>& keys, float time, int& cursor)
+{
+    if (keys.size() == 1)
+        return keys[0].value;
+    int i = findKey(keys, time, cursor);
+    return glm::mix(keys[i].value, keys[i + 1].value, keyFactor(keys[i].time, keys[i + 1].time, time));
+}
+
+// Local transform of one joint at 'time' (ticks), T * R * S like the
+// learnopengl Bone::Update
+inline glm::mat4 sampleJoint(const AnimClip& clip, const SkeletonJoint& joint, int jointIndex, float time, int* cursors)
+{
+    int track = clip.trackOfJoint[jointIndex];
+    if (track < 0)
+        return joint.bindLocal;
+
+    const JointTrack& t = clip.tracks[track];
+    glm::mat4 local(1.0f);
+    if (!t.positions.empty())
+        local = glm::translate(local, samplePosition(t.positions, time, cursors[0]));
+    if (!t.rotations.empty())
+        local = local * glm::mat4_cast(sampleRotation(t.rotations, time, cursors[1]));
+    if (!t.scales.empty())
+        local = glm::scale(local, sampleScale(t.scales, time, cursors[2]));
+    return local;
+}
+
+// Drop-in replacement for the learnopengl Animator (same method names) that
+// allocates only in its constructor.
+class SkeletalAnimator {
+public:
+    SkeletalAnimator(const Skeleton* skeleton, const AnimClip* clip)
+        : m_Skeleton(skeleton), m_CurrentAnimation(clip), m_CurrentTime(0.0f)
+    {
+        m_FinalBoneMatrices.assign(MAX_SKIN_BONES, glm::mat4(1.0f));
+        m_Globals.assign(skeleton->joints.size(), glm::mat4(1.0f));
+        m_Cursors.assign(skeleton->joints.size() * 3, 0);
+    }
+
+    void PlayAnimation(const AnimClip* clip)
+    {
+        m_CurrentAnimation = clip;
+        m_CurrentTime = 0.0f;
+        std::fill(m_Cursors.begin(), m_Cursors.end(), 0);
+    }
+
+    void UpdateAnimation(float dt)
+    {
+        if (!m_CurrentAnimation)
+            return;
+        AdvanceTime(dt);
+        EvaluatePose();
+    }
+
+    // Only moves the clock (for simulation that never renders the pose)
+    void AdvanceTime(float dt)
+    {
+        if (!m_CurrentAnimation || m_CurrentAnimation->duration <= 0.0f)
+            return;
+        m_CurrentTime += m_CurrentAnimation->ticksPerSecond * dt;
+        m_CurrentTime = std::fmod(m_CurrentTime, m_CurrentAnimation->duration);
+    }
+
+    void EvaluatePose()
+    {
+        const std::vector<SkeletonJoint>& joints = m_Skeleton->joints;
+        for (int j = 0; j < (int)joints.size(); ++j)
+        {
+            const SkeletonJoint& joint = joints[j];
+            glm::mat4 local = sampleJoint(*m_CurrentAnimation, joint, j, m_CurrentTime, &m_Cursors[j * 3]);
+            m_Globals[j] = joint.parent < 0 ? local : m_Globals[joint.parent] * local;
+            if (joint.boneId >= 0 && joint.boneId < MAX_SKIN_BONES)
+                m_FinalBoneMatrices[joint.boneId] = m_Globals[j] * joint.offset;
+        }
+    }
+
+    const std::vector<glm::mat4>& GetFinalBoneMatrices() const { return m_FinalBoneMatrices; }
+    const AnimClip* GetCurrentAnimation() const { return m_CurrentAnimation; }
+    const Skeleton* GetSkeleton() const { return m_Skeleton; }
+    float GetCurrentTime() const { return m_CurrentTime; }
+
+    // Palette entries worth uploading
+    int GetBoneCount() const { return std::min(m_Skeleton->boneCount, MAX_SKIN_BONES); }
+
+private:
+    const Skeleton* m_Skeleton;
+    const AnimClip* m_CurrentAnimation;
+    float m_CurrentTime;
+    std::vector<glm::mat4> m_FinalBoneMatrices;
+    std::vector<glm::mat4> m_Globals;
+    std::vector<int> m_Cursors;     // position / rotation / scale key cursor per joint
+};
+
+#endif
@@ -0,0 +1,315 @@
+#ifndef ASSET_REGISTRY_H
+#define ASSET_REGISTRY_H
+
+#include "anim_import.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Every asset file is read by Assimp once, however often it is asked for.
+// Identical hierarchies are kept once, so all clips of a Mixamo character
+// play on its skeleton as is. releaseUnused() drops what only the registry
+// still holds.
+
+typedef std::shared_ptr<const ImportedModel> ModelHandle;
+typedef std::shared_ptr<const Skeleton> SkeletonHandle;
+typedef std::shared_ptr<const AnimClip> ClipHandle;
+
+class AssetRegistry {
+public:
+    // Meshes and bone map of 'path'. Null when it could not be imported.
+    ModelHandle model(const std::string& path)
+    {
+        m_Requests++;
+        File* file = find(path, true);
+        return file ? file->model : nullptr;
+    }
+
+    // The hierarchy in 'rigPath' bound to the bones of 'model': the skeleton
+    // its clips are played on. The same model and rig give the same skeleton.
+    SkeletonHandle skeleton(const ModelHandle& model, const std::string& rigPath)
+    {
+        m_Requests++;
+        File* file = find(rigPath, false);
+        if (!file || !model)
+            return nullptr;
+        for (const Binding& binding : m_Skeletons)
+            if (binding.model == model.get() && binding.rig == file->rig)
+                return binding.skeleton;
+
+        std::shared_ptr<Skeleton> skeleton = std::make_shared<Skeleton>(*file->rig);
+        skeleton->boneCount = 0;
+        for (SkeletonJoint& joint : skeleton->joints)
+        {
+            auto it = model->bones.find(joint.name);
+            if (it == model->bones.end())
+                continue;
+            joint.boneId = it->second.id;
+            joint.offset = it->second.offset;
+            skeleton->boneCount = std::max(skeleton->boneCount, joint.boneId + 1);
+        }
+        m_Skeletons.push_back({ model.get(), file->rig, skeleton });
+        return skeleton;
+    }
+
+    // First animation in 'path', for 'skeleton'
+    ClipHandle clip(const std::string& path, const SkeletonHandle& skeleton)
+    {
+        m_Requests++;
+        File* file = find(path, false);
+        if (!file || !file->clip || !skeleton)
+        {
+            if (file && !file->clip)
+                std::cout << "ERROR::ANIMATION: " << path << " has no animation" << std::endl;
+            return nullptr;
+        }
+
+        const Binding* binding = nullptr;
+        for (const Binding& b : m_Skeletons)
+            if (b.skeleton == skeleton)
+                binding = &b;
+        if (binding && (binding->rig == file->rig || sameJoints(*binding->rig, *file->rig)))
+        {
+            m_SharedClips++;
+            return file->clip;
+        }
+
+        // Another rig: same tracks, joints looked up by name
+        std::shared_ptr<AnimClip> clip = std::make_shared<AnimClip>(*file->clip);
+        clip->trackOfJoint.assign(skeleton->joints.size(), -1);
+        for (size_t j = 0; j < file->rig->joints.size(); ++j)
+        {
+            int joint = skeleton->findJoint(file->rig->joints[j].name);
+            if (joint >= 0)
+                clip->trackOfJoint[joint] = file->clip->trackOfJoint[j];
+        }
+        m_RemappedClips.push_back(clip);
+        return clip;
+    }
+
+    // Drops every model, clip and skeleton nobody else holds, and the files
+    // and rigs left with nothing in use
+    void releaseUnused()
+    {
+        for (auto it = m_Files.begin(); it != m_Files.end();)
+        {
+            File& file = it->second;
+            if (file.model.use_count() == 1)
+            {
+                m_ReleasedBytes += modelBytes(*file.model);
+                forgetBindings(file.model.get());
+                file.model.reset();
+            }
+            if (file.clip.use_count() == 1)
+                file.clip.reset();
+            if (!file.model && !file.clip)
+                it = m_Files.erase(it);
+            else
+                ++it;
+        }
+        for (size_t i = 0; i < m_Skeletons.size();)
+        {
+            if (m_Skeletons[i].skeleton.use_count() == 1)
+                m_Skeletons.erase(m_Skeletons.begin() + i);
+            else
+                ++i;
+        }
+        for (size_t i = 0; i < m_RemappedClips.size();)
+        {
+            if (m_RemappedClips[i].use_count() == 1)
+                m_RemappedClips.erase(m_RemappedClips.begin() + i);
+            else
+                ++i;
+        }
+        for (size_t i = 0; i < m_Rigs.size();)
+        {
+            if (m_Rigs[i].use_count() == 1)
+                m_Rigs.erase(m_Rigs.begin() + i);
+            else
+                ++i;
+        }
+    }
+
+    // Import time per file, then what was shared and what is still resident,
+    // for the startup report
+    void printReport() const
+    {
+        float total = 0.0f;
+        for (const Import& import : m_Imports)
+        {
+            std::string name = import.path.size() > 40 ? "..." + import.path.substr(import.path.size() - 37) : import.path;
+            printf("[startup]   %-40s %-8s %7.2f ms\n", name.c_str(), import.what, import.ms);
+            total += import.ms;
+        }
+        printf("[startup]   %d asset requests, %d imports in %.2f ms; %d hierarchies read, %d kept (%.1f KB not duplicated)\n",
+            m_Requests, (int)m_Imports.size(), total, m_RigsRead, m_RigsKept, m_RigBytesSaved / 1024.0f);
+
+        size_t models = 0, skeletons = 0, clips = 0;
+        for (const auto& entry : m_Files)
+        {
+            if (entry.second.model)
+                models += modelBytes(*entry.second.model);
+            if (entry.second.clip)
+                clips += clipBytes(*entry.second.clip);
+        }
+        for (const ClipHandle& clip : m_RemappedClips)
+            clips += clipBytes(*clip);
+        for (const Binding& binding : m_Skeletons)
+            skeletons += skeletonBytes(*binding.skeleton);
+        for (const auto& rig : m_Rigs)
+            skeletons += skeletonBytes(*rig);
+        printf("[startup]   resident: %.1f KB meshes (%.1f KB released after upload), %.1f KB skeletons, %.1f KB clips; %d of %d clips shared as is\n",
+            models / 1024.0f, m_ReleasedBytes / 1024.0f, skeletons / 1024.0f, clips / 1024.0f,
+            m_SharedClips, m_SharedClips + (int)m_RemappedClips.size());
+    }
+
+private:
+    struct File {
+        std::shared_ptr<const ImportedModel> model;     // only when imported as a model
+        std::shared_ptr<const Skeleton> rig;            // hierarchy, no bone ids
+        std::shared_ptr<const AnimClip> clip;           // on 'rig', null when the file has none
+    };
+
+    struct Binding {
+        const ImportedModel* model;
+        std::shared_ptr<const Skeleton> rig;
+        SkeletonHandle skeleton;
+    };
+
+    struct Import {
+        std::string path;
+        const char* what;       // model / clip / model+clip / rig
+        float ms;
+    };
+
+    // The file's entry, importing it when it has not been yet (or, for a
+    // model, only without its meshes). Null when Assimp cannot read it.
+    File* find(const std::string& path, bool needMeshes)
+    {
+        auto it = m_Files.find(path);
+        if (it != m_Files.end() && (!needMeshes || it->second.model))
+            return &it->second;
+
+        auto start = std::chrono::steady_clock::now();
+        Assimp::Importer importer;
+        unsigned int flags = needMeshes ? aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace : 0;
+        const aiScene* scene = importer.ReadFile(path, flags);
+        if (!scene || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || !scene->mRootNode)
+        {
+            std::cout << "ERROR::ASSIMP:: could not load " << path << std::endl;
+            return nullptr;
+        }
+
+        File& file = m_Files[path];
+        if (needMeshes)
+        {
+            std::shared_ptr<ImportedModel> model = std::make_shared<ImportedModel>();
+            importModelScene(scene, path.substr(0, path.find_last_of('/')), *model);
+            file.model = model;
+        }
+        if (!file.rig)
+        {
+            Skeleton rig;
+            importSkeleton(scene->mRootNode, {}, rig);
+            file.rig = shareRig(rig);
+        }
+        if (!file.clip && scene->mNumAnimations > 0)
+        {
+            std::shared_ptr<AnimClip> clip = std::make_shared<AnimClip>();
+            importClip(scene->mAnimations[0], *file.rig, *clip);
+            file.clip = clip;
+        }
+
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_Imports.push_back({ path, needMeshes ? (file.clip ? "model+clip" : "model") : (file.clip ? "clip" : "rig"), ms });
+        return &file;
+    }
+
+    // The kept rig with exactly this hierarchy, or this one kept
+    std::shared_ptr<const Skeleton> shareRig(const Skeleton& rig)
+    {
+        m_RigsRead++;
+        for (const auto& kept : m_Rigs)
+            if (sameHierarchy(*kept, rig))
+            {
+                m_RigBytesSaved += skeletonBytes(rig);
+                return kept;
+            }
+        m_RigsKept++;
+        m_Rigs.push_back(std::make_shared<const Skeleton>(rig));
+        return m_Rigs.back();
+    }
+
+    // Same joints in the same order: a clip on one plays on the other
+    static bool sameJoints(const Skeleton& a, const Skeleton& b)
+    {
+        if (a.joints.size() != b.joints.size())
+            return false;
+        for (size_t i = 0; i < a.joints.size(); ++i)
+            if (a.joints[i].parent != b.joints[i].parent || a.joints[i].name != b.joints[i].name)
+                return false;
+        return true;
+    }
+
+    static bool sameHierarchy(const Skeleton& a, const Skeleton& b)
+    {
+        if (!sameJoints(a, b))
+            return false;
+        for (size_t i = 0; i < a.joints.size(); ++i)
+            if (a.joints[i].bindLocal != b.joints[i].bindLocal)
+                return false;
+        return true;
+    }
+
+    void forgetBindings(const ImportedModel* model)
+    {
+        // Skeletons stay valid; only the key goes, so a re-imported model
+        // at the same address cannot match them
+        for (Binding& binding : m_Skeletons)
+            if (binding.model == model)
+                binding.model = nullptr;
+    }
+
+    static size_t skeletonBytes(const Skeleton& skeleton)
+    {
+        size_t bytes = sizeof(Skeleton) + skeleton.joints.capacity() * sizeof(SkeletonJoint);
+        for (const SkeletonJoint& joint : skeleton.joints)
+            bytes += joint.name.capacity();
+        return bytes;
+    }
+
+    static size_t clipBytes(const AnimClip& clip)
+    {
+        size_t bytes = sizeof(AnimClip) + clip.trackOfJoint.capacity() * sizeof(int) + clip.tracks.capacity() * sizeof(JointTrack);
+        for (const JointTrack& track : clip.tracks)
+            bytes += track.positions.capacity() * sizeof(KeyPosition) + track.rotations.capacity() * sizeof(KeyRotation) +
+                track.scales.capacity() * sizeof(KeyScale);
+        return bytes;
+    }
+
+    static size_t modelBytes(const ImportedModel& model)
+    {
+        size_t bytes = sizeof(ImportedModel) + model.bones.size() * (sizeof(BoneInfo) + 64);
+        for (const ImportedMesh& mesh : model.meshes)
+            bytes += mesh.vertices.capacity() * sizeof(SkinnedVertex) + mesh.indices.capacity() * sizeof(unsigned int);
+        return bytes;
+    }
+
+    std::map<std::string, File> m_Files;
+    std::vector<std::shared_ptr<const Skeleton>> m_Rigs;
+    std::vector<Binding> m_Skeletons;
+    std::vector<ClipHandle> m_RemappedClips;
+    std::vector<Import> m_Imports;
+    int m_Requests = 0;
+    int m_RigsRead = 0;
+    int m_RigsKept = 0;
+    int m_SharedClips = 0;
+    size_t m_RigBytesSaved = 0;
+    size_t m_ReleasedBytes = 0;
+};
+
+#endif
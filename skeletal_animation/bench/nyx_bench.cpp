@@ -0,0 +1,724 @@
+// Microbenchmarks for the per-frame kernels of skeletal_animation.
+//
+// Only needs glm and Google Benchmark, no window or GL context:
+//
+//   g++ -O2 -std=c++17 -I.. -I<path to glm> nyx_bench.cpp -lbenchmark -lpthread -o nyx_bench
+//   ./nyx_bench
+//
+// Every benchmark runs at 10, 100, 1000 and 10000 enemies / bullets / glyphs /
+// matches / level boxes / vertices and reports a complexity fit. Results go to
+// nyx_bench.json (Google Benchmark JSON) unless --benchmark_out is given;
+// compare two runs with benchmark's tools/compare.py.
+
+#include <benchmark/benchmark.h>
+
+#include "anim_runtime.h"
+#include "dual_quat.h"
+#include "game_sim.h"
+#include "level.h"
+#include "match.h"
+#include "nav_field.h"
+#include "net_protocol.h"
+#include "text_layout.h"
+#include "vertex_format.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ==================== TEST DATA ====================
+const int BENCH_JOINTS = 65;        // about what a Mixamo character has
+const int BENCH_KEYS = 30;          // keys per channel
+
+// Deterministic filler values so every run sees the same data
+static float benchValue(int i)
+{
+    return (float)((i * 2654435761u) % 1000) / 1000.0f;
+}
+
+static void buildSkeleton(Skeleton& skeleton)
+{
+    skeleton.joints.resize(BENCH_JOINTS);
+    for (int i = 0; i < BENCH_JOINTS; ++i)
+    {
+        SkeletonJoint& joint = skeleton.joints[i];
+        joint.name = "joint" + std::to_string(i);
+        joint.parent = i == 0 ? -1 : (i - 1) / 2;
+        joint.bindLocal = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f, 0.0f));
+        joint.boneId = i;
+        joint.offset = glm::mat4(1.0f);
+    }
+    skeleton.boneCount = BENCH_JOINTS;
+}
+
+static void buildClip(const Skeleton& skeleton, AnimClip& clip)
+{
+    clip.name = "bench";
+    clip.duration = (float)(BENCH_KEYS - 1);
+    clip.ticksPerSecond = 30.0f;
+    clip.trackOfJoint.resize(skeleton.joints.size());
+    clip.tracks.resize(skeleton.joints.size());
+    for (int j = 0; j < (int)skeleton.joints.size(); ++j)
+    {
+        clip.trackOfJoint[j] = j;
+        JointTrack& track = clip.tracks[j];
+        for (int k = 0; k < BENCH_KEYS; ++k)
+        {
+            float t = (float)k;
+            int seed = j * BENCH_KEYS + k;
+            track.positions.push_back({ glm::vec3(benchValue(seed), benchValue(seed + 1), benchValue(seed + 2)), t });
+            glm::quat q = glm::angleAxis(benchValue(seed + 3) * 3.14159f, glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f)));
+            track.rotations.push_back({ q, t });
+            track.scales.push_back({ glm::vec3(1.0f), t });
+        }
+    }
+}
+
+struct AnimFixture {
+    Skeleton skeleton;
+    AnimClip clip;
+    AnimFixture()
+    {
+        buildSkeleton(skeleton);
+        buildClip(skeleton, clip);
+    }
+};
+
+static const AnimFixture& animFixture()
+{
+    static AnimFixture fixture;
+    return fixture;
+}
+
+static std::vector<SkeletalAnimator> makeAnimators(int count)
+{
+    const AnimFixture& f = animFixture();
+    std::vector<SkeletalAnimator> animators;
+    animators.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        animators.emplace_back(&f.skeleton, &f.clip);
+        animators.back().AdvanceTime(benchValue(i));   // spread them over the clip
+    }
+    return animators;
+}
+
+// Targets on a grid around the origin, bullets in a band above them so no
+// bullet ever hits: every bullet is tested against every target.
+static void makeTargets(ecs::World& world, int count)
+{
+    Hitbox hitbox;
+    hitbox.min = glm::vec3(-0.3f, 0.0f, -0.3f);
+    hitbox.max = glm::vec3(0.3f, 1.5f, 0.3f);
+    hitbox.scale = glm::vec3(0.6f);
+    for (int i = 0; i < count; ++i)
+    {
+        glm::vec3 position((benchValue(i) - 0.5f) * 30.0f, 0.1f, (benchValue(i + 7) - 0.5f) * 30.0f);
+        createTarget(world, position, 1.2f, hitbox, AnimationState{ nullptr, nullptr });
+    }
+}
+
+static void makeBullets(ProjectileRing& bullets, int count)
+{
+    bullets.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        glm::vec3 position((benchValue(i + 3) - 0.5f) * 30.0f, 5.0f, (benchValue(i + 11) - 0.5f) * 30.0f);
+        glm::vec3 direction = glm::normalize(glm::vec3(benchValue(i) - 0.5f, 0.0f, benchValue(i + 1) - 0.5f) + glm::vec3(0.01f, 0.0f, 0.0f));
+        createBullet(bullets, position, direction, 15.0f, 0);     // fired on tick 0, stepped at tick 0: never expire
+    }
+}
+
+// arena.lvl, built in code so the benchmarks do not depend on the working
+// directory
+static void buildArena(Level& level)
+{
+    const glm::vec3 wallColor(0.2f);
+    level.clear();
+    level.addBox(glm::vec3(-15.0f, -0.1f, -15.0f), glm::vec3(15.0f, 0.1f, 15.0f), glm::vec3(0.4f));
+    level.addBox(glm::vec3(-15.0f, 0.0f, -15.1f), glm::vec3(15.0f, 2.0f, -14.9f), wallColor);
+    level.addBox(glm::vec3(-15.0f, 0.0f, 14.9f), glm::vec3(15.0f, 2.0f, 15.1f), wallColor);
+    level.addBox(glm::vec3(-15.1f, 0.0f, -15.0f), glm::vec3(-14.9f, 2.0f, 15.0f), wallColor);
+    level.addBox(glm::vec3(14.9f, 0.0f, -15.0f), glm::vec3(15.1f, 2.0f, 15.0f), wallColor);
+    const glm::vec3 coverColor(0.3f, 0.25f, 0.2f);
+    level.addBox(glm::vec3(-8.0f, 0.0f, -8.0f), glm::vec3(-3.0f, 1.5f, -7.5f), coverColor);
+    level.addBox(glm::vec3(3.0f, 0.0f, 7.5f), glm::vec3(8.0f, 1.5f, 8.0f), coverColor);
+    level.addBox(glm::vec3(7.5f, 0.0f, -8.0f), glm::vec3(8.0f, 1.5f, -3.0f), coverColor);
+    level.addBox(glm::vec3(-8.0f, 0.0f, 3.0f), glm::vec3(-7.5f, 1.5f, 8.0f), coverColor);
+    level.setSpawnArea(-12.0f, -12.0f, 12.0f, 12.0f);
+    level.build();
+}
+
+static const Level& benchArena()
+{
+    static Level arena;
+    if (arena.boxes().empty())
+        buildArena(arena);
+    return arena;
+}
+
+static const NavGrid& benchNav()
+{
+    static NavGrid nav;
+    if (nav.cellCount() == 0)
+        buildTargetNav(nav, benchArena());
+    return nav;
+}
+
+// ==================== ANIMATION ====================
+static void BM_AnimatorUpdate(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+    std::vector<SkeletalAnimator> animators = makeAnimators(count);
+    for (auto _ : state)
+    {
+        for (SkeletalAnimator& animator : animators)
+            animator.UpdateAnimation(1.0f / 60.0f);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_AnimatorUpdate)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond)->Complexity();
+
+// Pose evaluation plus copying every palette into one contiguous buffer, the
+// data a per-frame bone upload has to produce
+static void BM_BonePalette(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+    std::vector<SkeletalAnimator> animators = makeAnimators(count);
+    std::vector<glm::mat4> staging((size_t)count * MAX_SKIN_BONES);
+    for (auto _ : state)
+    {
+        glm::mat4* out = staging.data();
+        for (SkeletalAnimator& animator : animators)
+        {
+            animator.EvaluatePose();
+            int bones = animator.GetBoneCount();
+            std::memcpy(out, animator.GetFinalBoneMatrices().data(), bones * sizeof(glm::mat4));
+            out += bones;
+        }
+        benchmark::DoNotOptimize(staging.data());
+        benchmark::ClobberMemory();
+    }
+    state.counters["palette_bytes"] = (double)(MAX_SKIN_BONES * sizeof(glm::mat4));
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * count * BENCH_JOINTS * (int64_t)sizeof(glm::mat4));
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_BonePalette)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond)->Complexity();
+
+// Largest distance between a point skinned by a bone matrix and by the same
+// bone as a dual quaternion, over every posed bone of 'animators'. Both
+// paths must put a vertex with one influence in the same place.
+static float dualQuatError(const std::vector<SkeletalAnimator>& animators)
+{
+    const glm::vec3 points[] = { glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.5f, -0.5f), glm::vec3(-2.0f, 0.3f, 1.0f) };
+    float error = 0.0f;
+    for (const SkeletalAnimator& animator : animators)
+        for (int bone = 0; bone < animator.GetBoneCount(); ++bone)
+        {
+            const glm::mat4& matrix = animator.GetFinalBoneMatrices()[bone];
+            DualQuat palette[1] = { toDualQuat(matrix) };
+            int id = 0;
+            float weight = 1.0f;
+            DualQuat blended;
+            if (!blendDualQuats(palette, &id, &weight, 1, blended))
+                return 1e30f;
+            for (const glm::vec3& p : points)
+                error = std::max(error, glm::length(glm::vec3(matrix * glm::vec4(p, 1.0f)) - transformPoint(blended, p)));
+        }
+    return error;
+}
+
+// BM_BonePalette writing dual quaternion palettes (anim_model_dq.vs), half
+// the bytes per instance. Fails when the conversion does not skin like the
+// matrices do.
+static void BM_DualQuatPalette(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+    std::vector<SkeletalAnimator> animators = makeAnimators(count);
+    for (SkeletalAnimator& animator : animators)
+        animator.EvaluatePose();
+    float error = dualQuatError(animators);
+    if (error > 1e-3f)
+    {
+        state.SkipWithError("dual quaternions do not match the bone matrices");
+        return;
+    }
+
+    std::vector<DualQuat> staging((size_t)count * MAX_SKIN_BONES);
+    for (auto _ : state)
+    {
+        DualQuat* out = staging.data();
+        for (SkeletalAnimator& animator : animators)
+        {
+            animator.EvaluatePose();
+            int bones = animator.GetBoneCount();
+            toDualQuats(animator.GetFinalBoneMatrices().data(), bones, out);
+            out += bones;
+        }
+        benchmark::DoNotOptimize(staging.data());
+        benchmark::ClobberMemory();
+    }
+    state.counters["max_error"] = error;
+    state.counters["palette_bytes"] = (double)(MAX_SKIN_BONES * sizeof(DualQuat));
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * count * BENCH_JOINTS * (int64_t)sizeof(DualQuat));
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_DualQuatPalette)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond)->Complexity();
+
+// ==================== SKINNED VERTICES ====================
+// N vertices spread over the bench rig, one to four influences each
+static void makeSkinnedVertices(int count, std::vector<SkinnedVertex>& vertices)
+{
+    vertices.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        SkinnedVertex& v = vertices[i];
+        v.position = glm::vec3(benchValue(i) - 0.5f, benchValue(i + 1) * 2.0f, benchValue(i + 2) - 0.5f);
+        v.normal = glm::normalize(glm::vec3(benchValue(i + 3) - 0.5f, benchValue(i + 4) - 0.5f, benchValue(i + 5) - 0.5f) + glm::vec3(0.0f, 0.01f, 0.0f));
+        v.texCoords = glm::vec2(benchValue(i + 6), benchValue(i + 7));
+        v.tangent = v.bitangent = glm::vec3(0.0f);
+        int influences = 1 + i % MAX_SKIN_INFLUENCES;
+        float total = 0.0f;
+        for (int k = 0; k < MAX_SKIN_INFLUENCES; ++k)
+        {
+            v.boneIds[k] = k < influences ? (i + k * 7) % BENCH_JOINTS : -1;
+            v.weights[k] = k < influences ? 0.1f + benchValue(i + 8 + k) : 0.0f;
+            total += v.weights[k];
+        }
+        for (int k = 0; k < influences; ++k)
+            v.weights[k] /= total;
+    }
+}
+
+static bool layoutVertices(const std::vector<SkinnedVertex>& in, std::vector<SkinnedVertex>& out)
+{
+    out = in;
+    return true;
+}
+
+static bool layoutVertices(const std::vector<SkinnedVertex>& in, std::vector<CompactSkinnedVertex>& out)
+{
+    return packCompactVertices(in, out);
+}
+
+// anim_model.vs per vertex: the bone matrices blended by weight, applied to
+// the position
+static glm::vec3 skinVertex(const glm::mat4* palette, const SkinnedVertex& v)
+{
+    glm::vec4 total(0.0f);
+    for (int k = 0; k < MAX_SKIN_INFLUENCES; ++k)
+        if (v.boneIds[k] >= 0)
+            total += palette[v.boneIds[k]] * glm::vec4(v.position, 1.0f) * v.weights[k];
+    return glm::vec3(total);
+}
+
+static glm::vec3 skinVertex(const glm::mat4* palette, const CompactSkinnedVertex& v)
+{
+    glm::vec4 total(0.0f);
+    for (int k = 0; k < MAX_SKIN_INFLUENCES; ++k)
+        total += palette[v.boneIds[k]] * glm::vec4(v.position, 1.0f) * (v.weights[k] / 255.0f);
+    return glm::vec3(total);
+}
+
+// Largest distance a vertex moved by being packed, skinned with 'palette';
+// false when packed weights do not add up to one
+static bool compactError(const std::vector<SkinnedVertex>& full, const std::vector<CompactSkinnedVertex>& compact,
+    const glm::mat4* palette, float& position)
+{
+    position = 0.0f;
+    for (size_t i = 0; i < full.size(); ++i)
+    {
+        int sum = 0;
+        for (int k = 0; k < MAX_SKIN_INFLUENCES; ++k)
+            sum += compact[i].weights[k];
+        if (sum != 255)
+            return false;
+        position = std::max(position, glm::length(skinVertex(palette, full[i]) - skinVertex(palette, compact[i])));
+    }
+    return true;
+}
+
+// What the vertex stage fetches and does for N skinned vertices, on the CPU,
+// in the full and the compact layout (vertex_format.h). The compact run
+// fails when packing breaks the weights.
+template<class Vertex>
+static void BM_SkinVertices(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+    std::vector<SkinnedVertex> full;
+    makeSkinnedVertices(count, full);
+    std::vector<Vertex> vertices;
+    if (!layoutVertices(full, vertices))
+    {
+        state.SkipWithError("vertices do not fit the layout");
+        return;
+    }
+    std::vector<SkeletalAnimator> animators = makeAnimators(1);
+    animators[0].EvaluatePose();
+    const glm::mat4* palette = animators[0].GetFinalBoneMatrices().data();
+
+    std::vector<CompactSkinnedVertex> compact;
+    if (packCompactVertices(full, compact))
+    {
+        float position;
+        if (!compactError(full, compact, palette, position))
+        {
+            state.SkipWithError("compact vertices do not match the full ones");
+            return;
+        }
+        state.counters["max_compact_error"] = position;
+    }
+
+    std::vector<glm::vec3> skinned(count);
+    for (auto _ : state)
+    {
+        for (int i = 0; i < count; ++i)
+            skinned[i] = skinVertex(palette, vertices[i]);
+        benchmark::DoNotOptimize(skinned.data());
+        benchmark::ClobberMemory();
+    }
+    state.counters["bytes_per_vertex"] = (double)sizeof(Vertex);
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * count * (int64_t)sizeof(Vertex));
+    state.SetComplexityN(count);
+}
+BENCHMARK_TEMPLATE(BM_SkinVertices, SkinnedVertex)->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+BENCHMARK_TEMPLATE(BM_SkinVertices, CompactSkinnedVertex)->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+
+// ==================== COLLISION ====================
+// One test per bullet, against the target with the same index
+static void BM_BulletHitsTarget(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+    ecs::World world;
+    ProjectileRing bullets;
+    makeTargets(world, count);
+    makeBullets(bullets, count);
+    for (auto _ : state)
+    {
+        // The ring was filled from slot 0 and never wrapped
+        int hits = 0;
+        uint32_t slot = 0;
+        world.each<Transform, Hitbox>([&](const Transform& target, const Hitbox& hitbox) {
+            hits += pointInHitbox(bullets.position(slot++), target, hitbox) ? 1 : 0;
+        });
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_BulletHitsTarget)->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+
+// Full bullets x targets pass as the game runs it, with N of each
+static void BM_BulletTargetPass(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+    ecs::World world;
+    ProjectileRing bullets;
+    makeTargets(world, count);
+    makeBullets(bullets, count);
+    for (auto _ : state)
+    {
+        int kills = resolveBulletHits(world, bullets, [](ecs::Entity) {});
+        benchmark::DoNotOptimize(kills);
+    }
+    state.SetItemsProcessed(state.iterations() * count * (int64_t)count);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_BulletTargetPass)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond)->Complexity();
+
+static void BM_BulletUpdate(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+    ProjectileRing bullets;
+    makeBullets(bullets, count);
+    for (auto _ : state)
+    {
+        updateBullets(bullets, benchArena(), 0, 1.0f / 60.0f);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_BulletUpdate)->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+
+// Steady fire: N bullets alive, N / lifetime fired and N / lifetime expiring
+// every tick. Expiry only looks at the tail, so time per live bullet should
+// not depend on how fast they are fired.
+static void BM_BulletChurn(benchmark::State& state)
+{
+    const float dt = 1.0f / 60.0f;
+    int count = (int)state.range(0);
+    uint32_t lifetime = bulletLifetimeTicks(dt);
+    ProjectileRing bullets;
+    bullets.reserve(count + count / lifetime + 1);
+
+    uint32_t tick = 0;
+    int fired = 0;
+    auto step = [&]() {
+        tick++;
+        int due = (int)((uint64_t)count * tick / lifetime) - fired;
+        for (int i = 0; i < due; ++i, ++fired)
+        {
+            glm::vec3 direction = glm::normalize(glm::vec3(benchValue(fired) - 0.5f, 0.0f, benchValue(fired + 1) - 0.5f) + glm::vec3(0.01f, 0.0f, 0.0f));
+            createBullet(bullets, glm::vec3(0.0f, 5.0f, 0.0f), direction, 15.0f, tick);
+        }
+        updateBullets(bullets, benchArena(), tick, dt);
+    };
+    for (uint32_t i = 0; i < lifetime; ++i)
+        step();
+
+    for (auto _ : state)
+        step();
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_BulletChurn)->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+
+// ==================== CHASE ====================
+// N targets chasing a player who runs in circles around the cover, so the
+// flow field is recomputed whenever the player crosses into another cell.
+// Time per target should stay flat: the field's cost does not grow with N.
+static void BM_ChaseUpdate(benchmark::State& state)
+{
+    const float dt = 1.0f / 60.0f;
+    int count = (int)state.range(0);
+    ecs::World world;
+    makeTargets(world, count);
+    FlowField field;
+    field.init(benchNav());
+    int tick = 0;
+    for (auto _ : state)
+    {
+        float angle = tick++ * dt * CHARACTER_SPEED / 10.0f;
+        glm::vec3 player(std::cos(angle) * 10.0f, PLAYER_START.y, std::sin(angle) * 10.0f);
+        chaseTargets(world, benchArena(), field, &player, 1, dt);
+        benchmark::ClobberMemory();
+    }
+    state.counters["rebuilds_per_tick"] = (double)field.rebuilds() / tick;
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_ChaseUpdate)->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+
+// One flow field recompute over a level of N pillars on a grid, about 16 N
+// navigation cells, whatever the number of targets. The Dijkstra pass is
+// linear in cells (bucket queue); between pillars every open cell also
+// walks its line of sight to the goal, which adds up to N^1.5.
+static void BM_FlowFieldRebuild(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+    int side = (int)std::ceil(std::sqrt((float)count));
+    Level level;
+    level.addBox(glm::vec3(-side - 1.0f, -0.1f, -side - 1.0f), glm::vec3(side + 1.0f, 0.1f, side + 1.0f), glm::vec3(0.4f));
+    for (int i = 0; i < count; ++i)
+    {
+        glm::vec3 corner((i % side) * 2.0f - side, 0.0f, (i / side) * 2.0f - side);
+        level.addBox(corner, corner + glm::vec3(0.5f, 2.0f, 0.5f), glm::vec3(0.2f));
+    }
+    level.build();
+    NavGrid nav;
+    buildTargetNav(nav, level);
+    FlowField field;
+    field.init(nav);
+
+    // Alternate between two goals so every update is a rebuild
+    glm::vec3 goals[2] = { glm::vec3(-side + 1.0f, 0.1f, -side + 1.0f), glm::vec3(side - 0.5f, 0.1f, side - 0.5f) };
+    int i = 0;
+    for (auto _ : state)
+    {
+        field.update(&goals[i++ & 1], 1);
+        benchmark::ClobberMemory();
+    }
+    state.counters["cells"] = (double)nav.cellCount();
+    state.counters["blocked"] = (double)nav.blockedCount();
+    state.SetItemsProcessed(state.iterations() * nav.cellCount());
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_FlowFieldRebuild)->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+
+// ==================== LEVEL ====================
+// Bullet-sized segments against a level of N pillars on a grid. With the BVH
+// a segment only visits the few boxes near it, so time per segment should
+// grow with log N.
+static void BM_LevelSegment(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+    int side = (int)std::ceil(std::sqrt((float)count));
+    float extent = side * 2.0f;
+    Level level;
+    for (int i = 0; i < count; ++i)
+    {
+        glm::vec3 corner((i % side) * 2.0f - side, 0.0f, (i / side) * 2.0f - side);
+        level.addBox(corner, corner + glm::vec3(0.5f, 2.0f, 0.5f), glm::vec3(0.2f));
+    }
+    level.build();
+
+    const int SEGMENTS = 1024;
+    std::vector<glm::vec3> from(SEGMENTS), to(SEGMENTS);
+    for (int i = 0; i < SEGMENTS; ++i)
+    {
+        from[i] = glm::vec3((benchValue(i) - 0.5f) * extent, 0.9f, (benchValue(i + 5) - 0.5f) * extent);
+        to[i] = from[i] + glm::normalize(glm::vec3(benchValue(i + 1) - 0.5f, 0.0f, benchValue(i + 2) - 0.5f) + glm::vec3(0.01f, 0.0f, 0.0f)) * 0.25f;
+    }
+    for (auto _ : state)
+    {
+        int hits = 0;
+        for (int i = 0; i < SEGMENTS; ++i)
+            hits += level.segmentHits(from[i], to[i]) ? 1 : 0;
+        benchmark::DoNotOptimize(hits);
+    }
+    state.counters["nodes"] = (double)level.nodeCount();
+    state.SetItemsProcessed(state.iterations() * SEGMENTS);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_LevelSegment)->RangeMultiplier(10)->Range(10, 10000)->Complexity(benchmark::oLogN);
+
+// ==================== NETWORK ====================
+// Every target as the server would put it in a snapshot
+static void snapshotTargets(ecs::World& world, uint32_t tick, NetSnapshot& snapshot)
+{
+    snapshot.tick = tick;
+    snapshot.entities.clear();
+    world.eachEntity<Transform, Hitbox>([&](ecs::Entity entity, const Transform& t, const Hitbox&) {
+        NetEntity e = {};
+        e.id = (uint16_t)entity.index;
+        e.generation = (uint8_t)entity.generation;
+        e.type = NET_ENTITY_TARGET;
+        setNetPosition(e, t.position);
+        snapshot.entities.push_back(e);
+    });
+}
+
+// One snapshot interval: every target chased the player for 3 ticks and is
+// delta encoded against where it was. The byte budget caps the packet, so
+// bytes per snapshot should flatten out past a few hundred targets.
+static void BM_SnapshotDelta(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+    ecs::World world;
+    makeTargets(world, count);
+    glm::vec3 player(0.0f, 0.09f, 0.0f);
+
+    FlowField field;
+    field.init(benchNav());
+
+    NetSnapshot baseline, current;
+    snapshotTargets(world, 0, baseline);
+    for (int tick = 0; tick < 3; ++tick)
+        chaseTargets(world, benchArena(), field, &player, 1, 1.0f / 60.0f);
+    snapshotTargets(world, 3, current);
+
+    std::vector<uint8_t> packet;
+    packet.reserve(NET_MAX_PACKET);
+    SnapshotEncoder encoder;
+    for (auto _ : state)
+    {
+        writeSnapshotPacket(packet, current, &baseline, 0, encoder);
+        benchmark::DoNotOptimize(packet.data());
+    }
+    state.counters["bytes_per_snapshot"] = (double)packet.size();
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_SnapshotDelta)->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+
+// ==================== DEDICATED SERVER ====================
+// One tick of N headless matches (two bots each) on one thread, after ten
+// seconds of play so targets and bullets are in their steady state.
+// matches_per_core is how many such matches one core keeps at 60 Hz.
+static void BM_MatchTick(benchmark::State& state)
+{
+    const int hz = 60;
+    int count = (int)state.range(0);
+    std::vector<std::unique_ptr<Match>> matches;
+    for (int i = 0; i < count; ++i)
+    {
+        matches.emplace_back(new Match());
+        matches.back()->start(1 + i, 2, benchArena(), benchNav());
+        for (int tick = 0; tick < 10 * hz; ++tick)
+            matches.back()->tick(1.0f / hz);
+    }
+
+    for (auto _ : state)
+    {
+        for (std::unique_ptr<Match>& match : matches)
+            match->tick(1.0f / hz);
+        benchmark::ClobberMemory();
+    }
+    state.counters["matches_per_core"] = benchmark::Counter((double)state.iterations() * count / hz, benchmark::Counter::kIsRate);
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_MatchTick)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond)->Complexity();
+
+// ==================== TEXT ====================
+// RenderText's per-glyph quad math over a string of N printable characters
+static void BM_TextLayout(benchmark::State& state)
+{
+    int count = (int)state.range(0);
+
+    Character glyphs[128];
+    for (int c = 0; c < 128; ++c)
+    {
+        glyphs[c].Size = glm::ivec2(20 + c % 7, 30 + c % 5);
+        glyphs[c].Bearing = glm::ivec2(c % 3, 28 + c % 4);
+        glyphs[c].Advance = (unsigned int)((22 + c % 6) << 6);
+        glyphs[c].UvMin = glm::vec2((c % 16) / 16.0f, (c / 16) / 8.0f);
+        glyphs[c].UvMax = glyphs[c].UvMin + glm::vec2(1.0f / 16.0f, 1.0f / 8.0f);
+    }
+
+    std::string text(count, ' ');
+    for (int i = 0; i < count; ++i)
+        text[i] = (char)(32 + i % 95);
+
+    std::vector<float> vertices((size_t)count * 6 * 4);
+    for (auto _ : state)
+    {
+        float x = 10.0f;
+        float (*out)[4] = reinterpret_cast<float(*)[4]>(vertices.data());
+        for (const char* p = text.c_str(); *p; ++p)
+        {
+            x += layoutGlyph(glyphs[(unsigned char)*p], x, 300.0f, 0.8f, out);
+            out += 6;
+        }
+        benchmark::DoNotOptimize(vertices.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_TextLayout)->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+
+// Same as BENCHMARK_MAIN, but writes JSON to nyx_bench.json by default so
+// every run leaves something to diff against
+int main(int argc, char** argv)
+{
+    std::vector<char*> args(argv, argv + argc);
+    bool hasOut = false;
+    for (int i = 1; i < argc; ++i)
+        if (std::strncmp(argv[i], "--benchmark_out=", 16) == 0)
+            hasOut = true;
+
+    char outArg[] = "--benchmark_out=nyx_bench.json";
+    char formatArg[] = "--benchmark_out_format=json";
+    if (!hasOut)
+    {
+        args.push_back(outArg);
+        args.push_back(formatArg);
+    }
+
+    int count = (int)args.size();
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
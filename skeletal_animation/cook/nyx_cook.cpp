@@ -0,0 +1,139 @@
+// Asset cooking: converts model textures into cooked files (texture_file.h)
+// that the game maps and uploads without decoding. Needs assimp and
+// stb_image, no window or GL context:
+//
+//   g++ -O2 -std=c++17 -I.. -I<path to glm> -I<path to stb> nyx_cook.cpp -lassimp -o nyx_cook
+//   ./nyx_cook resources/objects/gun2/rifle.dae resources/objects/kid/running.dae
+//
+// A model argument cooks the diffuse texture of every mesh in it, the same
+// paths the game asks its TextureCache for; an image argument cooks that
+// image. Each cooked file goes next to its source, named source.nyxtex.
+// The header records the source's size and write time: files that still
+// match their source are skipped, and the game knows when one is stale.
+//
+//   --raw       RGBA8 mips instead of BC1 / BC3
+//   --force     cook even what is up to date
+//
+// Exits with 1 when any texture could not be read or written.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "anim_import.h"
+#include "texture_file.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+static bool upToDate(const std::string& source)
+{
+    MappedFile file;
+    TextureFileHeader header;
+    const TextureFileLevel* levels = nullptr;
+    uint64_t size = 0;
+    int64_t time = 0;
+    return file.open(cookedTexturePath(source)) && parseTextureFile(file.data(), file.size(), header, levels) &&
+        textureSourceStamp(source, size, time) && header.sourceSize == size && header.sourceTime == time;
+}
+
+static bool cookFile(const std::string& source, bool compress)
+{
+    static const char* const FORMAT_NAMES[] = { "rgba8", "bc1", "bc3" };
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    int width, height, components;
+    stbi_set_flip_vertically_on_load(true);     // GL's row order, so the game uploads as is
+    unsigned char* rgba = textureSourceStamp(source, sourceSize, sourceTime) ?
+        stbi_load(source.c_str(), &width, &height, &components, 4) : nullptr;
+    if (!rgba)
+    {
+        std::cout << "ERROR::COOK: could not read " << source << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> cooked;
+    cookTexture(rgba, (uint32_t)width, (uint32_t)height, compress, sourceSize, sourceTime, cooked);
+    stbi_image_free(rgba);
+    std::string path = cookedTexturePath(source);
+    if (!writeTextureFile(path, cooked))
+    {
+        std::cout << "ERROR::COOK: could not write " << path << std::endl;
+        return false;
+    }
+
+    TextureFileHeader header;
+    std::memcpy(&header, cooked.data(), sizeof(header));
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("[cook] %s: %dx%d %s, %u levels, %.1f KB (%.1f KB as RGBA8 without mips) in %.1f ms\n",
+        path.c_str(), width, height, FORMAT_NAMES[header.format], header.levels,
+        cooked.size() / 1024.0f, width * height * 4 / 1024.0f, ms);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    bool compress = true;
+    bool force = false;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--raw")
+            compress = false;
+        else if (std::string(argv[i]) == "--force")
+            force = true;
+        else if (argv[i][0] == '-')
+            std::cout << "Warning: unknown argument '" << argv[i] << "'" << std::endl;
+        else
+            inputs.push_back(argv[i]);
+    }
+    if (inputs.empty())
+    {
+        std::cout << "usage: nyx_cook [--raw] [--force] model-or-image..." << std::endl;
+        return 1;
+    }
+
+    // Every texture once, even when several meshes or models share it
+    std::set<std::string> sources;
+    bool ok = true;
+    for (const std::string& input : inputs)
+    {
+        int width, height, components;
+        if (stbi_info(input.c_str(), &width, &height, &components))
+        {
+            sources.insert(input);
+            continue;
+        }
+        ImportedModel model;
+        if (!importSkinnedModel(input, model))
+        {
+            ok = false;
+            continue;
+        }
+        for (const ImportedMesh& mesh : model.meshes)
+            if (!mesh.diffusePath.empty())
+                sources.insert(mesh.diffusePath);
+    }
+
+    int cooked = 0, skipped = 0;
+    for (const std::string& source : sources)
+    {
+        if (!force && upToDate(source))
+        {
+            skipped++;
+            continue;
+        }
+        if (cookFile(source, compress))
+            cooked++;
+        else
+            ok = false;
+    }
+    printf("[cook] %d cooked, %d up to date, %d failed\n", cooked, skipped, (int)sources.size() - cooked - skipped);
+    return ok ? 0 : 1;
+}
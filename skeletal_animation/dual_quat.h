@@ -0,0 +1,85 @@
+#ifndef DUAL_QUAT_H
+#define DUAL_QUAT_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Bone palettes as unit dual quaternions for anim_model_dq.vs: half the
+// bytes of a mat4, and joints keep their volume when blended. Scale in a
+// bone matrix is dropped (rigidError() measures it).
+
+struct DualQuat {
+    glm::vec4 real;     // rotation quaternion, (x, y, z, w) as the shader reads it
+    glm::vec4 dual;     // half the translation times the rotation
+};
+
+inline DualQuat toDualQuat(const glm::mat4& m)
+{
+    glm::mat3 rotation(glm::normalize(glm::vec3(m[0])), glm::normalize(glm::vec3(m[1])), glm::normalize(glm::vec3(m[2])));
+    glm::quat r = glm::normalize(glm::quat_cast(rotation));
+    glm::vec3 t(m[3]);
+    glm::quat d = glm::quat(0.0f, t.x, t.y, t.z) * r * 0.5f;
+    return { glm::vec4(r.x, r.y, r.z, r.w), glm::vec4(d.x, d.y, d.z, d.w) };
+}
+
+// A palette of 'count' bones, written front to back ('out' may be mapped
+// buffer memory)
+inline void toDualQuats(const glm::mat4* matrices, int count, DualQuat* out)
+{
+    for (int i = 0; i < count; ++i)
+        out[i] = toDualQuat(matrices[i]);
+}
+
+// How far a matrix is from a rotation plus a translation: the largest
+// difference of an axis length from 1
+inline float rigidError(const glm::mat4& m)
+{
+    float error = 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+        error = std::max(error, std::abs(glm::length(glm::vec3(m[axis])) - 1.0f));
+    return error;
+}
+
+// The blend in anim_model_dq.vs: weighted sum with every quaternion turned
+// into the hemisphere of the largest influence, then normalized. Ids of -1
+// and weights of 0 are skipped. Returns false when nothing was blended (the
+// vertex stays in bind pose).
+inline bool blendDualQuats(const DualQuat* palette, const int* ids, const float* weights, int influences, DualQuat& out)
+{
+    int reference = -1;
+    for (int i = 0; i < influences; ++i)
+        if (ids[i] >= 0 && weights[i] > 0.0f && (reference < 0 || weights[i] > weights[reference]))
+            reference = i;
+    if (reference < 0)
+        return false;
+
+    glm::vec4 real(0.0f), dual(0.0f), first = palette[ids[reference]].real;
+    for (int i = 0; i < influences; ++i)
+    {
+        if (ids[i] < 0 || weights[i] <= 0.0f)
+            continue;
+        const DualQuat& bone = palette[ids[i]];
+        float w = glm::dot(bone.real, first) < 0.0f ? -weights[i] : weights[i];
+        real += bone.real * w;
+        dual += bone.dual * w;
+    }
+    float length = glm::length(real);
+    if (length < 1e-6f)
+        return false;
+    out.real = real / length;
+    out.dual = dual / length;
+    return true;
+}
+
+inline glm::vec3 transformPoint(const DualQuat& dq, const glm::vec3& p)
+{
+    glm::vec3 rv(dq.real), dv(dq.dual);
+    float rw = dq.real.w, dw = dq.dual.w;
+    glm::vec3 rotated = p + 2.0f * glm::cross(rv, glm::cross(rv, p) + rw * p);
+    return rotated + 2.0f * (rw * dv - dw * rv + glm::cross(rv, dv));
+}
+
+#endif
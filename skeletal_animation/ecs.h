@@ -0,0 +1,411 @@
+#ifndef ECS_H
+#define ECS_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Archetype ECS.
+//
+// Every distinct set of component types is an archetype. An archetype stores
+// its entities in fixed size chunks, each holding one tightly packed array
+// per component (plus the entity handles), so a query walks whole arrays
+// front to back:
+//
+//   chunk: | Entity[cap] | Transform[cap] | Velocity[cap] | Hitbox[cap] |
+//
+// Entities are kept dense: destroying one moves the archetype's last entity
+// into the hole. Chunks are never freed, so once the world has grown to its
+// peak, creating and destroying entities does not allocate.
+//
+// Components must be trivially copyable since they are moved with memcpy.
+// Entities may not be created or destroyed inside a query; use
+// destroyLater() and flush() afterwards.
+
+namespace ecs {
+
+const int MAX_COMPONENTS = 64;
+const size_t CHUNK_BYTES = 16 * 1024;
+
+typedef uint64_t ComponentMask;
+
+struct Entity {
+    uint32_t index;
+    uint32_t generation;
+
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+const Entity NULL_ENTITY = { 0xFFFFFFFFu, 0 };
+
+namespace detail {
+
+struct ComponentInfo {
+    size_t size;
+    size_t align;
+};
+
+inline std::vector<ComponentInfo>& componentInfos()
+{
+    static std::vector<ComponentInfo> infos;
+    return infos;
+}
+
+inline int registerComponent(size_t size, size_t align)
+{
+    std::vector<ComponentInfo>& infos = componentInfos();
+    assert(infos.size() < (size_t)MAX_COMPONENTS);
+    assert(align <= alignof(std::max_align_t));
+    infos.push_back({ size, align });
+    return (int)infos.size() - 1;
+}
+
+} // namespace detail
+
+// Dense id per component type, assigned on first use
+template<class T>
+inline int componentId()
+{
+    static_assert(std::is_trivially_copyable<T>::value, "components are moved with memcpy");
+    static const int id = detail::registerComponent(sizeof(T), alignof(T));
+    return id;
+}
+
+template<class... Cs>
+inline ComponentMask maskOf()
+{
+    return (ComponentMask(0) | ... | (ComponentMask(1) << componentId<Cs>()));
+}
+
+class World;
+
+class Archetype {
+public:
+    ComponentMask mask() const { return m_Mask; }
+    uint32_t size() const { return m_Count; }
+    uint32_t chunkCapacity() const { return m_Capacity; }
+    size_t chunkCount() const { return m_Chunks.size(); }
+
+private:
+    friend class World;
+    friend class ChunkView;
+
+    explicit Archetype(ComponentMask mask) : m_Mask(mask)
+    {
+        const std::vector<detail::ComponentInfo>& infos = detail::componentInfos();
+        for (int id = 0; id < (int)infos.size(); ++id)
+            if (mask & (ComponentMask(1) << id))
+                m_Components.push_back(id);
+
+        // Largest capacity whose aligned arrays still fit in one chunk
+        size_t perEntity = sizeof(Entity);
+        for (int id : m_Components)
+            perEntity += infos[id].size;
+        for (m_Capacity = (uint32_t)(CHUNK_BYTES / perEntity); m_Capacity > 1; --m_Capacity)
+            if (layout(m_Capacity) <= CHUNK_BYTES)
+                break;
+        layout(m_Capacity);
+    }
+
+    ~Archetype()
+    {
+        for (unsigned char* chunk : m_Chunks)
+            delete[] reinterpret_cast<std::max_align_t*>(chunk);
+    }
+
+    // Fills m_Offsets for 'capacity' entities per chunk, returns the bytes used
+    size_t layout(uint32_t capacity)
+    {
+        const std::vector<detail::ComponentInfo>& infos = detail::componentInfos();
+        size_t offset = sizeof(Entity) * capacity;
+        for (int id : m_Components)
+        {
+            offset = (offset + infos[id].align - 1) / infos[id].align * infos[id].align;
+            m_Offsets[id] = offset;
+            offset += infos[id].size * capacity;
+        }
+        return offset;
+    }
+
+    void addChunk()
+    {
+        m_Chunks.push_back(reinterpret_cast<unsigned char*>(new std::max_align_t[CHUNK_BYTES / sizeof(std::max_align_t)]));
+    }
+
+    Entity* entities(uint32_t chunk) { return reinterpret_cast<Entity*>(m_Chunks[chunk]); }
+    void* component(int id, uint32_t chunk, uint32_t row)
+    {
+        return m_Chunks[chunk] + m_Offsets[id] + row * detail::componentInfos()[id].size;
+    }
+
+    uint32_t rowsInChunk(uint32_t chunk) const
+    {
+        uint32_t first = chunk * m_Capacity;
+        return m_Count - first < m_Capacity ? m_Count - first : m_Capacity;
+    }
+
+    ComponentMask m_Mask;
+    std::vector<int> m_Components;
+    size_t m_Offsets[MAX_COMPONENTS] = {};
+    uint32_t m_Capacity = 1;
+    uint32_t m_Count = 0;
+    std::vector<unsigned char*> m_Chunks;
+};
+
+// One chunk of a query: 'size()' entities, one array per component
+class ChunkView {
+public:
+    ChunkView(Archetype* archetype, uint32_t chunk) : m_Archetype(archetype), m_Chunk(chunk) {}
+
+    uint32_t size() const { return m_Archetype->rowsInChunk(m_Chunk); }
+    Entity* entities() const { return m_Archetype->entities(m_Chunk); }
+
+    template<class T>
+    T* array() const
+    {
+        return static_cast<T*>(m_Archetype->component(componentId<T>(), m_Chunk, 0));
+    }
+
+private:
+    Archetype* m_Archetype;
+    uint32_t m_Chunk;
+};
+
+class World {
+public:
+    World() = default;
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    ~World()
+    {
+        for (Archetype* archetype : m_Archetypes)
+            delete archetype;
+    }
+
+    template<class... Cs>
+    Entity create(const Cs&... values)
+    {
+        Archetype& archetype = archetypeFor(maskOf<Cs...>());
+
+        uint32_t slot = archetype.m_Count;
+        uint32_t chunk = slot / archetype.m_Capacity;
+        uint32_t row = slot % archetype.m_Capacity;
+        if (chunk == archetype.m_Chunks.size())
+            archetype.addChunk();
+        archetype.m_Count++;
+
+        Entity entity;
+        if (!m_FreeRecords.empty())
+        {
+            entity.index = m_FreeRecords.back();
+            m_FreeRecords.pop_back();
+        }
+        else
+        {
+            entity.index = (uint32_t)m_Records.size();
+            m_Records.push_back(Record());
+        }
+        Record& record = m_Records[entity.index];
+        entity.generation = record.generation;
+        record.archetype = &archetype;
+        record.chunk = chunk;
+        record.row = row;
+
+        archetype.entities(chunk)[row] = entity;
+        ((*static_cast<Cs*>(archetype.component(componentId<Cs>(), chunk, row)) = values), ...);
+        m_Alive++;
+        return entity;
+    }
+
+    void destroy(Entity entity)
+    {
+        if (!alive(entity))
+            return;
+        Record& record = m_Records[entity.index];
+        Archetype& archetype = *record.archetype;
+
+        // Move the archetype's last entity into the hole
+        uint32_t last = archetype.m_Count - 1;
+        uint32_t lastChunk = last / archetype.m_Capacity;
+        uint32_t lastRow = last % archetype.m_Capacity;
+        if (lastChunk != record.chunk || lastRow != record.row)
+        {
+            const std::vector<detail::ComponentInfo>& infos = detail::componentInfos();
+            for (int id : archetype.m_Components)
+                std::memcpy(archetype.component(id, record.chunk, record.row),
+                    archetype.component(id, lastChunk, lastRow), infos[id].size);
+            Entity moved = archetype.entities(lastChunk)[lastRow];
+            archetype.entities(record.chunk)[record.row] = moved;
+            m_Records[moved.index].chunk = record.chunk;
+            m_Records[moved.index].row = record.row;
+        }
+        archetype.m_Count--;
+
+        record.archetype = nullptr;
+        record.generation++;
+        m_FreeRecords.push_back(entity.index);
+        m_Alive--;
+    }
+
+    bool alive(Entity entity) const
+    {
+        return entity.index < m_Records.size() &&
+            m_Records[entity.index].generation == entity.generation &&
+            m_Records[entity.index].archetype != nullptr;
+    }
+
+    // nullptr if the entity is gone or has no T. Only valid until the next
+    // create or destroy.
+    template<class T>
+    T* get(Entity entity)
+    {
+        if (!alive(entity))
+            return nullptr;
+        const Record& record = m_Records[entity.index];
+        int id = componentId<T>();
+        if (!(record.archetype->m_Mask & (ComponentMask(1) << id)))
+            return nullptr;
+        return static_cast<T*>(record.archetype->component(id, record.chunk, record.row));
+    }
+
+    // f(Cs&...) for every entity that has all of Cs
+    template<class... Cs, class F>
+    void each(F&& f)
+    {
+        eachChunk<Cs...>([&](const ChunkView& chunk) {
+            uint32_t n = chunk.size();
+            std::tuple<Cs*...> arrays(chunk.array<Cs>()...);
+            for (uint32_t i = 0; i < n; ++i)
+                f(std::get<Cs*>(arrays)[i]...);
+        });
+    }
+
+    // f(Entity, Cs&...)
+    template<class... Cs, class F>
+    void eachEntity(F&& f)
+    {
+        eachChunk<Cs...>([&](const ChunkView& chunk) {
+            uint32_t n = chunk.size();
+            Entity* entities = chunk.entities();
+            std::tuple<Cs*...> arrays(chunk.array<Cs>()...);
+            for (uint32_t i = 0; i < n; ++i)
+                f(entities[i], std::get<Cs*>(arrays)[i]...);
+        });
+    }
+
+    // f(const ChunkView&) for every non-empty chunk with all of Cs
+    template<class... Cs, class F>
+    void eachChunk(F&& f)
+    {
+        ComponentMask mask = maskOf<Cs...>();
+        for (Archetype* archetype : m_Archetypes)
+        {
+            if ((archetype->m_Mask & mask) != mask)
+                continue;
+            for (uint32_t c = 0; c * archetype->m_Capacity < archetype->m_Count; ++c)
+                f(ChunkView(archetype, c));
+        }
+    }
+
+    // Matching chunks as a list, for handing disjoint ranges to worker
+    // threads. Workers may write components but not create or destroy.
+    template<class... Cs>
+    void collectChunks(std::vector<ChunkView>& out)
+    {
+        out.clear();
+        eachChunk<Cs...>([&](const ChunkView& chunk) { out.push_back(chunk); });
+    }
+
+    template<class... Cs>
+    size_t count()
+    {
+        ComponentMask mask = maskOf<Cs...>();
+        size_t total = 0;
+        for (Archetype* archetype : m_Archetypes)
+            if ((archetype->m_Mask & mask) == mask)
+                total += archetype->m_Count;
+        return total;
+    }
+
+    // The i-th entity (0 <= i < count<Cs...>()) in iteration order
+    template<class... Cs>
+    Entity at(size_t i)
+    {
+        ComponentMask mask = maskOf<Cs...>();
+        for (Archetype* archetype : m_Archetypes)
+        {
+            if ((archetype->m_Mask & mask) != mask)
+                continue;
+            if (i < archetype->m_Count)
+                return archetype->entities((uint32_t)(i / archetype->m_Capacity))[i % archetype->m_Capacity];
+            i -= archetype->m_Count;
+        }
+        return NULL_ENTITY;
+    }
+
+    // Allocates chunks for 'entities' entities of exactly Cs up front
+    template<class... Cs>
+    void reserve(size_t entities)
+    {
+        Archetype& archetype = archetypeFor(maskOf<Cs...>());
+        while (archetype.m_Chunks.size() * archetype.m_Capacity < entities)
+            archetype.addChunk();
+        if (m_Records.capacity() < m_Alive + entities)
+            m_Records.reserve(m_Alive + entities);
+        m_FreeRecords.reserve(m_Records.capacity());
+        m_Pending.reserve(m_Records.capacity());
+    }
+
+    // Deferred destroy, for use inside queries
+    void destroyLater(Entity entity) { m_Pending.push_back(entity); }
+
+    void flush()
+    {
+        for (Entity entity : m_Pending)
+            destroy(entity);
+        m_Pending.clear();
+    }
+
+    // Destroys every entity that has all of Cs
+    template<class... Cs>
+    void destroyAll()
+    {
+        eachEntity<Cs...>([&](Entity entity, Cs&...) { destroyLater(entity); });
+        flush();
+    }
+
+    size_t size() const { return m_Alive; }
+
+private:
+    struct Record {
+        Archetype* archetype = nullptr;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    Archetype& archetypeFor(ComponentMask mask)
+    {
+        for (Archetype* archetype : m_Archetypes)
+            if (archetype->m_Mask == mask)
+                return *archetype;
+        m_Archetypes.push_back(new Archetype(mask));
+        return *m_Archetypes.back();
+    }
+
+    std::vector<Archetype*> m_Archetypes;
+    std::vector<Record> m_Records;
+    std::vector<uint32_t> m_FreeRecords;
+    std::vector<Entity> m_Pending;
+    size_t m_Alive = 0;
+};
+
+} // namespace ecs
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef FONT_ATLAS_H
+#define FONT_ATLAS_H
+
+#include <glm/glm.hpp>
+
+#include "text_layout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// All of a font's ASCII glyphs as signed distance fields in one
+// single-channel atlas. A texel holds the distance to the glyph's outline,
+// 0.5 on the edge, more inside, so text.fs can cut a sharp edge at any
+// scale instead of magnifying a coverage bitmap.
+//
+// Glyphs come in as coverage bitmaps rasterized at FONT_BAKE_SCALE times
+// the atlas size; the distances are computed there (an exact Euclidean
+// distance transform) and sampled down, which keeps corners clean.
+// Rasterizing is left to the caller, so this file needs neither FreeType
+// nor GL.
+//
+// Baking takes a while, so the atlas is saved to disk under a key made from
+// the font file's bytes and the bake settings; a later launch with the same
+// font loads it back and never starts FreeType.
+
+const int FONT_PIXEL_SIZE = 48;         // em size in the atlas; RenderText's scale is relative to it
+const int FONT_BAKE_SCALE = 4;          // glyphs are rasterized this many times larger
+const int FONT_SDF_SPREAD = 6;          // atlas pixels of distance on either side of the edge
+const int FONT_ATLAS_WIDTH = 1024;
+const int FONT_FIRST_GLYPH = 32;        // printable ASCII
+const int FONT_LAST_GLYPH = 126;
+
+class FontAtlas {
+public:
+    Character glyphs[128] = {};     // Size / Bearing include the spread border
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;  // width * height, row 0 at the top (v = 0)
+
+    void begin()
+    {
+        width = FONT_ATLAS_WIDTH;
+        height = 0;
+        pixels.clear();
+        std::fill(std::begin(glyphs), std::end(glyphs), Character{});
+        m_PenX = m_PenY = m_RowHeight = 0;
+    }
+
+    // One glyph rasterized at FONT_BAKE_SCALE: an 8-bit coverage bitmap
+    // (rows top down), its bearing in bake pixels and its advance in 1/64
+    // bake pixels. Empty bitmaps (space) only set the advance.
+    void addGlyph(int code, const unsigned char* bitmap, int bitmapWidth, int bitmapHeight, int pitch,
+        int bearingX, int bearingY, unsigned int advance)
+    {
+        Character& glyph = glyphs[code];
+        glyph.Advance = advance / FONT_BAKE_SCALE;
+        if (bitmapWidth == 0 || bitmapHeight == 0)
+            return;
+
+        // Grid in bake pixels, its origin on a multiple of the bake scale so
+        // the atlas bearing is a whole number of pixels
+        const int S = FONT_BAKE_SCALE;
+        int left = floorDiv(bearingX, S) - FONT_SDF_SPREAD;
+        int top = -floorDiv(-bearingY, S) + FONT_SDF_SPREAD;
+        int cellWidth = -floorDiv(-(bearingX + bitmapWidth), S) + FONT_SDF_SPREAD - left;
+        int cellHeight = top - (floorDiv(bearingY - bitmapHeight, S) - FONT_SDF_SPREAD);
+        int gridWidth = cellWidth * S, gridHeight = cellHeight * S;
+        int offsetX = bearingX - left * S, offsetY = top * S - bearingY;
+
+        std::vector<unsigned char> inside((size_t)gridWidth * gridHeight, 0);
+        for (int y = 0; y < bitmapHeight; ++y)
+            for (int x = 0; x < bitmapWidth; ++x)
+                inside[(size_t)(y + offsetY) * gridWidth + x + offsetX] = bitmap[y * pitch + x] >= 128 ? 1 : 0;
+
+        std::vector<float> toInside, toOutside;
+        distanceTransform(inside, gridWidth, gridHeight, 1, toInside);
+        distanceTransform(inside, gridWidth, gridHeight, 0, toOutside);
+
+        int atlasX, atlasY;
+        place(cellWidth, cellHeight, atlasX, atlasY);
+        for (int y = 0; y < cellHeight; ++y)
+            for (int x = 0; x < cellWidth; ++x)
+            {
+                size_t sample = (size_t)(y * S + S / 2) * gridWidth + x * S + S / 2;
+                float distance = (std::sqrt(toOutside[sample]) - std::sqrt(toInside[sample])) / S;
+                float value = 0.5f + distance / (2.0f * FONT_SDF_SPREAD);
+                pixels[(size_t)(atlasY + y) * width + atlasX + x] = (unsigned char)(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+
+        glyph.Size = glm::ivec2(cellWidth, cellHeight);
+        glyph.Bearing = glm::ivec2(left, top);
+        glyph.UvMin = glm::vec2((float)atlasX, (float)atlasY);
+        glyph.UvMax = glm::vec2((float)(atlasX + cellWidth), (float)(atlasY + cellHeight));
+    }
+
+    // Rounds the height up to a power of two and turns pixel rectangles into
+    // texture coordinates
+    void end()
+    {
+        int rounded = 1;
+        while (rounded < height)
+            rounded <<= 1;
+        height = rounded;
+        pixels.resize((size_t)width * height, 0);
+        float u = 1.0f / width, v = 1.0f / height;
+        for (Character& glyph : glyphs)
+        {
+            glyph.UvMin = glm::vec2(glyph.UvMin.x * u, glyph.UvMin.y * v);
+            glyph.UvMax = glm::vec2(glyph.UvMax.x * u, glyph.UvMax.y * v);
+        }
+    }
+
+    // What a cached atlas must match: the font file and how it was baked
+    static uint64_t key(const std::vector<unsigned char>& fontFile)
+    {
+        uint64_t h = 14695981039346656037ull;
+        auto mix = [&h](const void* data, size_t size) {
+            for (size_t i = 0; i < size; ++i)
+                h = (h ^ ((const unsigned char*)data)[i]) * 1099511628211ull;
+        };
+        const int settings[] = { FILE_VERSION, FONT_PIXEL_SIZE, FONT_BAKE_SCALE, FONT_SDF_SPREAD,
+            FONT_ATLAS_WIDTH, FONT_FIRST_GLYPH, FONT_LAST_GLYPH };
+        mix(settings, sizeof(settings));
+        mix(fontFile.data(), fontFile.size());
+        return h;
+    }
+
+    bool load(const std::string& path, uint64_t key)
+    {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+        FileHeader header;
+        bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == FILE_MAGIC &&
+            header.key == key && header.width == FONT_ATLAS_WIDTH && header.height > 0 && header.height <= 8192 &&
+            std::fread(glyphs, sizeof(glyphs), 1, file) == 1;
+        if (ok)
+        {
+            width = header.width;
+            height = header.height;
+            pixels.resize((size_t)width * height);
+            ok = std::fread(pixels.data(), 1, pixels.size(), file) == pixels.size();
+        }
+        std::fclose(file);
+        return ok;
+    }
+
+    bool save(const std::string& path, uint64_t key) const
+    {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+        FileHeader header = { FILE_MAGIC, key, (uint32_t)width, (uint32_t)height };
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+            std::fwrite(glyphs, sizeof(glyphs), 1, file) == 1 &&
+            std::fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+private:
+    static const uint32_t FILE_MAGIC = 0x4658594E;      // "NYXF"
+    static const int FILE_VERSION = 1;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint64_t key;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    static int floorDiv(int a, int b)
+    {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    // Rows of glyphs left to right, a new row when one is full; one atlas
+    // pixel of gap so bilinear filtering never reads a neighbour
+    void place(int cellWidth, int cellHeight, int& x, int& y)
+    {
+        if (m_PenX + cellWidth > width)
+        {
+            m_PenX = 0;
+            m_PenY += m_RowHeight + 1;
+            m_RowHeight = 0;
+        }
+        x = m_PenX;
+        y = m_PenY;
+        m_PenX += cellWidth + 1;
+        m_RowHeight = std::max(m_RowHeight, cellHeight);
+        if (y + cellHeight > height)
+        {
+            height = y + cellHeight;
+            pixels.resize((size_t)width * height, 0);
+        }
+    }
+
+    // Squared distance from every cell to the nearest cell whose 'inside'
+    // equals 'target' (Felzenszwalb & Huttenlocher: one 1D lower envelope
+    // pass per column, then per row)
+    static void distanceTransform(const std::vector<unsigned char>& inside, int width, int height, unsigned char target,
+        std::vector<float>& out)
+    {
+        const float FAR = 1e20f;
+        out.resize(inside.size());
+        for (size_t i = 0; i < inside.size(); ++i)
+            out[i] = inside[i] == target ? 0.0f : FAR;
+
+        int longest = std::max(width, height);
+        std::vector<float> f(longest), d(longest), z(longest + 1);
+        std::vector<int> v(longest);
+        for (int x = 0; x < width; ++x)
+        {
+            for (int y = 0; y < height; ++y)
+                f[y] = out[(size_t)y * width + x];
+            transform1D(f.data(), height, d.data(), v.data(), z.data());
+            for (int y = 0; y < height; ++y)
+                out[(size_t)y * width + x] = d[y];
+        }
+        for (int y = 0; y < height; ++y)
+        {
+            std::copy(out.begin() + (size_t)y * width, out.begin() + (size_t)(y + 1) * width, f.begin());
+            transform1D(f.data(), width, d.data(), v.data(), z.data());
+            std::copy(d.begin(), d.begin() + width, out.begin() + (size_t)y * width);
+        }
+    }
+
+    static void transform1D(const float* f, int n, float* d, int* v, float* z)
+    {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -1e20f;
+        z[1] = 1e20f;
+        for (int q = 1; q < n; ++q)
+        {
+            float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+            while (s <= z[k])
+            {
+                k--;
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = 1e20f;
+        }
+        k = 0;
+        for (int q = 0; q < n; ++q)
+        {
+            while (z[k + 1] < q)
+                k++;
+            float dq = (float)(q - v[k]);
+            d[q] = dq * dq + f[v[k]];
+        }
+    }
+
+    int m_PenX = 0;
+    int m_PenY = 0;
+    int m_RowHeight = 0;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+// Linear allocator for data that only lives for one frame (HUD strings,
+// scratch arrays). Allocation is a pointer bump, reset() at the top of the
+// frame throws everything away at once. The buffer is allocated once up
+// front; running out returns nullptr instead of falling back to the heap.
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity)
+        : m_Buffer(new unsigned char[capacity]), m_Capacity(capacity), m_Used(0), m_HighWater(0), m_Overflowed(false)
+    {
+    }
+
+    ~FrameArena() { delete[] m_Buffer; }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void reset()
+    {
+        m_Used = 0;
+    }
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t))
+    {
+        size_t start = (m_Used + align - 1) & ~(align - 1);
+        if (start + size > m_Capacity)
+        {
+            if (!m_Overflowed)
+                std::cout << "Warning: frame arena out of memory (" << m_Capacity << " bytes)" << std::endl;
+            m_Overflowed = true;
+            return nullptr;
+        }
+        m_Used = start + size;
+        if (m_Used > m_HighWater)
+            m_HighWater = m_Used;
+        return m_Buffer + start;
+    }
+
+    // Uninitialized storage for 'count' trivially copyable T
+    template<class T>
+    T* allocArray(size_t count)
+    {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // printf into the arena, returns "" if it does not fit
+    const char* format(const char* fmt, ...)
+    {
+        size_t available = m_Capacity - m_Used;
+        char* out = reinterpret_cast<char*>(m_Buffer + m_Used);
+
+        va_list args;
+        va_start(args, fmt);
+        int written = std::vsnprintf(out, available, fmt, args);
+        va_end(args);
+
+        if (written < 0 || (size_t)written >= available)
+        {
+            if (!m_Overflowed)
+                std::cout << "Warning: frame arena out of memory (" << m_Capacity << " bytes)" << std::endl;
+            m_Overflowed = true;
+            return "";
+        }
+        allocate(written + 1, 1);
+        return out;
+    }
+
+    size_t used() const { return m_Used; }
+    size_t highWater() const { return m_HighWater; }
+    size_t capacity() const { return m_Capacity; }
+
+private:
+    unsigned char* m_Buffer;
+    size_t m_Capacity;
+    size_t m_Used;
+    size_t m_HighWater;
+    bool m_Overflowed;
+};
+
+#endif
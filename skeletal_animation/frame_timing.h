@@ -0,0 +1,113 @@
+#ifndef FRAME_TIMING_H
+#define FRAME_TIMING_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// Fixed-step simulation clock. Every frame hands it the frame's dt; it
+// answers how many whole steps the simulation owes and how far the leftover
+// time is into the next one (for interpolating what gets drawn).
+//
+// Only the frame dt goes in, never the wall clock, so a replay that feeds the
+// recorded dts back gets exactly the same steps.
+class FixedStepClock {
+public:
+    static constexpr float MAX_FRAME_TIME = 0.25f;  // a hitch beyond this is dropped, not simulated
+    static const int MAX_STEPS = 5;                 // per frame, so a slow frame can't snowball
+
+    explicit FixedStepClock(int hz = 60) { setRate(hz); }
+
+    void setRate(int hz)
+    {
+        m_Hz = std::max(1, hz);
+        m_Step = 1.0 / m_Hz;
+    }
+
+    // Returns the number of steps to run this frame
+    int advance(float dt)
+    {
+        m_FrameTime = std::min(std::max(dt, 0.0f), MAX_FRAME_TIME);
+        m_Accumulator += m_FrameTime;
+
+        int steps = 0;
+        while (m_Accumulator >= m_Step && steps < MAX_STEPS)
+        {
+            m_Accumulator -= m_Step;
+            steps++;
+        }
+        if (m_Accumulator >= m_Step)
+        {
+            // Too far behind: run slower instead of trying to catch up
+            m_DroppedSteps += (int)(m_Accumulator / m_Step);
+            m_Accumulator = std::fmod(m_Accumulator, m_Step);
+        }
+        return steps;
+    }
+
+    // Forget owed time, e.g. when the simulation was not running
+    void reset() { m_Accumulator = 0.0; }
+
+    float step() const { return (float)m_Step; }
+    int hz() const { return m_Hz; }
+    float frameTime() const { return m_FrameTime; }                 // this frame's clamped dt
+    float alpha() const { return (float)(m_Accumulator / m_Step); } // 0..1 between the last two states
+    int droppedSteps() const { return m_DroppedSteps; }
+
+private:
+    int m_Hz = 60;
+    double m_Step = 1.0 / 60.0;
+    double m_Accumulator = 0.0;
+    float m_FrameTime = 0.0f;
+    int m_DroppedSteps = 0;
+};
+
+// Caps the frame rate when vsync is off (or on top of it). Sleeps for most of
+// the remaining frame and spins the last bit, since sleep can overshoot by a
+// scheduler tick.
+class FramePacer {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static constexpr double SPIN_SECONDS = 0.002;
+
+    // 0 = uncapped
+    void setTargetFps(double fps)
+    {
+        m_Period = fps > 0.0 ? 1.0 / fps : 0.0;
+        m_Next = Clock::time_point();
+    }
+
+    double targetFps() const { return m_Period > 0.0 ? 1.0 / m_Period : 0.0; }
+
+    // Call once per frame, after the swap
+    void wait()
+    {
+        if (m_Period <= 0.0)
+            return;
+
+        Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_Period));
+        Clock::time_point now = Clock::now();
+        if (m_Next == Clock::time_point() || now - m_Next > period)
+        {
+            // first frame, or a long hitch: start counting from here
+            m_Next = now + period;
+            return;
+        }
+
+        Clock::duration spin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(SPIN_SECONDS));
+        if (m_Next - now > spin)
+            std::this_thread::sleep_for(m_Next - now - spin);
+        while (Clock::now() < m_Next)
+            std::this_thread::yield();
+
+        m_Next += period;
+    }
+
+private:
+    double m_Period = 0.0;
+    Clock::time_point m_Next;
+};
+
+#endif
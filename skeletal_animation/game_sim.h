@@ -0,0 +1,363 @@
+#ifndef GAME_SIM_H
+#define GAME_SIM_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+#include "ecs.h"
+#include "level.h"
+#include "nav_field.h"
+#include "projectiles.h"
+#include "rng.h"
+
+// Gameplay components, tuning and the systems that run over them. Bullets
+// are not entities, they live in a ProjectileRing (projectiles.h).
+//
+// Archetypes the game creates:
+//   target  Transform, Velocity, Hitbox, Health, AnimationState
+//   player  Transform, Health, AnimationState, PlayerState (+ the game's Locomotion)
+
+struct AnimClip;
+class SkeletalAnimator;
+
+// ==================== COMPONENTS ====================
+struct Transform {
+    glm::vec3 position;
+    glm::vec3 previous;     // position before the last fixed step, for render interpolation
+};
+
+struct Velocity {
+    glm::vec3 direction;    // unit length; targets re-aim every step
+    float speed;
+};
+
+struct AnimationState {
+    SkeletalAnimator* animator;     // targets take theirs from the enemy animator pool
+    const AnimClip* clip;           // what the animator is playing
+};
+
+struct Hitbox {
+    glm::vec3 min;          // local-space AABB min
+    glm::vec3 max;          // local-space AABB max
+    glm::vec3 scale;        // model scale used when rendering -> apply to bbox
+};
+
+struct Health {
+    float current;
+    float max;
+};
+
+struct PlayerState {
+    int slot;               // 0 = the host or single player, network clients 1..
+    float yaw;              // degrees, facing and aim
+    float pitch;
+    int clip;               // index of the locomotion clip playing
+    bool dead;
+    float respawnTimer;
+    float lastDamageTime;   // sim time of the last hit taken
+};
+
+// Movement clips, PlayerState::clip
+enum LocomotionClip {
+    CLIP_IDLE,
+    CLIP_FORWARD,
+    CLIP_BACK,
+    CLIP_LEFT,
+    CLIP_RIGHT,
+    CLIP_FORWARD_LEFT,
+    CLIP_FORWARD_RIGHT,
+    CLIP_BACK_LEFT,
+    CLIP_BACK_RIGHT,
+    CLIP_COUNT
+};
+
+// ==================== TUNING ====================
+const glm::vec3 PLAYER_START = glm::vec3(0.0f, 0.09f, 0.0f);
+const float CHARACTER_SPEED = 2.5f;     // units/sec
+const float PLAYER_RADIUS = 0.3f;       // half width against level walls
+const float TARGET_RADIUS = 0.2f;
+const float BODY_HEIGHT = 1.6f;         // players and targets, for level collision
+const glm::vec3 MUZZLE_OFFSET = glm::vec3(-0.1f, 0.8f, 0.0f);     // bullets start here, from the player
+
+const float MAX_HEALTH = 100.0f;
+const float RESPAWN_TIME = 3.0f;
+const float ENEMY_DAMAGE = 20.0f;
+const float DAMAGE_COOLDOWN = 1.0f;
+const float CONTACT_RANGE = 0.8f;       // a target this close hurts the player
+
+const float BULLET_SPEED = 15.0f;
+const float BULLET_LIFETIME = 3.0f;
+
+const float TARGET_SPEED = 1.2f;
+const float TARGET_SPAWN_HEIGHT = 0.1f; // targets walk with their feet here
+const float TARGET_ARRIVE_DISTANCE = 0.5f;  // targets stop this close to a player
+const float SPAWN_INTERVAL = 3.0f;
+const float SPAWN_CLEARANCE = 2.5f;     // and at least this far from every player
+const int SPAWN_ATTEMPTS = 64;          // random spots tried before a spawn is skipped
+
+// ==================== SPAWNING ====================
+// Fired on fixed step 'tick'. Returns its serial, PROJECTILE_NONE when the
+// ring is full and the shot is dropped.
+inline uint32_t createBullet(ProjectileRing& bullets, const glm::vec3& position, const glm::vec3& direction, float speed, uint32_t tick)
+{
+    return bullets.spawn(position, direction * speed, tick);
+}
+
+// BULLET_LIFETIME in fixed steps of 'dt'
+inline uint32_t bulletLifetimeTicks(float dt)
+{
+    return (uint32_t)std::lround(BULLET_LIFETIME / dt);
+}
+
+inline ecs::Entity createTarget(ecs::World& world, const glm::vec3& position, float speed, const Hitbox& hitbox, const AnimationState& animation)
+{
+    return world.create(Transform{ position, position }, Velocity{ glm::vec3(0.0f), speed }, hitbox,
+        Health{ 1.0f, 1.0f }, animation);
+}
+
+inline Hitbox targetHitbox()
+{
+    Hitbox hitbox;
+    hitbox.min = glm::vec3(-0.3f, 0.0f, -0.3f);
+    hitbox.max = glm::vec3(0.3f, 1.5f, 0.3f);
+    hitbox.scale = glm::vec3(0.6f);
+    return hitbox;
+}
+
+// Somewhere in the level's spawn area, clear of every player and of the
+// level's geometry. False when SPAWN_ATTEMPTS spots were all taken (the
+// area is walled in or a player stands on it); skip the spawn then.
+inline bool randomSpawnPoint(Rng& rng, const Level& level, const glm::vec3* players, int playerCount, glm::vec3& position)
+{
+    glm::vec3 spawnMin = level.spawnMin();
+    glm::vec3 spawnSize = level.spawnMax() - spawnMin;
+    glm::vec3 body(TARGET_RADIUS, 0.0f, TARGET_RADIUS);
+    for (int attempt = 0; attempt < SPAWN_ATTEMPTS; ++attempt)
+    {
+        glm::vec3 pos(
+            spawnMin.x + rng.range(100) / 100.0f * spawnSize.x,
+            TARGET_SPAWN_HEIGHT,
+            spawnMin.z + rng.range(100) / 100.0f * spawnSize.z
+        );
+        bool tooClose = level.overlaps(pos - body + glm::vec3(0.0f, LEVEL_STEP_HEIGHT, 0.0f), pos + body + glm::vec3(0.0f, BODY_HEIGHT, 0.0f));
+        for (int p = 0; p < playerCount; ++p)
+            tooClose = tooClose || glm::length(pos - players[p]) < SPAWN_CLEARANCE;
+        if (!tooClose)
+        {
+            position = pos;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline size_t bulletCount(const ProjectileRing& bullets) { return bullets.size(); }
+inline size_t targetCount(ecs::World& world) { return world.count<Transform, Hitbox>(); }
+
+// ==================== PLAYERS ====================
+// One fixed step of walking relative to 'yaw', stopped by the level's walls.
+// Returns the LocomotionClip that goes with the keys held.
+inline int stepPlayer(const Level& level, glm::vec3& position, bool w, bool s, bool a, bool d, float yaw, float dt)
+{
+    float yawRad = glm::radians(yaw);
+    glm::vec3 camForward = glm::normalize(glm::vec3(-sin(yawRad), 0.0f, -cos(yawRad)));
+    glm::vec3 camRight = glm::normalize(glm::vec3(cos(yawRad), 0.0f, -sin(yawRad)));
+
+    glm::vec3 moveDir(0.0f);
+    if (w) moveDir += camForward;
+    if (s) moveDir -= camForward;
+    if (a) moveDir -= camRight;
+    if (d) moveDir += camRight;
+
+    bool moving = glm::length(moveDir) > 0.01f;
+    if (moving)
+    {
+        moveDir = glm::normalize(moveDir);
+        position += moveDir * CHARACTER_SPEED * dt;
+        level.collide(position, PLAYER_RADIUS, BODY_HEIGHT);
+    }
+
+    if (!moving)
+        return CLIP_IDLE;
+    if (w && a && !s && !d)
+        return CLIP_FORWARD_LEFT;
+    if (w && d && !s && !a)
+        return CLIP_FORWARD_RIGHT;
+    if (s && a && !w && !d)
+        return CLIP_BACK_LEFT;
+    if (s && d && !w && !a)
+        return CLIP_BACK_RIGHT;
+    if (w && !a && !s && !d)
+        return CLIP_FORWARD;
+    if (s && !a && !w && !d)
+        return CLIP_BACK;
+    if (a && !w && !s && !d)
+        return CLIP_LEFT;
+    if (d && !w && !s && !a)
+        return CLIP_RIGHT;
+    return CLIP_FORWARD; // fallback
+}
+
+// Back at the start, full health
+inline void resetPlayer(ecs::World& world, ecs::Entity player)
+{
+    *world.get<Transform>(player) = Transform{ PLAYER_START, PLAYER_START };
+    Health& health = *world.get<Health>(player);
+    health.current = health.max;
+    PlayerState& state = *world.get<PlayerState>(player);
+    state.dead = false;
+    state.respawnTimer = 0.0f;
+}
+
+// Positions of the living players, at most 'capacity' of them
+inline int alivePlayers(ecs::World& world, glm::vec3* out, int capacity)
+{
+    int count = 0;
+    world.each<Transform, PlayerState>([&](const Transform& t, const PlayerState& state) {
+        if (!state.dead && count < capacity)
+            out[count++] = t.position;
+    });
+    return count;
+}
+
+// Dead players wait RESPAWN_TIME and come back at the start. onRespawn(ecs::Entity)
+// runs for each one that did.
+template<class OnRespawn>
+inline void updateRespawns(ecs::World& world, float dt, OnRespawn onRespawn)
+{
+    world.eachEntity<PlayerState>([&](ecs::Entity player, PlayerState& state) {
+        if (!state.dead)
+            return;
+        state.respawnTimer += dt;
+        if (state.respawnTimer >= RESPAWN_TIME)
+        {
+            resetPlayer(world, player);
+            onRespawn(player);
+        }
+    });
+}
+
+// A target touching a living player takes ENEMY_DAMAGE off it, at most once
+// per DAMAGE_COOLDOWN. onHit(ecs::Entity player, const Health&, bool died)
+// runs for each hit. 'now' is simulation time in seconds.
+template<class OnHit>
+inline void applyContactDamage(ecs::World& world, float now, OnHit onHit)
+{
+    world.eachEntity<Transform, PlayerState, Health>([&](ecs::Entity player, const Transform& p, PlayerState& state, Health& health) {
+        if (state.dead || now - state.lastDamageTime < DAMAGE_COOLDOWN)
+            return;
+        bool hit = false;
+        world.each<Transform, Hitbox>([&](const Transform& t, const Hitbox&) {
+            hit = hit || glm::length(t.position - p.position) < CONTACT_RANGE;
+        });
+        if (!hit)
+            return;
+
+        health.current -= ENEMY_DAMAGE;
+        state.lastDamageTime = now;
+        bool died = health.current <= 0.0f;
+        if (died)
+        {
+            health.current = 0.0f;
+            state.dead = true;
+            state.respawnTimer = 0.0f;
+        }
+        onHit(player, health, died);
+    });
+}
+
+// ==================== SYSTEMS ====================
+// Precise AABB test using world-space point and target's local bbox scaled/translated to world
+inline bool pointInHitbox(const glm::vec3& p, const Transform& transform, const Hitbox& hitbox)
+{
+    // Compute world AABB for the target
+    glm::vec3 minWorld = transform.position + hitbox.min * hitbox.scale;
+    glm::vec3 maxWorld = transform.position + hitbox.max * hitbox.scale;
+
+    return (p.x >= minWorld.x && p.x <= maxWorld.x) &&
+        (p.y >= minWorld.y && p.y <= maxWorld.y) &&
+        (p.z >= minWorld.z && p.z <= maxWorld.z);
+}
+
+// Start of a fixed step: remember where everything was
+inline void storePreviousPositions(ecs::World& world, ProjectileRing& bullets)
+{
+    world.each<Transform>([](Transform& t) { t.previous = t.position; });
+    bullets.storePrevious();
+}
+
+// Step 'tick': drops the bullets older than BULLET_LIFETIME off the tail,
+// moves the rest and removes the ones that hit the level on the way
+inline void updateBullets(ProjectileRing& bullets, const Level& level, uint32_t tick, float dt)
+{
+    bullets.expire(tick, bulletLifetimeTicks(dt));
+    bullets.integrate(dt);
+    bullets.each([&](uint32_t slot) {
+        const glm::vec3& to = bullets.position(slot);
+        if (level.segmentHits(to - bullets.velocity(slot) * dt, to))
+            bullets.kill(slot);
+    });
+    bullets.compact();
+}
+
+// Where targets can walk in 'level', for their flow fields
+inline void buildTargetNav(NavGrid& grid, const Level& level)
+{
+    grid.build(level, TARGET_RADIUS, BODY_HEIGHT, TARGET_SPAWN_HEIGHT);
+}
+
+// Move every target along 'field' toward the nearest of 'playerCount'
+// players, sliding along the level's walls. The field is only recomputed
+// when a player has moved into another cell.
+inline void chaseTargets(ecs::World& world, const Level& level, FlowField& field, const glm::vec3* players, int playerCount, float dt)
+{
+    if (playerCount == 0)
+        return;
+    field.update(players, playerCount);
+    world.each<Transform, Velocity, Hitbox>([&](Transform& t, Velocity& v, Hitbox&) {
+        glm::vec3 direction;
+        if (!field.steer(t.position, TARGET_ARRIVE_DISTANCE, direction))
+            return;
+        v.direction = direction;
+        t.position += v.direction * v.speed * dt;
+        level.collide(t.position, TARGET_RADIUS, BODY_HEIGHT);
+    });
+}
+
+// Each bullet kills at most one target. onKill(ecs::Entity) runs before the
+// target is destroyed. Returns the number of kills.
+template<class OnKill>
+inline int resolveBulletHits(ecs::World& world, ProjectileRing& bullets, OnKill onKill)
+{
+    int kills = 0;
+    bullets.each([&](uint32_t bullet) {
+        const glm::vec3& position = bullets.position(bullet);
+        bool hit = false;
+        world.eachChunk<Transform, Hitbox, Health>([&](const ecs::ChunkView& chunk) {
+            if (hit)
+                return;
+            const Transform* transforms = chunk.array<Transform>();
+            const Hitbox* hitboxes = chunk.array<Hitbox>();
+            Health* health = chunk.array<Health>();
+            for (uint32_t i = 0, n = chunk.size(); i < n; ++i)
+            {
+                if (health[i].current > 0.0f && pointInHitbox(position, transforms[i], hitboxes[i]))
+                {
+                    health[i].current = 0.0f;     // dead for the bullets after this one
+                    onKill(chunk.entities()[i]);
+                    world.destroyLater(chunk.entities()[i]);
+                    bullets.kill(bullet);
+                    kills++;
+                    hit = true;
+                    break;
+                }
+            }
+        });
+    });
+    world.flush();
+    bullets.compact();
+    return kills;
+}
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Input recording and replay.
+//
+// The game loop reads all of its input for a tick from one InputFrame instead
+// of polling GLFW directly. When recording, every frame is appended to a file
+// together with the RNG seed; replaying feeds the same frames (including the
+// frame's dt) back in, so the simulation runs exactly as it did live.
+//
+// File layout (native endianness):
+//   ReplayHeader
+//   InputFrame * header.frameCount
+
+enum InputButton : uint32_t {
+    BUTTON_FORWARD  = 1u << 0,   // W
+    BUTTON_BACK     = 1u << 1,   // S
+    BUTTON_LEFT     = 1u << 2,   // A
+    BUTTON_RIGHT    = 1u << 3,   // D
+    BUTTON_FIRE     = 1u << 4,   // J or left mouse
+    BUTTON_PAUSE    = 1u << 5,   // ESC
+    BUTTON_CONFIRM  = 1u << 6,   // ENTER
+    BUTTON_UP       = 1u << 7,   // menu up
+    BUTTON_DOWN     = 1u << 8,   // menu down
+};
+
+struct InputFrame {
+    uint32_t buttons;   // InputButton bits held this tick
+    uint32_t pressed;   // InputButton bits pressed (or key-repeated) since the previous tick
+    float dt;           // seconds since the previous tick
+    float mouseDx;      // raw cursor movement in pixels since the previous tick
+    float mouseDy;
+    float scroll;
+
+    bool held(uint32_t button) const { return (buttons & button) != 0; }
+    bool justPressed(uint32_t button) const { return (pressed & button) != 0; }
+};
+
+const char REPLAY_MAGIC[4] = { 'N', 'Y', 'X', 'R' };
+const uint32_t REPLAY_VERSION = 6;     // 2: InputFrame::pressed, 3: simHz, 4: camera-free aim, 5: level collision, 6: bullet ring
+
+struct ReplayHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t seed;
+    uint32_t startState;    // GameState the recording started in
+    uint32_t frameCount;
+    uint32_t stateHash;     // simulation state after the last frame
+    uint32_t simHz;         // fixed simulation rate the recording ran at
+};
+
+class InputRecorder {
+public:
+    ~InputRecorder() { if (m_File) std::fclose(m_File); }
+
+    bool open(const std::string& path, uint64_t seed, uint32_t startState, uint32_t simHz)
+    {
+        m_File = std::fopen(path.c_str(), "wb");
+        if (!m_File) {
+            std::cout << "ERROR::REPLAY: could not create " << path << std::endl;
+            return false;
+        }
+        std::memset(&m_Header, 0, sizeof(m_Header));
+        std::memcpy(m_Header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+        m_Header.version = REPLAY_VERSION;
+        m_Header.seed = seed;
+        m_Header.startState = startState;
+        m_Header.simHz = simHz;
+        // placeholder, finish() rewrites it with the final count and hash
+        std::fwrite(&m_Header, sizeof(m_Header), 1, m_File);
+        m_Path = path;
+        return true;
+    }
+
+    bool recording() const { return m_File != nullptr; }
+
+    void write(const InputFrame& frame)
+    {
+        if (!m_File)
+            return;
+        std::fwrite(&frame, sizeof(frame), 1, m_File);
+        m_Header.frameCount++;
+    }
+
+    void finish(uint32_t stateHash)
+    {
+        if (!m_File)
+            return;
+        m_Header.stateHash = stateHash;
+        std::fseek(m_File, 0, SEEK_SET);
+        std::fwrite(&m_Header, sizeof(m_Header), 1, m_File);
+        std::fclose(m_File);
+        m_File = nullptr;
+        std::cout << "[replay] recorded " << m_Header.frameCount << " frames to " << m_Path << std::endl;
+    }
+
+private:
+    FILE* m_File = nullptr;
+    ReplayHeader m_Header;
+    std::string m_Path;
+};
+
+class InputReplay {
+public:
+    // Reads the whole file up front so playback never touches the disk
+    bool load(const std::string& path)
+    {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            std::cout << "ERROR::REPLAY: could not open " << path << std::endl;
+            return false;
+        }
+
+        bool ok = std::fread(&m_Header, sizeof(m_Header), 1, file) == 1 &&
+            std::memcmp(m_Header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) == 0 &&
+            m_Header.version == REPLAY_VERSION;
+        if (ok) {
+            m_Frames.resize(m_Header.frameCount);
+            ok = m_Header.frameCount == 0 ||
+                std::fread(m_Frames.data(), sizeof(InputFrame), m_Frames.size(), file) == m_Frames.size();
+        }
+        std::fclose(file);
+
+        if (!ok) {
+            std::cout << "ERROR::REPLAY: " << path << " is not a valid replay" << std::endl;
+            m_Frames.clear();
+            return false;
+        }
+        m_Next = 0;
+        return true;
+    }
+
+    // Next recorded frame, nullptr once the recording is exhausted
+    const InputFrame* next()
+    {
+        if (m_Next >= m_Frames.size())
+            return nullptr;
+        return &m_Frames[m_Next++];
+    }
+
+    uint64_t seed() const { return m_Header.seed; }
+    uint32_t startState() const { return m_Header.startState; }
+    uint32_t expectedHash() const { return m_Header.stateHash; }
+    uint32_t simHz() const { return m_Header.simHz; }
+    size_t frameCount() const { return m_Frames.size(); }
+    size_t framesPlayed() const { return m_Next; }
+
+private:
+    ReplayHeader m_Header;
+    std::vector<InputFrame> m_Frames;
+    size_t m_Next = 0;
+};
+
+// FNV-1a, used to fingerprint the simulation state at the end of a run
+inline uint32_t hashBytes(uint32_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+const uint32_t HASH_SEED = 2166136261u;
+
+#endif
@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aInstance;   // xyz = position, w = scale, one per bullet
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    vec3 world = aInstance.xyz + aPos * aInstance.w;
+    gl_Position = projection * view * vec4(world, 1.0);
+}
@@ -0,0 +1,306 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Static level geometry: axis-aligned boxes from a text file, in a BVH for
+// collision. The game bakes boxes() into one vertex buffer.
+//
+// One statement per line, '#' starts a comment:
+//
+//   box minX minY minZ  maxX maxY maxZ  r g b
+//   spawn minX minZ maxX maxZ           where targets spawn (default: the bounds)
+
+const int LEVEL_LEAF_SIZE = 2;          // boxes per BVH leaf
+const float LEVEL_STEP_HEIGHT = 0.25f;  // bodies walk over boxes no taller than this above their feet
+
+struct LevelBox {
+    glm::vec3 min;
+    glm::vec3 max;
+    glm::vec3 color;
+};
+
+class Level {
+public:
+    bool loadFromFile(const std::string& path)
+    {
+        FILE* file = std::fopen(path.c_str(), "r");
+        if (!file) {
+            std::cout << "ERROR::LEVEL: could not open " << path << std::endl;
+            return false;
+        }
+
+        clear();
+        bool spawnSet = false;
+        char buffer[256];
+        int lineNumber = 0;
+        bool ok = true;
+        while (ok && std::fgets(buffer, sizeof(buffer), file)) {
+            lineNumber++;
+            std::string line = buffer;
+            size_t comment = line.find('#');
+            if (comment != std::string::npos)
+                line.erase(comment);
+            if (line.find_first_not_of(" \t\r\n") == std::string::npos)
+                continue;
+
+            char keyword[16];
+            glm::vec3 min, max, color;
+            if (std::sscanf(line.c_str(), "%15s", keyword) != 1)
+                continue;
+            if (std::string(keyword) == "box" &&
+                std::sscanf(line.c_str(), "%*s %f %f %f %f %f %f %f %f %f", &min.x, &min.y, &min.z,
+                    &max.x, &max.y, &max.z, &color.x, &color.y, &color.z) == 9 &&
+                min.x < max.x && min.y < max.y && min.z < max.z)
+                addBox(min, max, color);
+            else if (std::string(keyword) == "spawn" &&
+                std::sscanf(line.c_str(), "%*s %f %f %f %f", &min.x, &min.z, &max.x, &max.z) == 4 &&
+                min.x < max.x && min.z < max.z)
+            {
+                m_SpawnMin = glm::vec3(min.x, 0.0f, min.z);
+                m_SpawnMax = glm::vec3(max.x, 0.0f, max.z);
+                spawnSet = true;
+            }
+            else {
+                if (line.back() == '\n')
+                    line.pop_back();
+                std::cout << "ERROR::LEVEL: " << path << ":" << lineNumber << ": bad statement '" << line << "'" << std::endl;
+                ok = false;
+            }
+        }
+        std::fclose(file);
+        if (!ok)
+            return false;
+        if (m_Boxes.empty()) {
+            std::cout << "ERROR::LEVEL: " << path << " has no boxes" << std::endl;
+            return false;
+        }
+
+        build();
+        if (!spawnSet) {
+            m_SpawnMin = glm::vec3(m_Nodes[0].min.x, 0.0f, m_Nodes[0].min.z);
+            m_SpawnMax = glm::vec3(m_Nodes[0].max.x, 0.0f, m_Nodes[0].max.z);
+        }
+        return true;
+    }
+
+    void clear()
+    {
+        m_Boxes.clear();
+        m_Nodes.clear();
+        m_SpawnMin = m_SpawnMax = glm::vec3(0.0f);
+    }
+
+    // Levels built in code: addBox() every box, setSpawnArea(), then build()
+    void addBox(const glm::vec3& min, const glm::vec3& max, const glm::vec3& color)
+    {
+        m_Boxes.push_back({ min, max, color });
+    }
+
+    void setSpawnArea(float minX, float minZ, float maxX, float maxZ)
+    {
+        m_SpawnMin = glm::vec3(minX, 0.0f, minZ);
+        m_SpawnMax = glm::vec3(maxX, 0.0f, maxZ);
+    }
+
+    // Builds the BVH over the boxes, median split on the longest axis.
+    // Reorders boxes().
+    void build()
+    {
+        m_Nodes.clear();
+        if (!m_Boxes.empty())
+            buildNode(0, (int)m_Boxes.size());
+    }
+
+    const std::vector<LevelBox>& boxes() const { return m_Boxes; }
+    size_t nodeCount() const { return m_Nodes.size(); }
+    glm::vec3 boundsMin() const { return m_Nodes.empty() ? glm::vec3(0.0f) : m_Nodes[0].min; }
+    glm::vec3 boundsMax() const { return m_Nodes.empty() ? glm::vec3(0.0f) : m_Nodes[0].max; }
+
+    // Targets spawn in this rectangle on x and z (y is unused)
+    glm::vec3 spawnMin() const { return m_SpawnMin; }
+    glm::vec3 spawnMax() const { return m_SpawnMax; }
+
+    // Whether any box overlaps the AABB [min, max]
+    bool overlaps(const glm::vec3& min, const glm::vec3& max) const
+    {
+        bool hit = false;
+        query(min, max, [&](const LevelBox&) { hit = true; return false; });
+        return hit;
+    }
+
+    // Pushes an upright body (a square 2 * radius wide on x and z, 'height'
+    // tall, standing at 'position') out of every box it overlaps, along
+    // whichever of x and z is the shorter way out. Boxes under
+    // LEVEL_STEP_HEIGHT above its feet are floor. Returns whether it moved.
+    bool collide(glm::vec3& position, float radius, float height) const
+    {
+        glm::vec3 min(position.x - radius, position.y + LEVEL_STEP_HEIGHT, position.z - radius);
+        glm::vec3 max(position.x + radius, position.y + height, position.z + radius);
+        bool moved = false;
+        query(min, max, [&](const LevelBox& box) {
+            // Earlier boxes may already have moved it clear of this one
+            float left = position.x + radius - box.min.x;
+            float right = box.max.x - (position.x - radius);
+            float back = position.z + radius - box.min.z;
+            float front = box.max.z - (position.z - radius);
+            if (left <= 0.0f || right <= 0.0f || back <= 0.0f || front <= 0.0f)
+                return true;
+
+            float pushX = left < right ? -left : right;
+            float pushZ = back < front ? -back : front;
+            if (std::abs(pushX) < std::abs(pushZ))
+                position.x += pushX;
+            else
+                position.z += pushZ;
+            moved = true;
+            return true;
+        });
+        return moved;
+    }
+
+    // Whether the segment from 'from' to 'to' touches any box
+    bool segmentHits(const glm::vec3& from, const glm::vec3& to) const
+    {
+        if (m_Nodes.empty())
+            return false;
+        glm::vec3 delta = to - from;
+        glm::vec3 inverse(1.0f / delta.x, 1.0f / delta.y, 1.0f / delta.z);
+
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            int index = stack[--top];
+            const Node& node = m_Nodes[index];
+            if (!segmentOverlaps(from, inverse, node.min, node.max))
+                continue;
+            if (node.count == 0)
+            {
+                stack[top++] = node.right;
+                stack[top++] = index + 1;
+                continue;
+            }
+            for (int i = node.first; i < node.first + node.count; ++i)
+                if (segmentOverlaps(from, inverse, m_Boxes[i].min, m_Boxes[i].max))
+                    return true;
+        }
+        return false;
+    }
+
+private:
+    // Leaves hold 'count' boxes from 'first'. Inner nodes have count 0, the
+    // left child right after them and the right child at 'right'.
+    struct Node {
+        glm::vec3 min;
+        glm::vec3 max;
+        int right;
+        int first;
+        int count;
+    };
+
+    int buildNode(int first, int count)
+    {
+        Node node;
+        node.min = glm::vec3(1e30f);
+        node.max = glm::vec3(-1e30f);
+        glm::vec3 centerMin(1e30f), centerMax(-1e30f);
+        for (int i = first; i < first + count; ++i)
+        {
+            node.min = glm::min(node.min, m_Boxes[i].min);
+            node.max = glm::max(node.max, m_Boxes[i].max);
+            glm::vec3 center = (m_Boxes[i].min + m_Boxes[i].max) * 0.5f;
+            centerMin = glm::min(centerMin, center);
+            centerMax = glm::max(centerMax, center);
+        }
+        node.right = -1;
+        node.first = first;
+        node.count = count;
+
+        int index = (int)m_Nodes.size();
+        m_Nodes.push_back(node);
+        if (count <= LEVEL_LEAF_SIZE)
+            return index;
+
+        glm::vec3 extent = centerMax - centerMin;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        int half = count / 2;
+        std::nth_element(m_Boxes.begin() + first, m_Boxes.begin() + first + half, m_Boxes.begin() + first + count,
+            [axis](const LevelBox& a, const LevelBox& b) { return a.min[axis] + a.max[axis] < b.min[axis] + b.max[axis]; });
+
+        buildNode(first, half);
+        int right = buildNode(first + half, count - half);
+        m_Nodes[index].right = right;
+        m_Nodes[index].count = 0;
+        return index;
+    }
+
+    // Calls visit(const LevelBox&) for every box overlapping [min, max]
+    // until it returns false
+    template<class Visit>
+    void query(const glm::vec3& min, const glm::vec3& max, Visit visit) const
+    {
+        if (m_Nodes.empty())
+            return;
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            int index = stack[--top];
+            const Node& node = m_Nodes[index];
+            if (!boxesOverlap(min, max, node.min, node.max))
+                continue;
+            if (node.count == 0)
+            {
+                stack[top++] = node.right;
+                stack[top++] = index + 1;
+                continue;
+            }
+            for (int i = node.first; i < node.first + node.count; ++i)
+                if (boxesOverlap(min, max, m_Boxes[i].min, m_Boxes[i].max) && !visit(m_Boxes[i]))
+                    return;
+        }
+    }
+
+    static bool boxesOverlap(const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax)
+    {
+        return aMin.x < bMax.x && aMax.x > bMin.x &&
+            aMin.y < bMax.y && aMax.y > bMin.y &&
+            aMin.z < bMax.z && aMax.z > bMin.z;
+    }
+
+    // Slab test of the segment from + t * delta, t in [0, 1]
+    static bool segmentOverlaps(const glm::vec3& from, const glm::vec3& inverse, const glm::vec3& min, const glm::vec3& max)
+    {
+        float enter = 0.0f;
+        float exit = 1.0f;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float t0 = (min[axis] - from[axis]) * inverse[axis];
+            float t1 = (max[axis] - from[axis]) * inverse[axis];
+            if (t0 > t1)
+                std::swap(t0, t1);
+            enter = std::max(enter, t0);
+            exit = std::min(exit, t1);
+            if (enter > exit)
+                return false;
+        }
+        return true;
+    }
+
+    std::vector<LevelBox> m_Boxes;
+    std::vector<Node> m_Nodes;
+    glm::vec3 m_SpawnMin = glm::vec3(0.0f);
+    glm::vec3 m_SpawnMax = glm::vec3(0.0f);
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef LOAD_TEST_H
+#define LOAD_TEST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Stress test settings. Read from "key = value" lines in a config file
+// (--load-test-config file) and/or single --lt key=value overrides, e.g.
+//
+//   # thousands of enemies, 32 bots, two minutes
+//   max_targets = 5000
+//   spawn_rate = 200
+//   shooters = 32
+//   duration = 120
+struct LoadTestConfig {
+    bool enabled = false;
+    float spawnRate = 50.0f;        // targets per second between waves
+    int maxTargets = 2000;          // live target cap, also the animator pool size
+    int waveSize = 250;             // extra targets spawned at once every waveInterval
+    float waveInterval = 10.0f;     // seconds, 0 = no waves
+    int shooters = 16;              // bots firing at random targets
+    float fireRate = 4.0f;          // shots per second per bot
+    float duration = 60.0f;         // seconds of simulation time, then exit
+    bool invulnerable = true;       // player ignores enemy damage
+    uint64_t seed = 1;              // fixed so runs are comparable
+};
+
+// Applies one "key=value" (spaces around '=' are fine). Returns false for an
+// unknown key or a malformed line.
+inline bool applyLoadTestSetting(LoadTestConfig& config, const std::string& line)
+{
+    size_t eq = line.find('=');
+    if (eq == std::string::npos)
+        return false;
+
+    auto trim = [](const std::string& s) {
+        size_t b = s.find_first_not_of(" \t\r");
+        size_t e = s.find_last_not_of(" \t\r");
+        return b == std::string::npos ? std::string() : s.substr(b, e - b + 1);
+    };
+    std::string key = trim(line.substr(0, eq));
+    std::string value = trim(line.substr(eq + 1));
+    const char* v = value.c_str();
+
+    if (key == "spawn_rate") config.spawnRate = (float)std::atof(v);
+    else if (key == "max_targets") config.maxTargets = std::max(1, std::atoi(v));
+    else if (key == "wave_size") config.waveSize = std::max(0, std::atoi(v));
+    else if (key == "wave_interval") config.waveInterval = (float)std::atof(v);
+    else if (key == "shooters") config.shooters = std::max(0, std::atoi(v));
+    else if (key == "fire_rate") config.fireRate = (float)std::atof(v);
+    else if (key == "duration") config.duration = (float)std::atof(v);
+    else if (key == "invulnerable") config.invulnerable = std::atoi(v) != 0;
+    else if (key == "seed") config.seed = std::strtoull(v, nullptr, 10);
+    else return false;
+    return true;
+}
+
+inline bool loadLoadTestConfig(LoadTestConfig& config, const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) {
+        std::cout << "ERROR::LOADTEST: could not open " << path << std::endl;
+        return false;
+    }
+
+    char buffer[256];
+    int lineNumber = 0;
+    while (std::fgets(buffer, sizeof(buffer), file)) {
+        lineNumber++;
+        std::string line = buffer;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        if (line.find_first_not_of(" \t\r\n") == std::string::npos)
+            continue;
+        if (line.back() == '\n')
+            line.pop_back();
+        if (!applyLoadTestSetting(config, line))
+            std::cout << "Warning: " << path << ":" << lineNumber << ": ignoring '" << line << "'" << std::endl;
+    }
+    std::fclose(file);
+    return true;
+}
+
+// Percentiles over every frame of the run, not just the profiler's rolling
+// window, so one spike in a two minute run still shows up
+struct LoadTestSeries {
+    std::vector<float> samples;
+
+    void add(float value) { samples.push_back(value); }
+
+    void print(const char* name)
+    {
+        if (samples.empty())
+            return;
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (float s : samples)
+            total += s;
+        size_t n = samples.size();
+        std::printf("  %-16s avg %8.3f  p50 %8.3f  p99 %8.3f  max %8.3f\n", name,
+            total / n, samples[n / 2], samples[std::min(n - 1, n * 99 / 100)], samples[n - 1]);
+    }
+};
+
+#endif
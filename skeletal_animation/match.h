@@ -0,0 +1,174 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "game_sim.h"
+#include "rng.h"
+
+#include <cstdint>
+
+// One match of the game's rules with no window, audio, assets or animators:
+// spawning, chase, bullets, contact damage, health and respawn, score and
+// animation time, all through the systems in game_sim.h. The dedicated
+// server (server/nyx_server.cpp) runs hundreds of these side by side, all
+// colliding against one shared, read-only Level and its NavGrid. Each match
+// has its own flow field toward its own players.
+//
+// The players are bots. They pick a new direction to run every second or
+// two and shoot at the nearest target, so a match does roughly the work of
+// one with people in it.
+
+const int MATCH_MAX_PLAYERS = 4;
+const int MATCH_MAX_TARGETS = 64;       // the game's enemy animator pool size
+const float MATCH_BOT_FIRE_RATE = 2.0f; // shots per second per bot
+
+// Seconds into the clip an entity plays. In the game the animator keeps
+// this; a match only advances it, which is all a client needs to sample.
+struct ClipTime {
+    float seconds;
+};
+
+class Match {
+public:
+    // 'level' and 'nav' (built from it with buildTargetNav) have to outlive
+    // the match
+    void start(uint64_t seed, int players, const Level& level, const NavGrid& nav)
+    {
+        m_Level = &level;
+        m_Field.init(nav);
+        m_Rng.setSeed(seed);
+        m_PlayerCount = players < 1 ? 1 : (players > MATCH_MAX_PLAYERS ? MATCH_MAX_PLAYERS : players);
+        m_World.reserve<Transform, Velocity, Hitbox, Health, ClipTime>(MATCH_MAX_TARGETS);
+        m_Bullets.reserve((size_t)(m_PlayerCount * MATCH_BOT_FIRE_RATE * BULLET_LIFETIME) + 8);
+        for (int i = 0; i < m_PlayerCount; ++i)
+        {
+            PlayerState state = { i, 0.0f, 0.0f, CLIP_IDLE, false, 0.0f, 0.0f };
+            m_Players[i] = m_World.create(Transform{ PLAYER_START, PLAYER_START }, Health{ MAX_HEALTH, MAX_HEALTH }, state, ClipTime{ 0.0f });
+            m_Bots[i].turnTimer = 0.0f;
+            m_Bots[i].cooldown = m_Rng.nextFloat() / MATCH_BOT_FIRE_RATE;
+        }
+    }
+
+    // One fixed step, same order as the game's simulateTick
+    void tick(float dt)
+    {
+        m_Tick++;
+        m_Time += dt;
+
+        bool reset = false;
+        updateRespawns(m_World, dt, [&](ecs::Entity) { reset = m_PlayerCount == 1; });
+        if (reset)
+        {
+            // Alone, dying ends the round
+            m_Score = 0;
+            m_World.destroyAll<Transform, Hitbox>();
+        }
+
+        for (int i = 0; i < m_PlayerCount; ++i)
+            updateBot(i, dt);
+
+        glm::vec3 players[MATCH_MAX_PLAYERS];
+        int aliveCount = alivePlayers(m_World, players, MATCH_MAX_PLAYERS);
+        if (aliveCount > 0)
+        {
+            m_SpawnTimer += dt;
+            if (m_SpawnTimer >= SPAWN_INTERVAL && (int)targetCount(m_World) < MATCH_MAX_TARGETS)
+            {
+                m_SpawnTimer = 0.0f;
+                glm::vec3 position;
+                if (randomSpawnPoint(m_Rng, *m_Level, players, aliveCount, position))
+                    m_World.create(Transform{ position, position }, Velocity{ glm::vec3(0.0f), TARGET_SPEED },
+                        targetHitbox(), Health{ 1.0f, 1.0f }, ClipTime{ 0.0f });
+            }
+
+            updateBullets(m_Bullets, *m_Level, m_Tick, dt);
+            chaseTargets(m_World, *m_Level, m_Field, players, aliveCount, dt);
+            applyContactDamage(m_World, (float)m_Time, [&](ecs::Entity, const Health&, bool died) {
+                m_Deaths += died ? 1 : 0;
+            });
+            m_Score += resolveBulletHits(m_World, m_Bullets, [](ecs::Entity) {});
+        }
+
+        m_World.each<ClipTime>([&](ClipTime& clip) { clip.seconds += dt; });
+    }
+
+    uint32_t ticks() const { return m_Tick; }
+    int score() const { return m_Score; }
+    int deaths() const { return m_Deaths; }
+    int players() const { return m_PlayerCount; }
+    size_t targets() { return targetCount(m_World); }
+    size_t bullets() { return bulletCount(m_Bullets); }
+
+private:
+    struct Bot {
+        bool w, s, a, d;
+        float yaw;
+        float turnTimer;    // seconds until it picks a new way to run
+        float cooldown;     // seconds until the next shot
+    };
+
+    void updateBot(int index, float dt)
+    {
+        ecs::Entity entity = m_Players[index];
+        PlayerState& state = *m_World.get<PlayerState>(entity);
+        if (state.dead)
+            return;
+
+        Bot& bot = m_Bots[index];
+        bot.turnTimer -= dt;
+        if (bot.turnTimer <= 0.0f)
+        {
+            bot.turnTimer = 1.0f + m_Rng.nextFloat();
+            bot.yaw = m_Rng.nextFloat() * 360.0f;
+            uint32_t keys = m_Rng.next();
+            bot.w = (keys & 1) != 0;
+            bot.s = !bot.w && (keys & 2) != 0;
+            bot.a = (keys & 4) != 0;
+            bot.d = !bot.a && (keys & 8) != 0;
+        }
+
+        glm::vec3& position = m_World.get<Transform>(entity)->position;
+        int clip = stepPlayer(*m_Level, position, bot.w, bot.s, bot.a, bot.d, bot.yaw, dt);
+        state.yaw = bot.yaw;
+        if (clip != state.clip)
+        {
+            state.clip = clip;
+            m_World.get<ClipTime>(entity)->seconds = 0.0f;
+        }
+
+        bot.cooldown -= dt;
+        if (bot.cooldown > 0.0f)
+            return;
+        bot.cooldown += 1.0f / MATCH_BOT_FIRE_RATE;
+
+        // Nearest target, aimed at its middle
+        glm::vec3 muzzle = position + MUZZLE_OFFSET;
+        glm::vec3 aim(0.0f);
+        float nearest = 1e30f;
+        m_World.each<Transform, Hitbox>([&](const Transform& t, const Hitbox&) {
+            float distance = glm::length(t.position - muzzle);
+            if (distance < nearest)
+            {
+                nearest = distance;
+                aim = t.position + glm::vec3(0.0f, 0.5f, 0.0f);
+            }
+        });
+        if (nearest < 1e30f && glm::length(aim - muzzle) > 0.01f)
+            createBullet(m_Bullets, muzzle, glm::normalize(aim - muzzle), BULLET_SPEED, m_Tick);
+    }
+
+    ecs::World m_World;
+    ProjectileRing m_Bullets;
+    const Level* m_Level = nullptr;
+    FlowField m_Field;
+    Rng m_Rng;
+    ecs::Entity m_Players[MATCH_MAX_PLAYERS];
+    Bot m_Bots[MATCH_MAX_PLAYERS] = {};
+    int m_PlayerCount = 0;
+    uint32_t m_Tick = 0;
+    double m_Time = 0.0;
+    float m_SpawnTimer = 0.0f;
+    int m_Score = 0;
+    int m_Deaths = 0;
+};
+
+#endif
@@ -1,9 +1,10 @@
 #version 330 core
 
 uniform vec3 color;
+uniform float alpha = 1.0;
 out vec4 FragColor;
 
 void main()
 {
-    FragColor = vec4(color, 1.0);
+    FragColor = vec4(color, alpha);
 }
@@ -0,0 +1,353 @@
+#ifndef NAV_FIELD_H
+#define NAV_FIELD_H
+
+#include <glm/glm.hpp>
+
+#include "level.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Horde navigation. A NavGrid marks the cells of the level a body fits in; a
+// FlowField points every cell toward the nearest goal and is rebuilt only
+// when a goal changes cell.
+
+const float NAV_CELL_SIZE = 0.5f;
+const int NAV_MAX_GOALS = 8;
+
+class NavGrid {
+public:
+    // Blocked: a square body 2 * radius wide standing on 'feetY' anywhere in
+    // the cell could overlap a box above LEVEL_STEP_HEIGHT (what
+    // Level::collide would push it out of). Open cells are clear all over, so
+    // a body following the field never catches on a corner.
+    void build(const Level& level, float radius, float height, float feetY, float cellSize = NAV_CELL_SIZE)
+    {
+        float reach = radius + cellSize * 0.5f;
+        glm::vec3 min = level.boundsMin(), max = level.boundsMax();
+        m_CellSize = cellSize;
+        m_Origin = glm::vec2(min.x, min.z);
+        m_Width = std::max(1, (int)std::ceil((max.x - min.x) / cellSize));
+        m_Height = std::max(1, (int)std::ceil((max.z - min.z) / cellSize));
+        m_Blocked.assign((size_t)m_Width * m_Height, 0);
+        m_BlockedCount = 0;
+        for (int z = 0; z < m_Height; ++z)
+            for (int x = 0; x < m_Width; ++x)
+            {
+                glm::vec2 center = cellCenter(x, z);
+                glm::vec3 bodyMin(center.x - reach, feetY + LEVEL_STEP_HEIGHT, center.y - reach);
+                glm::vec3 bodyMax(center.x + reach, feetY + height, center.y + reach);
+                if (level.overlaps(bodyMin, bodyMax))
+                {
+                    m_Blocked[(size_t)z * m_Width + x] = 1;
+                    m_BlockedCount++;
+                }
+            }
+
+        // Blocked cells summed over every rectangle from the origin
+        int stride = m_Width + 1;
+        m_BlockedSum.assign((size_t)stride * (m_Height + 1), 0);
+        for (int z = 0; z < m_Height; ++z)
+            for (int x = 0; x < m_Width; ++x)
+                m_BlockedSum[(z + 1) * stride + x + 1] = m_Blocked[(size_t)z * m_Width + x] +
+                    m_BlockedSum[z * stride + x + 1] + m_BlockedSum[(z + 1) * stride + x] - m_BlockedSum[z * stride + x];
+    }
+
+    int width() const { return m_Width; }
+    int height() const { return m_Height; }
+    int cellCount() const { return m_Width * m_Height; }
+    int blockedCount() const { return m_BlockedCount; }
+    bool blocked(int cell) const { return m_Blocked[cell] != 0; }
+
+    // Blocked cells in the rectangle with corners (x0, z0) and (x1, z1),
+    // both included, in any order
+    int blockedIn(int x0, int z0, int x1, int z1) const
+    {
+        int stride = m_Width + 1;
+        int minX = std::min(x0, x1), maxX = std::max(x0, x1) + 1;
+        int minZ = std::min(z0, z1), maxZ = std::max(z0, z1) + 1;
+        return m_BlockedSum[maxZ * stride + maxX] - m_BlockedSum[minZ * stride + maxX] -
+            m_BlockedSum[maxZ * stride + minX] + m_BlockedSum[minZ * stride + minX];
+    }
+
+    // The cell under 'position', clamped to the grid
+    int cellOf(const glm::vec3& position) const
+    {
+        int x = glm::clamp((int)std::floor((position.x - m_Origin.x) / m_CellSize), 0, m_Width - 1);
+        int z = glm::clamp((int)std::floor((position.z - m_Origin.y) / m_CellSize), 0, m_Height - 1);
+        return z * m_Width + x;
+    }
+
+    glm::vec2 cellCenter(int x, int z) const
+    {
+        return m_Origin + (glm::vec2((float)x, (float)z) + glm::vec2(0.5f)) * m_CellSize;
+    }
+
+private:
+    float m_CellSize = NAV_CELL_SIZE;
+    glm::vec2 m_Origin = glm::vec2(0.0f);
+    int m_Width = 0;
+    int m_Height = 0;
+    int m_BlockedCount = 0;
+    std::vector<uint8_t> m_Blocked;
+    std::vector<int> m_BlockedSum;     // (width + 1) x (height + 1), see blockedIn
+};
+
+class FlowField {
+public:
+    // 'grid' has to outlive the field. Allocates everything the field will
+    // ever need.
+    void init(const NavGrid& grid)
+    {
+        m_Grid = &grid;
+        m_Cells.assign(grid.cellCount(), Cell{});
+        for (std::vector<int>& bucket : m_Buckets)
+        {
+            bucket.clear();
+            bucket.reserve(grid.cellCount() / 4);
+        }
+        m_GoalCount = 0;
+        m_Rebuilds = 0;
+    }
+
+    // Moves the goals to 'goals'. The field is recomputed only when one of
+    // them is in another cell than last time (or their number changed).
+    // Returns whether it was.
+    bool update(const glm::vec3* goals, int count)
+    {
+        count = std::min(count, NAV_MAX_GOALS);
+        bool changed = count != m_GoalCount;
+        for (int i = 0; i < count; ++i)
+        {
+            int cell = m_Grid->cellOf(goals[i]);
+            changed = changed || cell != m_GoalCells[i];
+            m_Goals[i] = goals[i];
+            m_GoalCells[i] = cell;
+        }
+        m_GoalCount = count;
+        if (changed)
+            rebuild();
+        return changed;
+    }
+
+    // Which way a body at 'position' walks (unit length, y = 0). False when
+    // it is within 'arriveDistance' of its goal or no goal can be reached.
+    bool steer(const glm::vec3& position, float arriveDistance, glm::vec3& direction) const
+    {
+        if (m_GoalCount == 0)
+            return false;
+        const Cell& cell = m_Cells[m_Grid->cellOf(position)];
+        if (cell.cost == UNREACHED)
+            return false;
+        if (cell.direct)
+        {
+            glm::vec3 toGoal = m_Goals[cell.goal] - position;
+            toGoal.y = 0.0f;
+            float distance = glm::length(toGoal);
+            if (distance <= arriveDistance)
+                return false;
+            direction = toGoal / distance;
+            return true;
+        }
+        direction = glm::vec3(cell.direction.x, 0.0f, cell.direction.y);
+        return true;
+    }
+
+    int rebuilds() const { return m_Rebuilds; }
+
+private:
+    static const uint32_t UNREACHED = 0xFFFFFFFFu;
+    static const uint32_t STRAIGHT_COST = 10;     // octile distance in tenths of a cell
+    static const uint32_t DIAGONAL_COST = 14;
+
+    struct Cell {
+        glm::vec2 direction = glm::vec2(0.0f);      // toward the cheapest neighbour, when not direct
+        uint32_t cost = UNREACHED;
+        uint8_t goal = 0;                           // index into m_Goals of the goal it leads to
+        uint8_t direct = 0;
+    };
+
+    void rebuild()
+    {
+        m_Rebuilds++;
+        for (Cell& cell : m_Cells)
+            cell = Cell{};
+        size_t queued = 0;
+        for (int i = m_GoalCount - 1; i >= 0; --i)
+        {
+            // Earlier goals win ties; a goal inside a blocked cell still
+            // spreads out of it
+            Cell& cell = m_Cells[m_GoalCells[i]];
+            cell.cost = 0;
+            cell.goal = (uint8_t)i;
+            m_Buckets[0].push_back(m_GoalCells[i]);
+            queued++;
+        }
+
+        // Dijkstra with a bucket per cost: steps cost STRAIGHT_COST or
+        // DIAGONAL_COST, so every queued cell is within DIAGONAL_COST of the
+        // cheapest and the buckets can wrap around
+        int width = m_Grid->width(), height = m_Grid->height();
+        for (uint32_t cost = 0; queued > 0; ++cost)
+        {
+            std::vector<int>& bucket = m_Buckets[cost % BUCKETS];
+            for (size_t b = 0; b < bucket.size(); ++b)
+            {
+                int index = bucket[b];
+                if (cost != m_Cells[index].cost)
+                    continue;       // a cheaper way here was found after this was queued
+
+                int x = index % width, z = index / width;
+                for (int dz = -1; dz <= 1; ++dz)
+                    for (int dx = -1; dx <= 1; ++dx)
+                    {
+                        int nx = x + dx, nz = z + dz;
+                        if ((dx == 0 && dz == 0) || nx < 0 || nz < 0 || nx >= width || nz >= height)
+                            continue;
+                        int neighbour = nz * width + nx;
+                        if (m_Grid->blocked(neighbour) || (dx != 0 && dz != 0 && !canCutCorner(x, z, dx, dz)))
+                            continue;
+                        uint32_t next = cost + (dx != 0 && dz != 0 ? DIAGONAL_COST : STRAIGHT_COST);
+                        Cell& cell = m_Cells[neighbour];
+                        if (next >= cell.cost)
+                            continue;
+                        cell.cost = next;
+                        cell.goal = m_Cells[index].goal;
+                        m_Buckets[next % BUCKETS].push_back(neighbour);
+                        queued++;
+                    }
+            }
+            queued -= bucket.size();
+            bucket.clear();
+        }
+
+        for (int z = 0; z < height; ++z)
+            for (int x = 0; x < width; ++x)
+            {
+                Cell& cell = m_Cells[z * width + x];
+                if (cell.cost != UNREACHED && !m_Grid->blocked(z * width + x))
+                    pointDownhill(x, z, cell);
+            }
+        // Bodies pushed against a wall can stand in a blocked cell: lead
+        // them back to the open neighbour closest to a goal
+        for (int z = 0; z < height; ++z)
+            for (int x = 0; x < width; ++x)
+                if (m_Grid->blocked(z * width + x) && m_Cells[z * width + x].cost != 0)
+                    leadOut(x, z);
+    }
+
+    bool canCutCorner(int x, int z, int dx, int dz) const
+    {
+        int width = m_Grid->width();
+        return !m_Grid->blocked(z * width + x + dx) && !m_Grid->blocked((z + dz) * width + x);
+    }
+
+    // Whether every cell the segment between the two cell centres passes
+    // through is open, the end cell aside (a goal may stand in a blocked
+    // one). Where it crosses a corner exactly, both cells beside it have to
+    // be open, as for a diagonal step.
+    bool clearLine(int x0, int z0, int x1, int z1) const
+    {
+        int width = m_Grid->width();
+        int endBlocked = m_Grid->blocked(z1 * width + x1) ? 1 : 0;
+        if (m_Grid->blockedIn(x0, z0, x1, z1) == endBlocked)
+            return true;        // nothing in the way, whichever cells the line crosses
+
+        int nx = std::abs(x1 - x0), nz = std::abs(z1 - z0);
+        int sx = x1 > x0 ? 1 : -1, sz = z1 > z0 ? 1 : -1;
+        int x = x0, z = z0;
+        for (int ix = 0, iz = 0; ix < nx || iz < nz;)
+        {
+            // Which cell border comes first along the segment: compare
+            // (ix + 1/2) / nx with (iz + 1/2) / nz
+            int along = (2 * ix + 1) * nz - (2 * iz + 1) * nx;
+            if (iz == nz || (ix < nx && along < 0))
+            {
+                x += sx;
+                ix++;
+            }
+            else if (ix == nx || along > 0)
+            {
+                z += sz;
+                iz++;
+            }
+            else
+            {
+                if (m_Grid->blocked(z * width + x + sx) || m_Grid->blocked((z + sz) * width + x))
+                    return false;
+                x += sx;
+                z += sz;
+                ix++;
+                iz++;
+            }
+            if ((ix < nx || iz < nz) && m_Grid->blocked(z * width + x))
+                return false;
+        }
+        return true;
+    }
+
+    void pointDownhill(int x, int z, Cell& cell)
+    {
+        int width = m_Grid->width();
+        int gx = m_GoalCells[cell.goal] % width, gz = m_GoalCells[cell.goal] / width;
+        int ax = std::abs(gx - x), az = std::abs(gz - z);
+        uint32_t octile = STRAIGHT_COST * (uint32_t)std::max(ax, az) + (DIAGONAL_COST - STRAIGHT_COST) * (uint32_t)std::min(ax, az);
+        // A path as cheap as the octile distance can still bend around a
+        // wall; only a clear straight line lets the body aim at the goal
+        cell.direct = cell.cost == octile && clearLine(x, z, gx, gz) ? 1 : 0;
+        if (cell.direct)
+            return;
+
+        uint32_t best = cell.cost;
+        for (int dz = -1; dz <= 1; ++dz)
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                int nx = x + dx, nz = z + dz;
+                if ((dx == 0 && dz == 0) || nx < 0 || nz < 0 || nx >= width || nz >= m_Grid->height())
+                    continue;
+                int neighbour = nz * width + nx;
+                if (m_Grid->blocked(neighbour) || (dx != 0 && dz != 0 && !canCutCorner(x, z, dx, dz)))
+                    continue;
+                if (m_Cells[neighbour].cost < best)
+                {
+                    best = m_Cells[neighbour].cost;
+                    cell.direction = glm::normalize(glm::vec2((float)dx, (float)dz));
+                }
+            }
+    }
+
+    void leadOut(int x, int z)
+    {
+        int width = m_Grid->width();
+        Cell& cell = m_Cells[z * width + x];
+        uint32_t best = UNREACHED;
+        for (int dz = -1; dz <= 1; ++dz)
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                int nx = x + dx, nz = z + dz;
+                if ((dx == 0 && dz == 0) || nx < 0 || nz < 0 || nx >= width || nz >= m_Grid->height())
+                    continue;
+                int neighbour = nz * width + nx;
+                if (m_Grid->blocked(neighbour) || m_Cells[neighbour].cost >= best)
+                    continue;
+                best = m_Cells[neighbour].cost;
+                cell.cost = best + STRAIGHT_COST;
+                cell.goal = m_Cells[neighbour].goal;
+                cell.direct = 0;
+                cell.direction = glm::normalize(glm::vec2((float)dx, (float)dz));
+            }
+    }
+
+    const NavGrid* m_Grid = nullptr;
+    std::vector<Cell> m_Cells;
+    static const int BUCKETS = DIAGONAL_COST + 1;
+    std::vector<int> m_Buckets[BUCKETS];
+    glm::vec3 m_Goals[NAV_MAX_GOALS];
+    int m_GoalCells[NAV_MAX_GOALS] = {};
+    int m_GoalCount = 0;
+    int m_Rebuilds = 0;
+};
+
+#endif
@@ -0,0 +1,638 @@
+#ifndef NET_PROTOCOL_H
+#define NET_PROTOCOL_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Wire format of the co-op netcode. Pure data, no sockets, so the benchmarks
+// can measure snapshot sizes without a network.
+//
+// Every packet starts with NET_PROTOCOL_ID (32 bits) and a NetPacketType
+// (8 bits); the rest is bit packed, least significant bit first.
+//
+// Clients send their input every tick, repeating the last few inputs so a
+// lost packet costs nothing, and ack the newest snapshot they have. The
+// server sends snapshots at a lower rate, delta compressed against the
+// newest snapshot that client acked:
+//
+//   - positions are 16 bits per axis over +-NET_WORLD_EXTENT, and an update
+//     is an 8 bit delta from the baseline when the entity moved little
+//   - entities the baseline already has unchanged cost nothing
+//   - bullets are sent once; they fly in a straight line, so the client
+//     moves them itself until the server removes them
+//   - a snapshot has a byte budget. Entities that do not fit keep their
+//     baseline value and are sent later, most out of date first, so the
+//     cost per client stays flat however many enemies there are. Players
+//     go first, then removals and new entities.
+
+const uint32_t NET_PROTOCOL_ID = 0x4E59584E;    // "NYXN"
+const uint16_t NET_DEFAULT_PORT = 27960;
+const size_t NET_MAX_PACKET = 1200;              // stays under a typical MTU
+const size_t NET_SNAPSHOT_BUDGET = 1100;         // bytes of entity data per snapshot
+const float NET_WORLD_EXTENT = 16.0f;            // networked levels have to fit in +-this
+const uint16_t NET_BULLET_ID_BASE = 0x8000;     // bullets: this + low 15 bits of their serial
+const int NET_YAW_BITS = 10;
+const int NET_MAX_PLAYERS = 4;                   // slot 0 is the host
+const int NET_INPUT_REDUNDANCY = 8;              // inputs repeated in every input packet
+const int NET_SNAPSHOT_HISTORY = 32;             // baselines kept on each side
+const int NET_SNAPSHOT_RATE = 20;                // per second
+
+// The snapshot header (writeSnapshotPacket) takes at most 23 bytes
+static_assert(NET_SNAPSHOT_BUDGET + 24 <= NET_MAX_PACKET, "a full snapshot has to fit in one packet");
+
+enum NetPacketType : uint8_t {
+    NET_CONNECT = 1,
+    NET_ACCEPT,         // slot 8, sim hz 16, server tick 32
+    NET_REJECT,
+    NET_DISCONNECT,
+    NET_INPUT,
+    NET_SNAPSHOT,
+    NET_KEEPALIVE,      // sent when nothing else was for a while (paused, in a menu)
+};
+
+// ==================== BIT PACKING ====================
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : m_Out(out) { m_Out.clear(); }
+
+    void write(uint32_t value, int bits)
+    {
+        uint64_t mask = bits >= 32 ? 0xFFFFFFFFull : ((1ull << bits) - 1);
+        m_Scratch |= ((uint64_t)value & mask) << m_ScratchBits;
+        m_ScratchBits += bits;
+        while (m_ScratchBits >= 8)
+        {
+            m_Out.push_back((uint8_t)m_Scratch);
+            m_Scratch >>= 8;
+            m_ScratchBits -= 8;
+        }
+    }
+
+    void writeBool(bool value) { write(value ? 1u : 0u, 1); }
+
+    // 2 bit size class, then 4, 8, 16 or 32 bits
+    void writeVarUint(uint32_t value)
+    {
+        if (value < (1u << 4)) { write(0, 2); write(value, 4); }
+        else if (value < (1u << 8)) { write(1, 2); write(value, 8); }
+        else if (value < (1u << 16)) { write(2, 2); write(value, 16); }
+        else { write(3, 2); write(value, 32); }
+    }
+
+    // Pads the last byte; call once at the end
+    void flush()
+    {
+        if (m_ScratchBits > 0)
+            m_Out.push_back((uint8_t)m_Scratch);
+        m_Scratch = 0;
+        m_ScratchBits = 0;
+    }
+
+    size_t bits() const { return m_Out.size() * 8 + m_ScratchBits; }
+
+private:
+    std::vector<uint8_t>& m_Out;
+    uint64_t m_Scratch = 0;
+    int m_ScratchBits = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : m_Data(data), m_Size(size) {}
+
+    // Reads past the end return 0 and set overflowed()
+    uint32_t read(int bits)
+    {
+        while (m_ScratchBits < bits)
+        {
+            if (m_Position >= m_Size)
+            {
+                m_Overflowed = true;
+                return 0;
+            }
+            m_Scratch |= (uint64_t)m_Data[m_Position++] << m_ScratchBits;
+            m_ScratchBits += 8;
+        }
+        uint64_t mask = bits >= 32 ? 0xFFFFFFFFull : ((1ull << bits) - 1);
+        uint32_t value = (uint32_t)(m_Scratch & mask);
+        m_Scratch >>= bits;
+        m_ScratchBits -= bits;
+        return value;
+    }
+
+    bool readBool() { return read(1) != 0; }
+
+    uint32_t readVarUint()
+    {
+        static const int SIZES[4] = { 4, 8, 16, 32 };
+        return read(SIZES[read(2)]);
+    }
+
+    bool overflowed() const { return m_Overflowed; }
+
+private:
+    const uint8_t* m_Data;
+    size_t m_Size;
+    size_t m_Position = 0;
+    uint64_t m_Scratch = 0;
+    int m_ScratchBits = 0;
+    bool m_Overflowed = false;
+};
+
+inline void writePacketHeader(BitWriter& writer, NetPacketType type)
+{
+    writer.write(NET_PROTOCOL_ID, 32);
+    writer.write(type, 8);
+}
+
+// Returns the packet type, 0 if the packet is not ours
+inline uint8_t readPacketHeader(BitReader& reader)
+{
+    if (reader.read(32) != NET_PROTOCOL_ID)
+        return 0;
+    uint8_t type = (uint8_t)reader.read(8);
+    return reader.overflowed() ? 0 : type;
+}
+
+// ==================== QUANTIZATION ====================
+inline uint16_t quantizeCoord(float value)
+{
+    float t = (glm::clamp(value, -NET_WORLD_EXTENT, NET_WORLD_EXTENT) + NET_WORLD_EXTENT) / (2.0f * NET_WORLD_EXTENT);
+    return (uint16_t)std::lround(t * 65535.0f);
+}
+
+inline float dequantizeCoord(uint16_t q)
+{
+    return q / 65535.0f * (2.0f * NET_WORLD_EXTENT) - NET_WORLD_EXTENT;
+}
+
+// Degrees, wrapped to [0, 360)
+inline uint32_t quantizeAngle(float degrees, int bits)
+{
+    float t = std::fmod(degrees, 360.0f);
+    if (t < 0.0f)
+        t += 360.0f;
+    return (uint32_t)std::lround(t / 360.0f * (float)(1u << bits)) & ((1u << bits) - 1);
+}
+
+inline float dequantizeAngle(uint32_t q, int bits)
+{
+    return q * 360.0f / (float)(1u << bits);
+}
+
+// [-1, 1]
+inline int16_t quantizeUnit(float value)
+{
+    return (int16_t)std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+inline float dequantizeUnit(int16_t q)
+{
+    return q / 32767.0f;
+}
+
+// ==================== INPUT ====================
+const int NET_INPUT_BUTTON_BITS = 5;    // movement and fire (InputButton bits 0..4)
+
+struct NetInput {
+    uint32_t sequence;
+    uint32_t buttons;
+    uint32_t pressed;
+    float yaw;          // degrees, already quantized: the client predicts with
+    float pitch;        // exactly what the server will see
+};
+
+// Rounds yaw and pitch to what survives the wire
+inline void quantizeInput(NetInput& input)
+{
+    uint32_t buttonMask = (1u << NET_INPUT_BUTTON_BITS) - 1;
+    input.buttons &= buttonMask;
+    input.pressed &= buttonMask;
+    input.yaw = dequantizeAngle(quantizeAngle(input.yaw, 16), 16);
+    input.pitch = dequantizeAngle(quantizeAngle(input.pitch, 16), 16);
+    if (input.pitch > 180.0f)
+        input.pitch -= 360.0f;
+}
+
+// 'inputs' newest first, at most NET_INPUT_REDUNDANCY, consecutive sequences.
+// ackTick = newest snapshot the client has, hasAck false before the first.
+inline void writeInputPacket(std::vector<uint8_t>& out, const NetInput* inputs, int count, bool hasAck, uint32_t ackTick)
+{
+    BitWriter writer(out);
+    writePacketHeader(writer, NET_INPUT);
+    writer.writeBool(hasAck);
+    writer.write(ackTick, 32);
+    writer.write(inputs[0].sequence, 32);
+    writer.write((uint32_t)count - 1, 3);
+    for (int i = 0; i < count; ++i)
+    {
+        writer.write(inputs[i].buttons, NET_INPUT_BUTTON_BITS);
+        writer.write(inputs[i].pressed, NET_INPUT_BUTTON_BITS);
+        writer.write(quantizeAngle(inputs[i].yaw, 16), 16);
+        writer.write(quantizeAngle(inputs[i].pitch, 16), 16);
+    }
+    writer.flush();
+}
+
+// After readPacketHeader. Returns the number of inputs, newest first.
+inline int readInputPacket(BitReader& reader, NetInput* inputs, bool& hasAck, uint32_t& ackTick)
+{
+    hasAck = reader.readBool();
+    ackTick = reader.read(32);
+    uint32_t newest = reader.read(32);
+    int count = (int)reader.read(3) + 1;
+    for (int i = 0; i < count; ++i)
+    {
+        inputs[i].sequence = newest - (uint32_t)i;
+        inputs[i].buttons = reader.read(NET_INPUT_BUTTON_BITS);
+        inputs[i].pressed = reader.read(NET_INPUT_BUTTON_BITS);
+        inputs[i].yaw = dequantizeAngle(reader.read(16), 16);
+        inputs[i].pitch = dequantizeAngle(reader.read(16), 16);
+        if (inputs[i].pitch > 180.0f)
+            inputs[i].pitch -= 360.0f;
+    }
+    return reader.overflowed() ? 0 : count;
+}
+
+// ==================== SNAPSHOTS ====================
+enum NetEntityType : uint8_t {
+    NET_ENTITY_PLAYER = 0,
+    NET_ENTITY_TARGET,
+    NET_ENTITY_BULLET,
+};
+
+struct NetEntity {
+    uint16_t id;            // server entity index, or NET_BULLET_ID_BASE + bullet serial
+    uint8_t generation;     // low bits of the entity generation: a reused id is a new entity
+    uint8_t type;           // NetEntityType
+    uint16_t position[3];
+    // bullets
+    int16_t direction[3];
+    uint16_t speed;         // units/s * 64
+    // players
+    uint8_t slot;
+    uint16_t yaw;           // NET_YAW_BITS
+    uint8_t health;         // 0..127
+    uint8_t clip;           // locomotion clip, 0..15
+    uint8_t dead;
+};
+
+struct NetSnapshot {
+    uint32_t tick = 0;
+    uint32_t score = 0;
+    std::vector<NetEntity> entities;    // sorted by id
+};
+
+inline glm::vec3 netPosition(const NetEntity& e)
+{
+    return glm::vec3(dequantizeCoord(e.position[0]), dequantizeCoord(e.position[1]), dequantizeCoord(e.position[2]));
+}
+
+inline void setNetPosition(NetEntity& e, const glm::vec3& p)
+{
+    e.position[0] = quantizeCoord(p.x);
+    e.position[1] = quantizeCoord(p.y);
+    e.position[2] = quantizeCoord(p.z);
+}
+
+namespace netdetail {
+
+enum Op : uint32_t { OP_END = 0, OP_NEW, OP_UPDATE, OP_REMOVE };
+
+const int SMALL_DELTA = 127;
+
+inline bool playerStateDiffers(const NetEntity& a, const NetEntity& b)
+{
+    return a.slot != b.slot || a.yaw != b.yaw || a.health != b.health || a.clip != b.clip || a.dead != b.dead;
+}
+
+inline bool positionDiffers(const NetEntity& a, const NetEntity& b)
+{
+    return a.position[0] != b.position[0] || a.position[1] != b.position[1] || a.position[2] != b.position[2];
+}
+
+// Largest per-axis difference in quanta
+inline int positionError(const NetEntity& a, const NetEntity& b)
+{
+    int error = 0;
+    for (int axis = 0; axis < 3; ++axis)
+        error = std::max(error, std::abs((int)a.position[axis] - (int)b.position[axis]));
+    return error;
+}
+
+inline void writePlayerState(BitWriter& writer, const NetEntity& e)
+{
+    writer.write(e.slot, 2);
+    writer.write(e.yaw, NET_YAW_BITS);
+    writer.write(e.health, 7);
+    writer.write(e.clip, 4);
+    writer.writeBool(e.dead != 0);
+}
+
+inline void readPlayerState(BitReader& reader, NetEntity& e)
+{
+    e.slot = (uint8_t)reader.read(2);
+    e.yaw = (uint16_t)reader.read(NET_YAW_BITS);
+    e.health = (uint8_t)reader.read(7);
+    e.clip = (uint8_t)reader.read(4);
+    e.dead = reader.readBool() ? 1 : 0;
+}
+
+inline void writeNew(BitWriter& writer, const NetEntity& e)
+{
+    writer.write(e.generation, 8);
+    writer.write(e.type, 2);
+    for (int axis = 0; axis < 3; ++axis)
+        writer.write(e.position[axis], 16);
+    if (e.type == NET_ENTITY_BULLET)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+            writer.write((uint16_t)e.direction[axis], 16);
+        writer.write(e.speed, 16);
+    }
+    else if (e.type == NET_ENTITY_PLAYER)
+        writePlayerState(writer, e);
+}
+
+inline void readNew(BitReader& reader, NetEntity& e)
+{
+    e = NetEntity();
+    e.generation = (uint8_t)reader.read(8);
+    e.type = (uint8_t)reader.read(2);
+    for (int axis = 0; axis < 3; ++axis)
+        e.position[axis] = (uint16_t)reader.read(16);
+    if (e.type == NET_ENTITY_BULLET)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+            e.direction[axis] = (int16_t)(uint16_t)reader.read(16);
+        e.speed = (uint16_t)reader.read(16);
+    }
+    else if (e.type == NET_ENTITY_PLAYER)
+        readPlayerState(reader, e);
+}
+
+inline void writeUpdate(BitWriter& writer, const NetEntity& e, const NetEntity& base)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        int delta = (int)e.position[axis] - (int)base.position[axis];
+        writer.writeBool(delta != 0);
+        if (delta == 0)
+            continue;
+        bool small = std::abs(delta) <= SMALL_DELTA;
+        writer.writeBool(small);
+        if (small)
+            writer.write((uint32_t)(delta + SMALL_DELTA), 8);
+        else
+            writer.write(e.position[axis], 16);
+    }
+    if (e.type == NET_ENTITY_PLAYER)
+    {
+        bool changed = playerStateDiffers(e, base);
+        writer.writeBool(changed);
+        if (changed)
+            writePlayerState(writer, e);
+    }
+}
+
+inline void readUpdate(BitReader& reader, NetEntity& e)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (!reader.readBool())
+            continue;
+        if (reader.readBool())
+            e.position[axis] = (uint16_t)((int)e.position[axis] + (int)reader.read(8) - SMALL_DELTA);
+        else
+            e.position[axis] = (uint16_t)reader.read(16);
+    }
+    if (e.type == NET_ENTITY_PLAYER && reader.readBool())
+        readPlayerState(reader, e);
+}
+
+// Bits writeNew / writeUpdate will use, without the op and id
+inline size_t newBits(const NetEntity& e)
+{
+    size_t bits = 8 + 2 + 48;
+    if (e.type == NET_ENTITY_BULLET)
+        bits += 64;
+    else if (e.type == NET_ENTITY_PLAYER)
+        bits += 24;
+    return bits;
+}
+
+inline size_t updateBits(const NetEntity& e, const NetEntity& base)
+{
+    size_t bits = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        int delta = (int)e.position[axis] - (int)base.position[axis];
+        bits += delta == 0 ? 1 : (std::abs(delta) <= SMALL_DELTA ? 10 : 18);
+    }
+    if (e.type == NET_ENTITY_PLAYER)
+        bits += playerStateDiffers(e, base) ? 25 : 1;
+    return bits;
+}
+
+inline size_t varUintBits(uint32_t value)
+{
+    return 2 + (value < (1u << 4) ? 4 : value < (1u << 8) ? 8 : value < (1u << 16) ? 16 : 32);
+}
+
+struct Candidate {
+    uint32_t op;
+    int current;            // index into the current snapshot, -1 for removals
+    int baseline;           // index into the baseline, -1 for new entities
+    int priority;
+    bool selected;
+};
+
+} // namespace netdetail
+
+// Reusable scratch for writeSnapshot, so a steady server does not allocate
+struct SnapshotEncoder {
+    std::vector<netdetail::Candidate> candidates;
+    std::vector<int> order;
+};
+
+// Writes 'current' as a delta from 'baseline' (nullptr = from nothing),
+// spending at most budgetBytes on entities. Unsent changes show up again in
+// the next snapshot's delta.
+inline void writeSnapshotEntities(BitWriter& writer, const NetSnapshot& current, const NetSnapshot* baseline,
+    size_t budgetBytes, SnapshotEncoder& scratch)
+{
+    using namespace netdetail;
+    static const NetSnapshot EMPTY;
+    const NetSnapshot& base = baseline ? *baseline : EMPTY;
+
+    // Everything that differs from the baseline, in id order
+    std::vector<Candidate>& candidates = scratch.candidates;
+    candidates.clear();
+    size_t i = 0, j = 0;
+    while (i < current.entities.size() || j < base.entities.size())
+    {
+        if (j < base.entities.size() && (i == current.entities.size() || base.entities[j].id < current.entities[i].id))
+        {
+            candidates.push_back({ OP_REMOVE, -1, (int)j, INT32_MAX - 1, false });
+            j++;
+            continue;
+        }
+        const NetEntity& e = current.entities[i];
+        if (j < base.entities.size() && base.entities[j].id == e.id)
+        {
+            const NetEntity& b = base.entities[j];
+            if (b.generation != e.generation || b.type != e.type)
+                candidates.push_back({ OP_NEW, (int)i, (int)j, e.type == NET_ENTITY_PLAYER ? INT32_MAX : INT32_MAX - 1, false });
+            else if (e.type == NET_ENTITY_PLAYER && (positionDiffers(e, b) || playerStateDiffers(e, b)))
+                candidates.push_back({ OP_UPDATE, (int)i, (int)j, INT32_MAX, false });
+            else if (e.type == NET_ENTITY_TARGET && positionDiffers(e, b))
+                candidates.push_back({ OP_UPDATE, (int)i, (int)j, positionError(e, b), false });
+            i++;
+            j++;
+        }
+        else
+        {
+            candidates.push_back({ OP_NEW, (int)i, -1, e.type == NET_ENTITY_PLAYER ? INT32_MAX : INT32_MAX - 1, false });
+            i++;
+        }
+    }
+
+    // Most important first while they fit. Players come first and always
+    // fit (NET_MAX_PLAYERS of them are far under any budget); a removal
+    // that does not fit waits like an update, the entity stays in the
+    // baseline until it is sent.
+    std::vector<int>& order = scratch.order;
+    order.resize(candidates.size());
+    for (size_t c = 0; c < candidates.size(); ++c)
+        order[c] = (int)c;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        if (candidates[a].priority != candidates[b].priority)
+            return candidates[a].priority > candidates[b].priority;
+        return a < b;
+    });
+
+    // Id deltas depend on what else is sent, so cost them at their worst
+    size_t budgetBits = budgetBytes * 8;
+    size_t usedBits = 2;    // OP_END
+    for (int c : order)
+    {
+        Candidate& candidate = candidates[c];
+        size_t bits = 2 + varUintBits(0xFFFF);
+        if (candidate.op == OP_NEW)
+            bits += newBits(current.entities[candidate.current]);
+        else if (candidate.op == OP_UPDATE)
+            bits += updateBits(current.entities[candidate.current], base.entities[candidate.baseline]);
+        if (usedBits + bits > budgetBits)
+            continue;
+        usedBits += bits;
+        candidate.selected = true;
+    }
+
+    uint32_t previousId = 0;
+    for (const Candidate& candidate : candidates)
+    {
+        if (!candidate.selected)
+            continue;
+        const NetEntity& e = candidate.current >= 0 ? current.entities[candidate.current] : base.entities[candidate.baseline];
+        writer.write(candidate.op, 2);
+        writer.writeVarUint(e.id - previousId);
+        previousId = e.id;
+        if (candidate.op == OP_NEW)
+            writeNew(writer, e);
+        else if (candidate.op == OP_UPDATE)
+            writeUpdate(writer, e, base.entities[candidate.baseline]);
+    }
+    writer.write(OP_END, 2);
+}
+
+// Rebuilds the entity list the writer described. False on a malformed packet.
+inline bool readSnapshotEntities(BitReader& reader, const NetSnapshot* baseline, std::vector<NetEntity>& out)
+{
+    using namespace netdetail;
+    static const NetSnapshot EMPTY;
+    const NetSnapshot& base = baseline ? *baseline : EMPTY;
+
+    out.clear();
+    size_t j = 0;
+    uint32_t id = 0;
+    for (;;)
+    {
+        uint32_t op = reader.read(2);
+        if (reader.overflowed())
+            return false;
+        if (op == OP_END)
+            break;
+        id += reader.readVarUint();
+
+        // Untouched entities before this one carry over
+        while (j < base.entities.size() && base.entities[j].id < id)
+            out.push_back(base.entities[j++]);
+        bool inBaseline = j < base.entities.size() && base.entities[j].id == id;
+
+        if (op == OP_NEW)
+        {
+            NetEntity e;
+            readNew(reader, e);
+            e.id = (uint16_t)id;
+            out.push_back(e);
+        }
+        else if (op == OP_UPDATE)
+        {
+            if (!inBaseline)
+                return false;
+            NetEntity e = base.entities[j];
+            readUpdate(reader, e);
+            out.push_back(e);
+        }
+        else if (!inBaseline)       // OP_REMOVE
+            return false;
+        if (inBaseline)
+            j++;
+    }
+    while (j < base.entities.size())
+        out.push_back(base.entities[j++]);
+    return !reader.overflowed();
+}
+
+struct SnapshotHeader {
+    uint32_t tick;
+    bool hasBaseline;
+    uint32_t baselineTick;
+    uint32_t lastInput;     // newest input of the receiving client the server has applied
+    uint32_t score;
+};
+
+inline void writeSnapshotPacket(std::vector<uint8_t>& out, const NetSnapshot& current, const NetSnapshot* baseline,
+    uint32_t lastInput, SnapshotEncoder& scratch)
+{
+    BitWriter writer(out);
+    writePacketHeader(writer, NET_SNAPSHOT);
+    writer.write(current.tick, 32);
+    writer.writeBool(baseline != nullptr);
+    writer.write(baseline ? baseline->tick : 0, 32);
+    writer.write(lastInput, 32);
+    writer.writeVarUint(current.score);
+    writeSnapshotEntities(writer, current, baseline, NET_SNAPSHOT_BUDGET, scratch);
+    writer.flush();
+    assert(out.size() <= NET_MAX_PACKET);
+}
+
+// After readPacketHeader; the entities follow (readSnapshotEntities)
+inline SnapshotHeader readSnapshotHeader(BitReader& reader)
+{
+    SnapshotHeader header;
+    header.tick = reader.read(32);
+    header.hasBaseline = reader.readBool();
+    header.baselineTick = reader.read(32);
+    header.lastInput = reader.read(32);
+    header.score = reader.readVarUint();
+    return header;
+}
+
+#endif
@@ -0,0 +1,587 @@
+#ifndef NET_SESSION_H
+#define NET_SESSION_H
+
+#include "net_protocol.h"
+#include "net_socket.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+// Connection handling on top of net_protocol.h.
+//
+// NetServer: up to NET_MAX_PLAYERS - 1 clients (slot 0 is the host's own
+// player). Buffers each client's input by sequence and hands out one per
+// tick, sends each client snapshots delta compressed against the newest one
+// it acked.
+//
+// NetClient: connects, sends one NetInput per tick and keeps the ones the
+// server has not applied yet for prediction, rebuilds snapshots from deltas.
+//
+// Both sides pass everything they send through a LinkShim.
+
+const double NET_CONNECT_RETRY = 0.25;       // seconds between connect attempts
+const double NET_TIMEOUT = 5.0;              // silence before a peer is dropped
+const size_t NET_INPUT_QUEUE = 16;           // buffered inputs per client, oldest dropped beyond
+const double NET_KEEPALIVE_INTERVAL = 0.5;   // longest silence towards a peer
+
+struct NetTraffic {
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    int packetsSent = 0;
+    int packetsReceived = 0;
+};
+
+class NetServer {
+public:
+    bool start(uint16_t port, const LinkSettings& link, uint64_t seed)
+    {
+        if (!m_Socket.open(port))
+            return false;
+        m_Link.configure(link, seed);
+        std::cout << "[net] hosting on UDP port " << port << std::endl;
+        return true;
+    }
+
+    bool active() const { return m_Socket.isOpen(); }
+
+    void stop(double now)
+    {
+        if (!active())
+            return;
+        for (int slot = 1; slot < NET_MAX_PLAYERS; ++slot)
+        {
+            if (m_Clients[slot].connected)
+            {
+                sendControl(m_Clients[slot].address, NET_DISCONNECT, now);
+                removeClient(slot, now);
+            }
+        }
+        m_Link.flush(m_Socket, now + 1.0);
+        m_Socket.close();
+    }
+
+    // Reads every waiting packet and drops clients that went quiet
+    void receive(double now, uint32_t simHz, uint32_t tick)
+    {
+        if (!active())
+            return;
+        NetAddress from;
+        int bytes;
+        while ((bytes = m_Socket.receive(m_Packet, sizeof(m_Packet), from)) > 0)
+        {
+            BitReader reader(m_Packet, (size_t)bytes);
+            uint8_t type = readPacketHeader(reader);
+            int slot = findClient(from);
+            if (slot > 0)
+            {
+                m_Clients[slot].lastHeard = now;
+                m_Clients[slot].traffic.bytesReceived += bytes;
+                m_Clients[slot].traffic.packetsReceived++;
+            }
+
+            if (type == NET_CONNECT)
+            {
+                if (slot < 0)
+                    slot = addClient(from, now);
+                if (slot < 0)
+                    sendControl(from, NET_REJECT, now);
+                else
+                    sendAccept(slot, simHz, tick, now);
+            }
+            else if (type == NET_DISCONNECT && slot > 0)
+                removeClient(slot, now);
+            else if (type == NET_INPUT && slot > 0)
+                readInput(slot, reader);
+        }
+
+        for (int slot = 1; slot < NET_MAX_PLAYERS; ++slot)
+        {
+            if (m_Clients[slot].connected && now - m_Clients[slot].lastHeard > NET_TIMEOUT)
+            {
+                std::cout << "[net] client " << slot << " timed out" << std::endl;
+                removeClient(slot, now);
+            }
+        }
+    }
+
+    // Sends delayed packets that are due, and a keep-alive to clients that
+    // have not heard from us lately (no snapshots while the host is paused)
+    void flush(double now)
+    {
+        if (!active())
+            return;
+        for (int slot = 1; slot < NET_MAX_PLAYERS; ++slot)
+        {
+            if (m_Clients[slot].connected && now - m_Clients[slot].lastSent > NET_KEEPALIVE_INTERVAL)
+            {
+                BitWriter writer(m_Out);
+                writePacketHeader(writer, NET_KEEPALIVE);
+                writer.flush();
+                send(slot, m_Out, now);
+            }
+        }
+        m_Link.flush(m_Socket, now);
+    }
+
+    // Slots that connected / disconnected since the last call, -1 when none
+    int popJoined() { return popSlot(m_Joined); }
+    int popLeft() { return popSlot(m_Left); }
+
+    bool connected(int slot) const { return slot > 0 && slot < NET_MAX_PLAYERS && m_Clients[slot].connected; }
+
+    int clientCount() const
+    {
+        int count = 0;
+        for (int slot = 1; slot < NET_MAX_PLAYERS; ++slot)
+            count += m_Clients[slot].connected ? 1 : 0;
+        return count;
+    }
+
+    // The client's next input in sequence order, false if none has arrived
+    bool nextInput(int slot, NetInput& out)
+    {
+        Client& client = m_Clients[slot];
+        if (!client.connected || client.inputs.empty())
+            return false;
+        out = client.inputs.front();
+        client.inputs.pop_front();
+        client.lastApplied = out.sequence;
+        return true;
+    }
+
+    bool inputStale(int slot, double now, double seconds) const
+    {
+        return now - m_Clients[slot].lastInputTime > seconds;
+    }
+
+    // Sends 'state' to every client, each against its own acked baseline
+    void sendSnapshot(const NetSnapshot& state, double now)
+    {
+        for (int slot = 1; slot < NET_MAX_PLAYERS; ++slot)
+        {
+            Client& client = m_Clients[slot];
+            if (!client.connected)
+                continue;
+
+            const NetSnapshot* baseline = nullptr;
+            if (client.hasAck && client.history[client.ackTick % NET_SNAPSHOT_HISTORY].tick == client.ackTick)
+                baseline = &client.history[client.ackTick % NET_SNAPSHOT_HISTORY];
+            writeSnapshotPacket(m_Out, state, baseline, client.lastApplied, m_Encoder);
+
+            // Keep what the client will know once it decodes this, it is the
+            // baseline if this snapshot gets acked
+            NetSnapshot& sent = client.history[state.tick % NET_SNAPSHOT_HISTORY];
+            BitReader reader(m_Out.data(), m_Out.size());
+            readPacketHeader(reader);
+            SnapshotHeader header = readSnapshotHeader(reader);
+            sent.tick = header.tick;
+            sent.score = header.score;
+            readSnapshotEntities(reader, baseline, sent.entities);
+
+            send(slot, m_Out, now);
+            m_Snapshots++;
+            m_SnapshotBytes += m_Out.size();
+            if (!baseline)
+                m_FullSnapshots++;
+        }
+    }
+
+    const NetTraffic& traffic(int slot) const { return m_Clients[slot].traffic; }
+    double connectedSeconds(int slot, double now) const { return now - m_Clients[slot].connectedAt; }
+    int snapshotsSent() const { return m_Snapshots; }
+    int fullSnapshotsSent() const { return m_FullSnapshots; }
+    double averageSnapshotBytes() const { return m_Snapshots > 0 ? (double)m_SnapshotBytes / m_Snapshots : 0.0; }
+    const LinkShim& link() const { return m_Link; }
+
+private:
+    struct Client {
+        bool connected = false;
+        NetAddress address;
+        double connectedAt = 0.0;
+        double lastHeard = 0.0;
+        double lastInputTime = 0.0;
+        double lastSent = 0.0;
+        std::deque<NetInput> inputs;
+        uint32_t lastQueued = 0;        // newest sequence put in 'inputs'
+        uint32_t lastApplied = 0;
+        bool hasAck = false;
+        uint32_t ackTick = 0;
+        std::vector<NetSnapshot> history = std::vector<NetSnapshot>(NET_SNAPSHOT_HISTORY);
+        NetTraffic traffic;
+    };
+
+    int findClient(const NetAddress& address) const
+    {
+        for (int slot = 1; slot < NET_MAX_PLAYERS; ++slot)
+            if (m_Clients[slot].connected && m_Clients[slot].address == address)
+                return slot;
+        return -1;
+    }
+
+    int addClient(const NetAddress& address, double now)
+    {
+        for (int slot = 1; slot < NET_MAX_PLAYERS; ++slot)
+        {
+            if (m_Clients[slot].connected)
+                continue;
+            m_Clients[slot] = Client();
+            m_Clients[slot].connected = true;
+            m_Clients[slot].address = address;
+            m_Clients[slot].connectedAt = now;
+            m_Clients[slot].lastHeard = now;
+            m_Clients[slot].lastInputTime = now;
+            m_Clients[slot].lastSent = now;
+            m_Joined.push_back(slot);
+            std::cout << "[net] client " << slot << " connected" << std::endl;
+            return slot;
+        }
+        return -1;
+    }
+
+    void removeClient(int slot, double now)
+    {
+        Client& client = m_Clients[slot];
+        client.connected = false;
+        m_Left.push_back(slot);
+
+        double seconds = std::max(now - client.connectedAt, 0.001);
+        char line[160];
+        snprintf(line, sizeof(line), "[net] client %d left after %.0f s: %.2f KB/s to it, %.2f KB/s from it",
+            slot, seconds, client.traffic.bytesSent / 1024.0 / seconds, client.traffic.bytesReceived / 1024.0 / seconds);
+        std::cout << line << std::endl;
+    }
+
+    void readInput(int slot, BitReader& reader)
+    {
+        NetInput inputs[NET_INPUT_REDUNDANCY];
+        bool hasAck;
+        uint32_t ackTick;
+        int count = readInputPacket(reader, inputs, hasAck, ackTick);
+        if (count == 0)
+            return;
+
+        Client& client = m_Clients[slot];
+        if (hasAck && (!client.hasAck || (int32_t)(ackTick - client.ackTick) > 0))
+        {
+            client.hasAck = true;
+            client.ackTick = ackTick;
+        }
+
+        // Oldest first, skipping what is already queued or applied
+        for (int i = count - 1; i >= 0; --i)
+        {
+            if ((int32_t)(inputs[i].sequence - client.lastQueued) <= 0)
+                continue;
+            client.inputs.push_back(inputs[i]);
+            client.lastQueued = inputs[i].sequence;
+            client.lastInputTime = client.lastHeard;
+        }
+        while (client.inputs.size() > NET_INPUT_QUEUE)
+            client.inputs.pop_front();
+    }
+
+    void sendAccept(int slot, uint32_t simHz, uint32_t tick, double now)
+    {
+        BitWriter writer(m_Out);
+        writePacketHeader(writer, NET_ACCEPT);
+        writer.write((uint32_t)slot, 8);
+        writer.write(simHz, 16);
+        writer.write(tick, 32);
+        writer.flush();
+        send(slot, m_Out, now);
+    }
+
+    void sendControl(const NetAddress& to, NetPacketType type, double now)
+    {
+        BitWriter writer(m_Out);
+        writePacketHeader(writer, type);
+        writer.flush();
+        m_Link.send(m_Socket, to, m_Out.data(), m_Out.size(), now);
+    }
+
+    void send(int slot, const std::vector<uint8_t>& packet, double now)
+    {
+        m_Link.send(m_Socket, m_Clients[slot].address, packet.data(), packet.size(), now);
+        m_Clients[slot].lastSent = now;
+        m_Clients[slot].traffic.bytesSent += packet.size();
+        m_Clients[slot].traffic.packetsSent++;
+    }
+
+    static int popSlot(std::vector<int>& slots)
+    {
+        if (slots.empty())
+            return -1;
+        int slot = slots.front();
+        slots.erase(slots.begin());
+        return slot;
+    }
+
+    UdpSocket m_Socket;
+    LinkShim m_Link;
+    Client m_Clients[NET_MAX_PLAYERS];
+    std::vector<int> m_Joined;
+    std::vector<int> m_Left;
+    uint8_t m_Packet[NET_MAX_PACKET * 2];
+    std::vector<uint8_t> m_Out;
+    SnapshotEncoder m_Encoder;
+    int m_Snapshots = 0;
+    int m_FullSnapshots = 0;
+    uint64_t m_SnapshotBytes = 0;
+};
+
+class NetClient {
+public:
+    bool connect(const NetAddress& server, const LinkSettings& link, uint64_t seed)
+    {
+        if (!m_Socket.open(0))
+            return false;
+        m_Link.configure(link, seed);
+        m_Server = server;
+        m_Connecting = true;
+        m_NextConnect = 0.0;
+        return true;
+    }
+
+    bool active() const { return m_Socket.isOpen(); }
+    bool connecting() const { return m_Connecting; }
+    bool connected() const { return m_Connected; }
+    bool rejected() const { return m_Rejected; }
+    int slot() const { return m_Slot; }
+    uint32_t simHz() const { return m_SimHz; }
+    uint32_t serverTick() const { return m_ServerTick; }
+
+    void disconnect(double now)
+    {
+        if (!active())
+            return;
+        if (m_Connected)
+        {
+            BitWriter writer(m_Out);
+            writePacketHeader(writer, NET_DISCONNECT);
+            writer.flush();
+            m_Link.send(m_Socket, m_Server, m_Out.data(), m_Out.size(), now);
+            m_Link.flush(m_Socket, now + 1.0);
+        }
+        m_Connected = false;
+        m_Connecting = false;
+        m_Socket.close();
+    }
+
+    // Reads every waiting packet, retries connecting, notices a dead server
+    void receive(double now)
+    {
+        if (!active())
+            return;
+        if (m_Connecting && now >= m_NextConnect)
+        {
+            BitWriter writer(m_Out);
+            writePacketHeader(writer, NET_CONNECT);
+            writer.flush();
+            m_Link.send(m_Socket, m_Server, m_Out.data(), m_Out.size(), now);
+            m_NextConnect = now + NET_CONNECT_RETRY;
+            if (m_FirstConnect == 0.0)
+                m_FirstConnect = now;
+            else if (now - m_FirstConnect > NET_TIMEOUT)
+            {
+                std::cout << "ERROR::NET: no answer from the server" << std::endl;
+                m_Connecting = false;
+                m_Rejected = true;
+            }
+        }
+
+        NetAddress from;
+        int bytes;
+        while ((bytes = m_Socket.receive(m_Packet, sizeof(m_Packet), from)) > 0)
+        {
+            if (from != m_Server)
+                continue;
+            m_Traffic.bytesReceived += bytes;
+            m_Traffic.packetsReceived++;
+            m_LastHeard = now;
+
+            BitReader reader(m_Packet, (size_t)bytes);
+            uint8_t type = readPacketHeader(reader);
+            if (type == NET_ACCEPT && m_Connecting)
+            {
+                m_Slot = (int)reader.read(8);
+                m_SimHz = reader.read(16);
+                m_ServerTick = reader.read(32);
+                m_Connecting = false;
+                m_Connected = true;
+                m_ConnectedAt = now;
+                m_LastSent = now;
+                std::cout << "[net] connected as player " << m_Slot << ", server runs at " << m_SimHz << " Hz" << std::endl;
+            }
+            else if (type == NET_REJECT && m_Connecting)
+            {
+                std::cout << "ERROR::NET: server is full" << std::endl;
+                m_Connecting = false;
+                m_Rejected = true;
+            }
+            else if (type == NET_DISCONNECT && m_Connected)
+            {
+                std::cout << "[net] server closed the match" << std::endl;
+                m_Connected = false;
+            }
+            else if (type == NET_SNAPSHOT && m_Connected)
+                readSnapshot(reader, now);
+        }
+
+        if (m_Connected && now - m_LastHeard > NET_TIMEOUT)
+        {
+            std::cout << "[net] lost the server" << std::endl;
+            m_Connected = false;
+        }
+    }
+
+    // Sends delayed packets that are due, and a keep-alive when no input
+    // went out lately (paused)
+    void flush(double now)
+    {
+        if (!active())
+            return;
+        if (m_Connected && now - m_LastSent > NET_KEEPALIVE_INTERVAL)
+        {
+            BitWriter writer(m_Out);
+            writePacketHeader(writer, NET_KEEPALIVE);
+            writer.flush();
+            send(now);
+        }
+        m_Link.flush(m_Socket, now);
+    }
+
+    // Numbers and sends this tick's input, returns it as the server will see
+    // it (quantized) so the caller can predict with exactly that
+    NetInput sendInput(uint32_t buttons, uint32_t pressed, float yaw, float pitch, double now)
+    {
+        NetInput input;
+        input.sequence = ++m_Sequence;
+        input.buttons = buttons;
+        input.pressed = pressed;
+        input.yaw = yaw;
+        input.pitch = pitch;
+        quantizeInput(input);
+
+        m_History[input.sequence % HISTORY] = input;
+        m_SendTime[input.sequence % HISTORY] = now;
+
+        NetInput recent[NET_INPUT_REDUNDANCY];
+        int count = 0;
+        for (uint32_t seq = input.sequence; count < NET_INPUT_REDUNDANCY && seq > 0; --seq)
+            recent[count++] = m_History[seq % HISTORY];
+        writeInputPacket(m_Out, recent, count, m_HasSnapshot, m_LatestTick);
+        send(now);
+        return input;
+    }
+
+    // Newest snapshot since the last call, false if none arrived
+    bool takeSnapshot(const NetSnapshot*& snapshot, uint32_t& lastInput)
+    {
+        if (!m_NewSnapshot)
+            return false;
+        m_NewSnapshot = false;
+        snapshot = &m_Snapshots[m_LatestTick % NET_SNAPSHOT_HISTORY];
+        lastInput = m_LastInput;
+        return true;
+    }
+
+    // Sent inputs the server had not applied as of 'lastInput', oldest first
+    int pendingInputs(uint32_t lastInput, NetInput* out, int capacity) const
+    {
+        if (m_Sequence - lastInput > HISTORY)
+            lastInput = m_Sequence - HISTORY;
+        int count = 0;
+        for (uint32_t seq = lastInput + 1; seq <= m_Sequence && count < capacity; ++seq)
+            out[count++] = m_History[seq % HISTORY];
+        return count;
+    }
+
+    uint32_t sequence() const { return m_Sequence; }
+    const NetTraffic& traffic() const { return m_Traffic; }
+    double connectedSeconds(double now) const { return now - m_ConnectedAt; }
+    float rttMs() const { return m_RttMs; }
+    const LinkShim& link() const { return m_Link; }
+
+private:
+    static const uint32_t HISTORY = 128;    // inputs kept for prediction
+
+    void send(double now)
+    {
+        m_Link.send(m_Socket, m_Server, m_Out.data(), m_Out.size(), now);
+        m_LastSent = now;
+        m_Traffic.bytesSent += m_Out.size();
+        m_Traffic.packetsSent++;
+    }
+
+    void readSnapshot(BitReader& reader, double now)
+    {
+        SnapshotHeader header = readSnapshotHeader(reader);
+        if (m_HasSnapshot && (int32_t)(header.tick - m_LatestTick) <= 0)
+            return;     // old or duplicate
+
+        const NetSnapshot* baseline = nullptr;
+        if (header.hasBaseline)
+        {
+            baseline = &m_Snapshots[header.baselineTick % NET_SNAPSHOT_HISTORY];
+            if (baseline->tick != header.baselineTick)
+                return;     // baseline already overwritten, wait for a newer one
+        }
+
+        NetSnapshot& snapshot = m_Decoded;
+        snapshot.tick = header.tick;
+        snapshot.score = header.score;
+        if (!readSnapshotEntities(reader, baseline, snapshot.entities))
+            return;
+        std::swap(m_Snapshots[header.tick % NET_SNAPSHOT_HISTORY], snapshot);
+
+        m_HasSnapshot = true;
+        m_NewSnapshot = true;
+        m_LatestTick = header.tick;
+        m_LastInput = header.lastInput;
+
+        // Round trip of the input the server just confirmed (includes the
+        // time it sat in the server's input buffer)
+        if (header.lastInput > 0 && m_Sequence - header.lastInput < HISTORY)
+        {
+            float sample = (float)((now - m_SendTime[header.lastInput % HISTORY]) * 1000.0);
+            m_RttMs = m_RttMs == 0.0f ? sample : m_RttMs * 0.9f + sample * 0.1f;
+        }
+    }
+
+    UdpSocket m_Socket;
+    LinkShim m_Link;
+    NetAddress m_Server;
+    bool m_Connecting = false;
+    bool m_Connected = false;
+    bool m_Rejected = false;
+    double m_NextConnect = 0.0;
+    double m_FirstConnect = 0.0;
+    double m_LastHeard = 0.0;
+    double m_LastSent = 0.0;
+    double m_ConnectedAt = 0.0;
+    int m_Slot = -1;
+    uint32_t m_SimHz = 60;
+    uint32_t m_ServerTick = 0;
+
+    uint32_t m_Sequence = 0;
+    NetInput m_History[HISTORY] = {};
+    double m_SendTime[HISTORY] = {};
+
+    NetSnapshot m_Snapshots[NET_SNAPSHOT_HISTORY];
+    NetSnapshot m_Decoded;
+    bool m_HasSnapshot = false;
+    bool m_NewSnapshot = false;
+    uint32_t m_LatestTick = 0;
+    uint32_t m_LastInput = 0;
+    float m_RttMs = 0.0f;
+
+    uint8_t m_Packet[NET_MAX_PACKET * 2];
+    std::vector<uint8_t> m_Out;
+    NetTraffic m_Traffic;
+};
+
+#endif
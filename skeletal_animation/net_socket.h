@@ -0,0 +1,245 @@
+#ifndef NET_SOCKET_H
+#define NET_SOCKET_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "rng.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Non-blocking UDP socket plus a shim that fakes a bad link (latency, jitter,
+// loss) on the sending side, so netcode can be exercised over localhost.
+
+struct NetAddress {
+    uint32_t ip = 0;        // host byte order
+    uint16_t port = 0;
+
+    bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+    bool operator!=(const NetAddress& other) const { return !(*this == other); }
+};
+
+// "a.b.c.d" or "a.b.c.d:port"; 'port' is used when the string has none
+inline bool parseNetAddress(const std::string& text, uint16_t port, NetAddress& out)
+{
+    std::string host = text;
+    size_t colon = text.find(':');
+    if (colon != std::string::npos)
+    {
+        host = text.substr(0, colon);
+        port = (uint16_t)std::atoi(text.c_str() + colon + 1);
+    }
+    if (host == "localhost")
+        host = "127.0.0.1";
+
+    in_addr addr;
+    if (inet_pton(AF_INET, host.c_str(), &addr) != 1 || port == 0)
+        return false;
+    out.ip = ntohl(addr.s_addr);
+    out.port = port;
+    return true;
+}
+
+class UdpSocket {
+public:
+    UdpSocket() = default;
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    ~UdpSocket() { close(); }
+
+    // port 0 = any free port (clients)
+    bool open(uint16_t port)
+    {
+#ifdef _WIN32
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+        {
+            std::cout << "ERROR::NET: WSAStartup failed" << std::endl;
+            return false;
+        }
+        m_WsaStarted = true;
+#endif
+        m_Socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (m_Socket == INVALID)
+        {
+            std::cout << "ERROR::NET: could not create a UDP socket" << std::endl;
+            return false;
+        }
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+        if (bind(m_Socket, (const sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            std::cout << "ERROR::NET: could not bind UDP port " << port << std::endl;
+            close();
+            return false;
+        }
+
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        ioctlsocket(m_Socket, FIONBIO, &nonBlocking);
+#else
+        fcntl(m_Socket, F_SETFL, fcntl(m_Socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+        return true;
+    }
+
+    void close()
+    {
+        if (m_Socket != INVALID)
+        {
+#ifdef _WIN32
+            closesocket(m_Socket);
+#else
+            ::close(m_Socket);
+#endif
+        }
+        m_Socket = INVALID;
+#ifdef _WIN32
+        if (m_WsaStarted)
+            WSACleanup();
+        m_WsaStarted = false;
+#endif
+    }
+
+    bool isOpen() const { return m_Socket != INVALID; }
+
+    bool send(const NetAddress& to, const void* data, size_t size)
+    {
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(to.ip);
+        addr.sin_port = htons(to.port);
+        return sendto(m_Socket, (const char*)data, (int)size, 0, (const sockaddr*)&addr, sizeof(addr)) == (int)size;
+    }
+
+    // Bytes received, 0 when nothing is waiting
+    int receive(void* data, size_t capacity, NetAddress& from)
+    {
+        sockaddr_in addr;
+        socklen_t length = sizeof(addr);
+        int bytes = (int)recvfrom(m_Socket, (char*)data, (int)capacity, 0, (sockaddr*)&addr, &length);
+        if (bytes <= 0)
+            return 0;
+        from.ip = ntohl(addr.sin_addr.s_addr);
+        from.port = ntohs(addr.sin_port);
+        return bytes;
+    }
+
+private:
+#ifdef _WIN32
+    typedef SOCKET Handle;
+    static constexpr Handle INVALID = INVALID_SOCKET;
+    bool m_WsaStarted = false;
+#else
+    typedef int Handle;
+    static constexpr Handle INVALID = -1;
+#endif
+    Handle m_Socket = INVALID;
+};
+
+// Simulated link conditions, applied to everything a side sends
+struct LinkSettings {
+    float latencyMs = 0.0f;     // one way
+    float jitterMs = 0.0f;      // extra 0..jitter per packet, so packets can reorder
+    float lossPercent = 0.0f;
+
+    bool active() const { return latencyMs > 0.0f || jitterMs > 0.0f || lossPercent > 0.0f; }
+};
+
+// Holds outgoing packets until their simulated arrival time. With default
+// settings packets go straight to the socket.
+class LinkShim {
+public:
+    void configure(const LinkSettings& settings, uint64_t seed)
+    {
+        m_Settings = settings;
+        m_Rng.setSeed(seed);
+    }
+
+    const LinkSettings& settings() const { return m_Settings; }
+
+    void send(UdpSocket& socket, const NetAddress& to, const void* data, size_t size, double now)
+    {
+        m_Sent++;
+        if (m_Settings.lossPercent > 0.0f && m_Rng.nextFloat() * 100.0f < m_Settings.lossPercent)
+        {
+            m_Dropped++;
+            return;
+        }
+        if (!m_Settings.active())
+        {
+            socket.send(to, data, size);
+            return;
+        }
+
+        Delayed packet;
+        packet.sendAt = now + (m_Settings.latencyMs + m_Rng.nextFloat() * m_Settings.jitterMs) / 1000.0;
+        packet.to = to;
+        packet.data.assign((const unsigned char*)data, (const unsigned char*)data + size);
+        m_Queue.push_back(std::move(packet));
+    }
+
+    // Sends whatever is due; call every tick
+    void flush(UdpSocket& socket, double now)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < m_Queue.size(); ++i)
+        {
+            if (m_Queue[i].sendAt <= now)
+                socket.send(m_Queue[i].to, m_Queue[i].data.data(), m_Queue[i].data.size());
+            else
+            {
+                if (kept != i)
+                    m_Queue[kept] = std::move(m_Queue[i]);
+                kept++;
+            }
+        }
+        m_Queue.resize(kept);
+    }
+
+    int sent() const { return m_Sent; }
+    int dropped() const { return m_Dropped; }
+
+private:
+    struct Delayed {
+        double sendAt;
+        NetAddress to;
+        std::vector<unsigned char> data;
+    };
+
+    LinkSettings m_Settings;
+    Rng m_Rng;
+    std::vector<Delayed> m_Queue;
+    int m_Sent = 0;
+    int m_Dropped = 0;
+};
+
+#endif
@@ -0,0 +1,399 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Lightweight CPU profiler.
+//
+//   PROFILE_ZONE("bullets");            // times the rest of the enclosing scope
+//   PROFILE_COUNTER("targets", count);  // per-frame counter value
+//   PROFILE_THREAD("music");            // names the calling thread in traces
+//   PROFILE_FRAME();                    // once per frame, on the main thread
+//
+// Each thread writes finished zones into its own single-producer ring buffer
+// without taking a lock. PROFILE_FRAME() drains every ring on the main thread
+// and folds the zones into per-frame totals, keeping the last HISTORY frames
+// for the rolling average / max / p99 shown in the overlay.
+//
+// startCapture() additionally keeps every zone and counter sample of the next
+// N frames and writes them out as Chrome trace-event JSON, which loads in
+// chrome://tracing and ui.perfetto.dev.
+//
+// Zones also record how many heap allocations the thread made while they were
+// open (see alloc_tracker.h), so the overlay shows which zone allocates.
+//
+// Build with NYX_PROFILER=0 and the macros expand to nothing.
+
+#ifndef NYX_PROFILER
+#define NYX_PROFILER 1
+#endif
+
+#if NYX_PROFILER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "alloc_tracker.h"
+
+namespace profiler {
+
+const int MAX_ZONES = 64;
+const int MAX_COUNTERS = 16;
+const int MAX_THREADS = 16;
+const uint32_t RING_SIZE = 8192;   // events per thread, power of two
+const int HISTORY = 128;           // frames of history per zone
+
+inline uint64_t nowNs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct ZoneEvent {
+    uint32_t zone;
+    uint64_t startNs;
+    uint64_t endNs;
+    uint32_t allocs;    // heap allocations made inside the zone (inclusive)
+};
+
+// Single producer (the owning thread), single consumer (the main thread)
+struct ThreadRing {
+    ZoneEvent events[RING_SIZE];
+    std::atomic<uint32_t> head{ 0 };      // next slot to write, producer only
+    std::atomic<uint32_t> tail{ 0 };      // next slot to read, consumer only
+    std::atomic<uint32_t> dropped{ 0 };
+    std::atomic<bool> inUse{ false };    // owned by a live thread
+    int index = 0;
+    uint32_t threadId = 0;               // id of the current owner, for traces
+    const char* name = nullptr;
+
+    void push(const ZoneEvent& e)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        if (h - t >= RING_SIZE) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[h & (RING_SIZE - 1)] = e;
+        head.store(h + 1, std::memory_order_release);
+    }
+};
+
+struct ZoneStats {
+    const char* name;
+    double avgMs;
+    double maxMs;
+    double p99Ms;
+    int calls;          // calls in the last frame
+    int allocs;         // heap allocations in the last frame
+};
+
+class Profiler {
+public:
+    static Profiler& instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    // Called once per PROFILE_ZONE site (function-local static)
+    int registerZone(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (int i = 0; i < numZones.load(); ++i)
+            if (std::strcmp(zoneNames[i], name) == 0)
+                return i;
+        int id = numZones.load();
+        if (id >= MAX_ZONES)
+            return -1;
+        zoneNames[id] = name;
+        numZones.store(id + 1);
+        return id;
+    }
+
+    // Ring of the calling thread, claimed the first time that thread records
+    // and handed back when the thread exits
+    ThreadRing* threadRing()
+    {
+        struct Owner {
+            ThreadRing* ring;
+            ~Owner() { if (ring) ring->inUse.store(false, std::memory_order_release); }
+        };
+        thread_local Owner owner = { registerThread() };
+        return owner.ring;
+    }
+
+    // Drain every thread's ring and close the frame
+    void endFrame()
+    {
+        int zones = numZones.load();
+        for (int z = 0; z < zones; ++z) {
+            frameMs[z] = 0.0;
+            frameCalls[z] = 0;
+            frameAllocs[z] = 0;
+        }
+
+        int threads = numRings.load(std::memory_order_acquire);
+        for (int r = 0; r < threads; ++r) {
+            ThreadRing* ring = rings[r];
+            uint32_t t = ring->tail.load(std::memory_order_relaxed);
+            uint32_t h = ring->head.load(std::memory_order_acquire);
+            for (; t != h; ++t) {
+                const ZoneEvent& e = ring->events[t & (RING_SIZE - 1)];
+                frameMs[e.zone] += (e.endNs - e.startNs) * 1e-6;
+                frameCalls[e.zone]++;
+                frameAllocs[e.zone] += e.allocs;
+                if (captureFramesLeft > 0 && e.endNs >= captureStartNs)
+                    capturedZones.push_back({ e, ring->index });
+            }
+            ring->tail.store(t, std::memory_order_release);
+        }
+
+        for (int z = 0; z < zones; ++z)
+            history[z][historyPos] = (float)frameMs[z];
+        historyPos = (historyPos + 1) % HISTORY;
+        historyCount = std::min(historyCount + 1, HISTORY);
+
+        if (captureFramesLeft > 0 && --captureFramesLeft == 0)
+            writeChromeTrace();
+    }
+
+    int zoneCount() const { return numZones.load(); }
+
+    // Total time of 'zone' in the frame closed by the last endFrame()
+    double lastFrameMs(int zone) const { return frameMs[zone]; }
+
+    int registerCounter(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (int i = 0; i < numCounters; ++i)
+            if (std::strcmp(counterNames[i], name) == 0)
+                return i;
+        if (numCounters >= MAX_COUNTERS)
+            return -1;
+        counterNames[numCounters] = name;
+        return numCounters++;
+    }
+
+    // Main thread only. Values are only kept while a capture is running.
+    void counter(int id, double value)
+    {
+        if (id < 0 || captureFramesLeft == 0)
+            return;
+        capturedCounters.push_back({ id, nowNs(), value });
+    }
+
+    void setThreadName(const char* name)
+    {
+        ThreadRing* ring = threadRing();
+        if (ring)
+            ring->name = name;
+    }
+
+    // ==================== TRACE CAPTURE ====================
+    // Records the next 'frames' frames, then writes 'path'. Main thread only.
+    void startCapture(int frames, const std::string& path)
+    {
+        if (captureFramesLeft > 0 || frames <= 0)
+            return;
+        capturePath = path;
+        captureFramesLeft = frames;
+        captureStartNs = nowNs();
+        capturedZones.clear();
+        capturedCounters.clear();
+        capturedZones.reserve(frames * 64);
+        capturedCounters.reserve(frames * MAX_COUNTERS);
+        std::printf("[trace] capturing %d frames -> %s\n", frames, path.c_str());
+    }
+
+    bool capturing() const { return captureFramesLeft > 0; }
+
+    ZoneStats stats(int zone) const
+    {
+        ZoneStats s = { zoneNames[zone], 0.0, 0.0, 0.0, frameCalls[zone], frameAllocs[zone] };
+        if (historyCount == 0)
+            return s;
+
+        float sorted[HISTORY];
+        double sum = 0.0;
+        for (int i = 0; i < historyCount; ++i) {
+            sorted[i] = history[zone][i];
+            sum += sorted[i];
+        }
+        std::sort(sorted, sorted + historyCount);
+        s.avgMs = sum / historyCount;
+        s.maxMs = sorted[historyCount - 1];
+        s.p99Ms = sorted[std::min(historyCount - 1, (int)(historyCount * 0.99f))];
+        return s;
+    }
+
+    uint32_t droppedEvents() const
+    {
+        uint32_t total = 0;
+        for (int r = 0; r < numRings.load(); ++r)
+            total += rings[r]->dropped.load(std::memory_order_relaxed);
+        return total;
+    }
+
+private:
+    std::mutex registryMutex;
+    const char* zoneNames[MAX_ZONES] = {};
+    std::atomic<int> numZones{ 0 };
+    ThreadRing* rings[MAX_THREADS] = {};
+    std::atomic<int> numRings{ 0 };
+
+    const char* counterNames[MAX_COUNTERS] = {};
+    int numCounters = 0;
+
+    struct CapturedZone {
+        ZoneEvent event;
+        int ring;
+    };
+    struct CapturedCounter {
+        int counter;
+        uint64_t timeNs;
+        double value;
+    };
+    std::vector<CapturedZone> capturedZones;
+    std::vector<CapturedCounter> capturedCounters;
+    std::string capturePath;
+    uint64_t captureStartNs = 0;
+    int captureFramesLeft = 0;
+
+    double frameMs[MAX_ZONES] = {};
+    int frameCalls[MAX_ZONES] = {};
+    int frameAllocs[MAX_ZONES] = {};
+    float history[MAX_ZONES][HISTORY] = {};
+    int historyPos = 0;
+    int historyCount = 0;
+
+    Profiler() {}
+
+    ThreadRing* registerThread()
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        // Reuse the ring of a thread that already exited. Its producer is gone,
+        // so continuing from its head keeps the ring single-producer.
+        for (int r = 0; r < numRings.load(); ++r) {
+            bool expected = false;
+            if (rings[r]->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                rings[r]->threadId = currentThreadId();
+                rings[r]->name = nullptr;
+                return rings[r];
+            }
+        }
+
+        int index = numRings.load();
+        if (index >= MAX_THREADS)
+            return nullptr;
+        ThreadRing* ring = new ThreadRing();   // lives for the rest of the process
+        ring->index = index;
+        ring->threadId = currentThreadId();
+        ring->inUse.store(true);
+        rings[index] = ring;
+        numRings.store(index + 1, std::memory_order_release);
+        return ring;
+    }
+
+    static uint32_t currentThreadId()
+    {
+        return (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+    }
+
+    // Chrome trace-event format: complete ("X") events for zones, "C" events
+    // for counters and "M" metadata naming each thread. Timestamps are in
+    // microseconds relative to the start of the capture.
+    void writeChromeTrace()
+    {
+        FILE* file = std::fopen(capturePath.c_str(), "w");
+        if (!file) {
+            std::printf("[trace] could not open %s\n", capturePath.c_str());
+            return;
+        }
+
+        std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"NyxShade\"}}");
+
+        for (int r = 0; r < numRings.load(); ++r) {
+            const ThreadRing* ring = rings[r];
+            std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                ring->threadId, ring->name ? ring->name : "worker");
+        }
+
+        for (const CapturedZone& z : capturedZones) {
+            double ts = ((double)z.event.startNs - (double)captureStartNs) * 1e-3;
+            double dur = (double)(z.event.endNs - z.event.startNs) * 1e-3;
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"allocs\":%u}}",
+                zoneNames[z.event.zone], rings[z.ring]->threadId, ts, dur, z.event.allocs);
+        }
+
+        for (const CapturedCounter& c : capturedCounters) {
+            double ts = ((double)c.timeNs - (double)captureStartNs) * 1e-3;
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%g}}",
+                counterNames[c.counter], ts, c.value);
+        }
+
+        std::fprintf(file, "\n]}\n");
+        std::fclose(file);
+        std::printf("[trace] wrote %d zones, %d counter samples to %s\n",
+            (int)capturedZones.size(), (int)capturedCounters.size(), capturePath.c_str());
+
+        capturedZones.clear();
+        capturedCounters.clear();
+    }
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(int zone) : zone(zone), startNs(nowNs()), startAllocs(alloctrack::threadAllocs()) {}
+
+    ~ProfileScope()
+    {
+        if (zone < 0)
+            return;
+        ThreadRing* ring = Profiler::instance().threadRing();
+        if (ring)
+            ring->push({ (uint32_t)zone, startNs, nowNs(), (uint32_t)(alloctrack::threadAllocs() - startAllocs) });
+    }
+
+private:
+    int zone;
+    uint64_t startNs;
+    uint64_t startAllocs;
+};
+
+} // namespace profiler
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) \
+    static const int PROFILE_CONCAT(profileZoneId_, __LINE__) = profiler::Profiler::instance().registerZone(name); \
+    profiler::ProfileScope PROFILE_CONCAT(profileZone_, __LINE__)(PROFILE_CONCAT(profileZoneId_, __LINE__))
+#define PROFILE_COUNTER(name, value) \
+    do { \
+        static const int profileCounterId = profiler::Profiler::instance().registerCounter(name); \
+        if (profiler::Profiler::instance().capturing()) \
+            profiler::Profiler::instance().counter(profileCounterId, (double)(value)); \
+    } while (0)
+#define PROFILE_THREAD(name) profiler::Profiler::instance().setThreadName(name)
+#define PROFILE_FRAME() profiler::Profiler::instance().endFrame()
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_COUNTER(name, value)
+#define PROFILE_THREAD(name)
+#define PROFILE_FRAME()
+
+#endif // NYX_PROFILER
+
+#endif
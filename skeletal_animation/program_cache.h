@@ -0,0 +1,327 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Linked GL programs saved to disk with glGetProgramBinary and loaded back
+// with glProgramBinary, so later launches skip compiling and linking.
+//
+// Each vertex + fragment pair has one file in the cache directory. Its
+// header holds a hash of both sources and the driver's vendor, renderer and
+// version strings; a file whose hash does not match (edited shader, new
+// driver) is rebuilt from source and overwritten. The driver may still
+// reject a binary that matches, after an update that kept the version
+// string; that program is compiled from source too and the file replaced.
+//
+// Needs GL_ARB_get_program_binary (core in 4.1) and at least one binary
+// format. Without them, or with --no-program-cache, every program is
+// compiled from source as before.
+
+// Not in the GL 3.3 headers
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// The parts of learnopengl's Shader the game uses, over a program that came
+// from a ProgramCache
+class CachedProgram {
+public:
+    unsigned int ID = 0;
+
+    void use() const { glUseProgram(ID); }
+    void setInt(const std::string& name, int value) const { glUniform1i(glGetUniformLocation(ID, name.c_str()), value); }
+    void setFloat(const std::string& name, float value) const { glUniform1f(glGetUniformLocation(ID, name.c_str()), value); }
+    void setVec2(const std::string& name, const glm::vec2& value) const { glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value)); }
+    void setVec3(const std::string& name, const glm::vec3& value) const { glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value)); }
+    void setVec4(const std::string& name, const glm::vec4& value) const { glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value)); }
+    void setMat4(const std::string& name, const glm::mat4& value) const { glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value)); }
+};
+
+class ProgramCache {
+public:
+    // Call with a current context. 'directory' is created when missing.
+    void init(const std::string& directory, bool enabled = true)
+    {
+        m_Directory = directory;
+        m_Enabled = false;
+        if (enabled && glfwExtensionSupported("GL_ARB_get_program_binary"))
+        {
+            m_GetProgramBinary = (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+            m_ProgramBinary = (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+            m_ProgramParameteri = (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            m_Enabled = m_GetProgramBinary && m_ProgramBinary && m_ProgramParameteri && formats > 0;
+        }
+        if (m_Enabled)
+        {
+            std::error_code error;
+            std::filesystem::create_directories(m_Directory, error);
+            if (error)
+            {
+                std::cout << "Warning: could not create program cache " << m_Directory << ": " << error.message() << std::endl;
+                m_Enabled = false;
+            }
+        }
+
+        // Anything that changes what the driver would compile to
+        m_DriverHash = FNV_OFFSET;
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const char* value = (const char*)glGetString(name);
+            if (value)
+                m_DriverHash = hash(m_DriverHash, value, std::strlen(value) + 1);
+        }
+    }
+
+    bool enabled() const { return m_Enabled; }
+
+    // Program for a vertex + fragment shader pair, from the cache when it has
+    // a binary the driver accepts. Compile and link errors are logged; the
+    // program is returned either way, like learnopengl's Shader.
+    CachedProgram load(const char* vertexPath, const char* fragmentPath)
+    {
+        auto start = std::chrono::steady_clock::now();
+        Entry entry;
+        entry.name = std::string(vertexPath) + " + " + fragmentPath;
+
+        CachedProgram program;
+        std::string vertexSource, fragmentSource;
+        if (!readText(vertexPath, vertexSource) || !readText(fragmentPath, fragmentSource))
+        {
+            entry.source = "missing";
+            m_Entries.push_back(entry);
+            return program;
+        }
+
+        uint64_t key = hash(m_DriverHash, vertexSource.c_str(), vertexSource.size() + 1);
+        key = hash(key, fragmentSource.c_str(), fragmentSource.size() + 1);
+        std::string path = m_Directory + "/" + vertexPath + "+" + fragmentPath + ".bin";
+
+        float compileMs = 0.0f;
+        if (m_Enabled && loadBinary(path, key, program.ID, compileMs))
+        {
+            entry.source = "cache";
+            entry.ms = msSince(start);
+            entry.savedMs = compileMs - entry.ms;
+        }
+        else
+        {
+            if (program.ID)
+            {
+                std::cout << "Warning: cached program " << entry.name << " was rejected by the driver, recompiling" << std::endl;
+                glDeleteProgram(program.ID);
+                entry.source = "rejected";
+            }
+            else
+                entry.source = "compiled";
+            program.ID = compile(vertexPath, vertexSource.c_str(), fragmentPath, fragmentSource.c_str());
+            entry.ms = msSince(start);
+            if (m_Enabled && program.ID)
+                saveBinary(path, key, program.ID, entry.ms);
+        }
+        m_Entries.push_back(entry);
+        return program;
+    }
+
+    // One line per program and the total, for the startup report
+    void printReport() const
+    {
+        float total = 0.0f, saved = 0.0f;
+        int cached = 0;
+        for (const Entry& entry : m_Entries)
+        {
+            printf("[startup]   %-40s %-8s %7.2f ms\n", entry.name.c_str(), entry.source, entry.ms);
+            total += entry.ms;
+            saved += entry.savedMs;
+            cached += std::strcmp(entry.source, "cache") == 0 ? 1 : 0;
+        }
+        printf("[startup]   %d programs in %.2f ms, %d from the program cache%s, %.2f ms saved\n",
+            (int)m_Entries.size(), total, cached, m_Enabled ? "" : " (off)", saved);
+    }
+
+    float totalMs() const
+    {
+        float total = 0.0f;
+        for (const Entry& entry : m_Entries)
+            total += entry.ms;
+        return total;
+    }
+
+private:
+    typedef void (APIENTRY* GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    typedef void (APIENTRY* ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+    typedef void (APIENTRY* ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+    static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static const uint64_t FNV_PRIME = 1099511628211ull;
+    static const uint32_t FILE_MAGIC = 0x5058594E;      // "NYXP"
+    static const uint32_t FILE_VERSION = 1;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;           // sources + driver
+        uint32_t format;        // binaryFormat from glGetProgramBinary
+        uint32_t length;        // bytes of binary after the header
+        float compileMs;        // what building it from source took
+    };
+
+    struct Entry {
+        std::string name;
+        const char* source = "";    // cache, compiled, rejected (then compiled) or missing
+        float ms = 0.0f;
+        float savedMs = 0.0f;
+    };
+
+    static uint64_t hash(uint64_t h, const void* data, size_t size)
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i)
+            h = (h ^ bytes[i]) * FNV_PRIME;
+        return h;
+    }
+
+    static float msSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static bool readText(const char* path, std::string& out)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+            return false;
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+        out = stream.str();
+        return true;
+    }
+
+    // Creates the program and tries the cached binary. Returns true when the
+    // driver linked it; 'program' is left nonzero when it refused.
+    bool loadBinary(const std::string& path, uint64_t key, GLuint& program, float& compileMs)
+    {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+        FileHeader header;
+        std::vector<unsigned char> binary;
+        bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+            header.magic == FILE_MAGIC && header.version == FILE_VERSION && header.key == key;
+        if (ok)
+        {
+            binary.resize(header.length);
+            ok = header.length > 0 && std::fread(binary.data(), 1, binary.size(), file) == binary.size();
+        }
+        std::fclose(file);
+        if (!ok)
+            return false;
+
+        program = glCreateProgram();
+        m_ProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        compileMs = header.compileMs;
+        return linked == GL_TRUE;
+    }
+
+    void saveBinary(const std::string& path, uint64_t key, GLuint program, float compileMs)
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<unsigned char> binary(length);
+        GLenum format = 0;
+        m_GetProgramBinary(program, length, nullptr, &format, binary.data());
+
+        FileHeader header = { FILE_MAGIC, FILE_VERSION, key, format, (uint32_t)length, compileMs };
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            std::cout << "Warning: could not write " << path << std::endl;
+            return;
+        }
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fwrite(binary.data(), 1, binary.size(), file);
+        std::fclose(file);
+    }
+
+    GLuint compile(const char* vertexPath, const char* vertexSource, const char* fragmentPath, const char* fragmentSource)
+    {
+        GLuint vertex = compileStage(GL_VERTEX_SHADER, vertexPath, vertexSource);
+        GLuint fragment = compileStage(GL_FRAGMENT_SHADER, fragmentPath, fragmentSource);
+
+        GLuint program = glCreateProgram();
+        if (m_Enabled)
+            m_ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glLinkProgram(program);
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            char log[1024];
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            std::cout << "ERROR::PROGRAM_LINKING_ERROR: " << vertexPath << " + " << fragmentPath << "\n" << log << std::endl;
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    static GLuint compileStage(GLenum type, const char* path, const char* source)
+    {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled)
+        {
+            char log[1024];
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            std::cout << "ERROR::SHADER_COMPILATION_ERROR: " << path << "\n" << log << std::endl;
+        }
+        return shader;
+    }
+
+    std::string m_Directory;
+    bool m_Enabled = false;
+    uint64_t m_DriverHash = FNV_OFFSET;
+    GetProgramBinaryProc m_GetProgramBinary = nullptr;
+    ProgramBinaryProc m_ProgramBinary = nullptr;
+    ProgramParameteriProc m_ProgramParameteri = nullptr;
+    std::vector<Entry> m_Entries;
+};
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef PROJECTILES_H
+#define PROJECTILES_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Bullets live here instead of in the ECS. They all last the same number of
+// ticks, so they expire in the order they were fired: a fixed-capacity ring,
+// oldest at the tail, newest at the head, keeps them in that order and
+// expiry is popping the tail. A bullet that hits something is tombstoned and
+// compact() closes the gaps once per pass, still in firing order.
+//
+// Positions and velocities are plain vec3 arrays, so integrate() is one
+// multiply-add loop over contiguous floats (at most two spans when the ring
+// wraps) that the compiler vectorizes.
+//
+// Every bullet gets a serial number when fired. Serials only grow from tail
+// to head, so find() is a binary search; the network code uses them as
+// bullet ids.
+
+const uint32_t PROJECTILE_NONE = 0;    // spawn() on a full ring, never a serial
+
+class ProjectileRing {
+public:
+    // Rounds up to a power of two. The only allocation; spawn() on a full
+    // ring drops the shot.
+    void reserve(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        m_Mask = (uint32_t)size - 1;
+        m_Position.assign(size, glm::vec3(0.0f));
+        m_Previous.assign(size, glm::vec3(0.0f));
+        m_Velocity.assign(size, glm::vec3(0.0f));
+        m_SpawnTick.assign(size, 0);
+        m_Serial.assign(size, PROJECTILE_NONE);
+        clear();
+    }
+
+    void clear()
+    {
+        m_Tail = m_Head = 0;
+        m_Dead = 0;
+    }
+
+    size_t capacity() const { return m_Position.size(); }
+    size_t size() const { return m_Head - m_Tail - m_Dead; }
+
+    // Returns the bullet's serial, PROJECTILE_NONE when the ring is full
+    uint32_t spawn(const glm::vec3& position, const glm::vec3& velocity, uint32_t tick)
+    {
+        if (m_Head - m_Tail == capacity())
+            compact();
+        if (m_Head - m_Tail == capacity())
+            return PROJECTILE_NONE;
+
+        uint32_t slot = m_Head++ & m_Mask;
+        m_Position[slot] = position;
+        m_Previous[slot] = position;
+        m_Velocity[slot] = velocity;
+        m_SpawnTick[slot] = tick;
+        if (++m_NextSerial == PROJECTILE_NONE)
+            ++m_NextSerial;
+        m_Serial[slot] = m_NextSerial;
+        return m_NextSerial;
+    }
+
+    // Pops every bullet at least 'lifetime' ticks old, and tombstones on the
+    // way. Returns how many live bullets expired.
+    int expire(uint32_t tick, uint32_t lifetime)
+    {
+        int expired = 0;
+        while (m_Head != m_Tail)
+        {
+            uint32_t slot = m_Tail & m_Mask;
+            bool dead = m_Serial[slot] == PROJECTILE_NONE;
+            if (!dead && tick - m_SpawnTick[slot] < lifetime)
+                break;
+            m_Tail++;
+            if (dead)
+                m_Dead--;
+            else
+                expired++;
+        }
+        return expired;
+    }
+
+    // Start of a fixed step: remember where every bullet was
+    void storePrevious()
+    {
+        forEachSpan([&](uint32_t first, uint32_t count) {
+            std::memcpy(&m_Previous[first], &m_Position[first], count * sizeof(glm::vec3));
+        });
+    }
+
+    // position += velocity * dt for every slot in use, tombstones included
+    void integrate(float dt)
+    {
+        forEachSpan([&](uint32_t first, uint32_t count) {
+            float* position = &m_Position[first].x;
+            const float* velocity = &m_Velocity[first].x;
+            for (uint32_t i = 0, n = count * 3; i < n; ++i)
+                position[i] += velocity[i] * dt;
+        });
+    }
+
+    // Calls visit(uint32_t slot) for every live bullet, oldest first
+    template<class Visit>
+    void each(Visit visit) const
+    {
+        for (uint32_t i = m_Tail; i != m_Head; ++i)
+        {
+            uint32_t slot = i & m_Mask;
+            if (m_Serial[slot] != PROJECTILE_NONE)
+                visit(slot);
+        }
+    }
+
+    const glm::vec3& position(uint32_t slot) const { return m_Position[slot]; }
+    const glm::vec3& previous(uint32_t slot) const { return m_Previous[slot]; }
+    const glm::vec3& velocity(uint32_t slot) const { return m_Velocity[slot]; }
+    uint32_t serial(uint32_t slot) const { return m_Serial[slot]; }
+
+    // Tombstones a bullet; it stays in its slot until compact() or expiry
+    void kill(uint32_t slot)
+    {
+        if (m_Serial[slot] == PROJECTILE_NONE)
+            return;
+        m_Serial[slot] = PROJECTILE_NONE;
+        m_Dead++;
+    }
+
+    // Slot of the live bullet with 'serial', -1 when it is gone
+    int find(uint32_t serial) const
+    {
+        // Serials grow from tail to head; tombstones (PROJECTILE_NONE) are
+        // skipped towards the head
+        uint32_t low = 0, high = m_Head - m_Tail;     // offsets from the tail
+        while (low < high)
+        {
+            uint32_t mid = low + (high - low) / 2;
+            uint32_t probe = mid;
+            while (probe != high && m_Serial[(m_Tail + probe) & m_Mask] == PROJECTILE_NONE)
+                probe++;
+            if (probe == high)
+            {
+                high = mid;
+                continue;
+            }
+            uint32_t found = m_Serial[(m_Tail + probe) & m_Mask];
+            if (found == serial)
+                return (int)((m_Tail + probe) & m_Mask);
+            if ((int32_t)(found - serial) < 0)
+                low = probe + 1;
+            else
+                high = mid;
+        }
+        return -1;
+    }
+
+    // Closes the gaps tombstones left, keeping firing order
+    void compact()
+    {
+        if (m_Dead == 0)
+            return;
+        uint32_t write = m_Tail;
+        for (uint32_t read = m_Tail; read != m_Head; ++read)
+        {
+            uint32_t from = read & m_Mask;
+            if (m_Serial[from] == PROJECTILE_NONE)
+                continue;
+            uint32_t to = write++ & m_Mask;
+            if (to != from)
+            {
+                m_Position[to] = m_Position[from];
+                m_Previous[to] = m_Previous[from];
+                m_Velocity[to] = m_Velocity[from];
+                m_SpawnTick[to] = m_SpawnTick[from];
+                m_Serial[to] = m_Serial[from];
+            }
+        }
+        m_Head = write;
+        m_Dead = 0;
+    }
+
+private:
+    // The slots in use as one or two contiguous runs (first, count)
+    template<class Span>
+    void forEachSpan(Span span)
+    {
+        uint32_t used = m_Head - m_Tail;
+        if (used == 0)
+            return;
+        uint32_t first = m_Tail & m_Mask;
+        uint32_t run = (uint32_t)capacity() - first;
+        if (used <= run)
+            span(first, used);
+        else
+        {
+            span(first, run);
+            span(0, used - run);
+        }
+    }
+
+    std::vector<glm::vec3> m_Position;
+    std::vector<glm::vec3> m_Previous;
+    std::vector<glm::vec3> m_Velocity;
+    std::vector<uint32_t> m_SpawnTick;
+    std::vector<uint32_t> m_Serial;     // PROJECTILE_NONE = tombstone
+    uint32_t m_Mask = 0;
+    uint32_t m_Tail = 0;                // free-running, slot = index & m_Mask
+    uint32_t m_Head = 0;
+    uint32_t m_Dead = 0;                // tombstones between tail and head
+    uint32_t m_NextSerial = PROJECTILE_NONE;
+};
+
+#endif
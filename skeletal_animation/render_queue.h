@@ -0,0 +1,219 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Sorted draw submission for the 3D scene.
+//
+// Instead of drawing as it goes, the frame records one DrawPacket per draw
+// with a 64 bit sort key:
+//
+//   | pass 4 | program 8 | vao 12 | texture 12 | depth 24 | (4 unused)
+//
+// submit() sorts the keys once and walks them, only touching GL state that
+// actually changes between neighbours. Per-program uniforms (projection,
+// view, color) are cached per program since GL keeps them per program too,
+// so switching back and forth does not re-upload them. Bone palettes live in
+// a uniform buffer (see stream_buffer.h); a packet only carries its offset.
+
+// Uniform buffer binding point of the "BonePalette" block
+const GLuint PALETTE_BINDING = 0;
+
+enum RenderPass {
+    PASS_OPAQUE = 0,
+};
+
+struct DrawPacket {
+    int program;                // index from RenderQueue::registerProgram
+    unsigned int vao;
+    unsigned int texture;       // diffuse on unit 0, 0 = program samples nothing
+    GLenum mode;
+    GLsizei count;
+    GLint first;                // glDrawArrays only
+    GLenum indexType;           // glDrawElements with GL_UNSIGNED_INT / _SHORT indices, 0 = glDrawArrays
+    GLsizei instances;          // > 0 draws that many instances
+    glm::mat4 model;
+    glm::vec3 color;            // "color" uniform, if the program has one
+    GLintptr palette;           // offset of the bone palette in the palette buffer, -1 = none
+};
+
+struct RenderStats {
+    int draws = 0;
+    int programChanges = 0;
+    int vaoChanges = 0;
+    int textureChanges = 0;
+    int uniformUploads = 0;     // projection / view / color / palette binds, not model
+
+    int stateChanges() const { return programChanges + vaoChanges + textureChanges; }
+};
+
+class RenderQueue {
+public:
+    // Caches the uniform locations the queue drives. Missing uniforms are -1
+    // and simply skipped.
+    int registerProgram(unsigned int id)
+    {
+        Program p;
+        p.id = id;
+        p.projection = glGetUniformLocation(id, "projection");
+        p.view = glGetUniformLocation(id, "view");
+        p.model = glGetUniformLocation(id, "model");
+        p.color = glGetUniformLocation(id, "color");
+        GLuint block = glGetUniformBlockIndex(id, "BonePalette");
+        if (block != GL_INVALID_INDEX)
+            glUniformBlockBinding(id, block, PALETTE_BINDING);
+        m_Programs.push_back(p);
+        return (int)m_Programs.size() - 1;
+    }
+
+    // Buffer the packets' palette offsets point into, bound as
+    // [offset, offset + paletteBytes) for each skinned draw
+    void setPaletteBuffer(unsigned int buffer, GLsizeiptr paletteBytes)
+    {
+        m_PaletteBuffer = buffer;
+        m_PaletteBytes = paletteBytes;
+    }
+
+    void reserve(size_t packets)
+    {
+        m_Packets.reserve(packets);
+        m_Order.reserve(packets);
+    }
+
+    // Starts a frame. 'eye' is used for the depth part of the key.
+    void begin(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& eye, float farPlane)
+    {
+        m_Projection = projection;
+        m_View = view;
+        m_Eye = eye;
+        m_FarPlane = farPlane;
+        m_Packets.clear();
+        m_Order.clear();
+        for (Program& p : m_Programs) {
+            p.frameUniformsSet = false;
+            p.colorValid = false;
+        }
+    }
+
+    void add(const DrawPacket& packet, RenderPass pass = PASS_OPAQUE)
+    {
+        // Front to back inside a state bucket so early depth rejects more
+        glm::vec3 position(packet.model[3]);
+        float depth = glm::clamp(glm::length(position - m_Eye) / m_FarPlane, 0.0f, 1.0f);
+
+        uint64_t key = 0;
+        key |= (uint64_t)(pass & 0xF) << 60;
+        key |= (uint64_t)(packet.program & 0xFF) << 52;
+        key |= (uint64_t)(packet.vao & 0xFFF) << 40;
+        key |= (uint64_t)(packet.texture & 0xFFF) << 28;
+        key |= (uint64_t)(depth * 0xFFFFFF) << 4;
+
+        m_Order.push_back({ key, (uint32_t)m_Packets.size() });
+        m_Packets.push_back(packet);
+    }
+
+    RenderStats submit()
+    {
+        RenderStats stats;
+        std::sort(m_Order.begin(), m_Order.end(), [](const SortEntry& a, const SortEntry& b) {
+            return a.key < b.key;
+        });
+
+        int currentProgram = -1;
+        unsigned int currentVao = 0;
+        unsigned int currentTexture = 0;
+        bool vaoBound = false;
+        bool textureBound = false;
+        GLintptr currentPalette = -1;
+
+        glActiveTexture(GL_TEXTURE0);
+        for (const SortEntry& entry : m_Order) {
+            const DrawPacket& packet = m_Packets[entry.index];
+            Program& program = m_Programs[packet.program];
+
+            if (packet.program != currentProgram) {
+                glUseProgram(program.id);
+                currentProgram = packet.program;
+                stats.programChanges++;
+                if (!program.frameUniformsSet) {
+                    if (program.projection >= 0)
+                        glUniformMatrix4fv(program.projection, 1, GL_FALSE, glm::value_ptr(m_Projection));
+                    if (program.view >= 0)
+                        glUniformMatrix4fv(program.view, 1, GL_FALSE, glm::value_ptr(m_View));
+                    program.frameUniformsSet = true;
+                    stats.uniformUploads += 2;
+                }
+            }
+            if (!vaoBound || packet.vao != currentVao) {
+                glBindVertexArray(packet.vao);
+                currentVao = packet.vao;
+                vaoBound = true;
+                stats.vaoChanges++;
+            }
+            if (packet.texture != 0 && (!textureBound || packet.texture != currentTexture)) {
+                glBindTexture(GL_TEXTURE_2D, packet.texture);
+                currentTexture = packet.texture;
+                textureBound = true;
+                stats.textureChanges++;
+            }
+
+            if (program.model >= 0)
+                glUniformMatrix4fv(program.model, 1, GL_FALSE, glm::value_ptr(packet.model));
+            if (program.color >= 0 && (!program.colorValid || program.lastColor != packet.color)) {
+                glUniform3fv(program.color, 1, glm::value_ptr(packet.color));
+                program.lastColor = packet.color;
+                program.colorValid = true;
+                stats.uniformUploads++;
+            }
+            if (packet.palette >= 0 && packet.palette != currentPalette) {
+                glBindBufferRange(GL_UNIFORM_BUFFER, PALETTE_BINDING, m_PaletteBuffer, packet.palette, m_PaletteBytes);
+                currentPalette = packet.palette;
+                stats.uniformUploads++;
+            }
+
+            if (packet.indexType)
+                glDrawElements(packet.mode, packet.count, packet.indexType, 0);
+            else if (packet.instances > 0)
+                glDrawArraysInstanced(packet.mode, packet.first, packet.count, packet.instances);
+            else
+                glDrawArrays(packet.mode, packet.first, packet.count);
+            stats.draws++;
+        }
+
+        glBindVertexArray(0);
+        return stats;
+    }
+
+private:
+    struct Program {
+        unsigned int id;
+        GLint projection, view, model, color;
+        bool frameUniformsSet = false;
+        bool colorValid = false;
+        glm::vec3 lastColor;
+    };
+
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<Program> m_Programs;
+    unsigned int m_PaletteBuffer = 0;
+    GLsizeiptr m_PaletteBytes = 0;
+    std::vector<DrawPacket> m_Packets;
+    std::vector<SortEntry> m_Order;
+    glm::mat4 m_Projection;
+    glm::mat4 m_View;
+    glm::vec3 m_Eye;
+    float m_FarPlane = 100.0f;
+};
+
+#endif
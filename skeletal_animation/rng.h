@@ -0,0 +1,52 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// Small deterministic generator (SplitMix64 seeding a xorshift64*) used for
+// everything the simulation randomizes. Unlike rand() the sequence is the
+// same on every platform and C runtime, so a recorded seed replays exactly.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 1) { setSeed(seed); }
+
+    void setSeed(uint64_t seed)
+    {
+        m_Seed = seed;
+        // SplitMix64 step so nearby seeds give unrelated sequences
+        uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        m_State = z ^ (z >> 31);
+        if (m_State == 0)
+            m_State = 0x2545F4914F6CDD1Dull;
+    }
+
+    uint64_t seed() const { return m_Seed; }
+
+    uint32_t next()
+    {
+        m_State ^= m_State >> 12;
+        m_State ^= m_State << 25;
+        m_State ^= m_State >> 27;
+        return (uint32_t)((m_State * 0x2545F4914F6CDD1Dull) >> 32);
+    }
+
+    // Float in [0, 1)
+    float nextFloat()
+    {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Integer in [0, n)
+    int range(int n)
+    {
+        return n > 0 ? (int)(next() % (uint32_t)n) : 0;
+    }
+
+private:
+    uint64_t m_Seed;
+    uint64_t m_State;
+};
+
+#endif
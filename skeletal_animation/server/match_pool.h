@@ -0,0 +1,156 @@
+#ifndef MATCH_POOL_H
+#define MATCH_POOL_H
+
+#include "match.h"
+#include "load_test.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Ticks every hosted match once per server tick on a fixed set of worker
+// threads. Matches are handed out one at a time from a shared counter, so a
+// slow match holds up one worker instead of a fixed share of the list.
+//
+// Each match tick is timed against that match's budget. Ticks over budget
+// are counted per match (overruns), and every tick's time goes into the
+// worker's series for the report.
+
+struct HostedMatch {
+    std::unique_ptr<Match> match;
+    double budgetMs = 1.0;
+
+    // accounting, written only by the worker that ticked it
+    uint64_t ticks = 0;
+    uint64_t overruns = 0;
+    double totalMs = 0.0;
+    double worstMs = 0.0;
+};
+
+class MatchPool {
+public:
+    MatchPool() = default;
+    MatchPool(const MatchPool&) = delete;
+    MatchPool& operator=(const MatchPool&) = delete;
+
+    ~MatchPool() { stop(); }
+
+    void start(int threads)
+    {
+        m_Workers.resize(threads < 1 ? 1 : threads);
+        for (size_t i = 0; i < m_Workers.size(); ++i)
+            m_Threads.emplace_back(&MatchPool::workerLoop, this, (int)i);
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Quit = true;
+        }
+        m_Wake.notify_all();
+        for (std::thread& thread : m_Threads)
+            thread.join();
+        m_Threads.clear();
+    }
+
+    int threads() const { return (int)m_Workers.size(); }
+
+    // One tick of every match, returns when all of them are done
+    void tick(std::vector<HostedMatch>& matches, float dt)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Matches = &matches;
+            m_Dt = dt;
+            m_Next.store(0);
+            m_Busy = (int)m_Workers.size();
+            m_Generation++;
+        }
+        m_Wake.notify_all();
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Done.wait(lock, [&] { return m_Busy == 0; });
+    }
+
+    // Seconds all workers spent ticking matches. Only read between ticks.
+    double busySeconds() const
+    {
+        double total = 0.0;
+        for (const Worker& worker : m_Workers)
+            total += worker.busySeconds;
+        return total;
+    }
+
+    // Every match tick so far, in ms
+    void collectTickMs(LoadTestSeries& out) const
+    {
+        for (const Worker& worker : m_Workers)
+            out.samples.insert(out.samples.end(), worker.tickMs.samples.begin(), worker.tickMs.samples.end());
+    }
+
+private:
+    struct Worker {
+        double busySeconds = 0.0;
+        LoadTestSeries tickMs;
+    };
+
+    void workerLoop(int index)
+    {
+        Worker& worker = m_Workers[index];
+        uint64_t seen = 0;
+        for (;;)
+        {
+            std::vector<HostedMatch>* matches;
+            float dt;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Wake.wait(lock, [&] { return m_Quit || m_Generation != seen; });
+                if (m_Quit)
+                    return;
+                seen = m_Generation;
+                matches = m_Matches;
+                dt = m_Dt;
+            }
+
+            auto batchStart = std::chrono::steady_clock::now();
+            for (size_t i = m_Next.fetch_add(1); i < matches->size(); i = m_Next.fetch_add(1))
+            {
+                HostedMatch& hosted = (*matches)[i];
+                auto start = std::chrono::steady_clock::now();
+                hosted.match->tick(dt);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                hosted.ticks++;
+                hosted.totalMs += ms;
+                hosted.worstMs = std::max(hosted.worstMs, ms);
+                if (ms > hosted.budgetMs)
+                    hosted.overruns++;
+                worker.tickMs.add((float)ms);
+            }
+            worker.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (--m_Busy == 0)
+                m_Done.notify_one();
+        }
+    }
+
+    std::vector<Worker> m_Workers;
+    std::vector<std::thread> m_Threads;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::condition_variable m_Done;
+    uint64_t m_Generation = 0;
+    bool m_Quit = false;
+    int m_Busy = 0;
+    std::vector<HostedMatch>* m_Matches = nullptr;
+    float m_Dt = 0.0f;
+    std::atomic<size_t> m_Next{ 0 };
+};
+
+#endif
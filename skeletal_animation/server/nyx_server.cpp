@@ -0,0 +1,169 @@
+// Dedicated server: hosts many independent matches with no window, audio,
+// fonts or models. Only the simulation is linked (match.h on top of
+// game_sim.h), so it builds with glm and a C++17 compiler:
+//
+//   g++ -O2 -std=c++17 -I.. -I<path to glm> nyx_server.cpp -lpthread -o nyx_server
+//   ./nyx_server --matches 500 --hz 60 --threads 8 --seconds 30
+//
+// All matches share one level and its navigation grid, loaded and built
+// once (--level, by default the game's arena.lvl one directory up).
+//
+// Every server tick runs one tick of every match across --threads workers
+// (match_pool.h). A match tick longer than its budget (--budget-ms, by
+// default its fair share of the tick: threads * period / matches) is an
+// overrun; a server tick that does not finish within the period is late.
+// The report at the end gives both, plus how many matches one core could
+// carry at this tick rate, measured from the time the workers were busy.
+// Exits with 1 when more than 1% of server ticks were late.
+//
+//   --matches N       match instances (default 100)
+//   --players N       bot players per match, 1..4 (default 2)
+//   --hz N            ticks per second (default 60)
+//   --threads N       worker threads (default: hardware threads)
+//   --seconds S       how long to run (default 10)
+//   --budget-ms MS    per-match tick budget
+//   --seed N          first match seed, match i uses seed + i
+//   --level FILE      level to play on (default ../arena.lvl)
+
+#include "match_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    int matchCount = 100;
+    int players = 2;
+    int hz = 60;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    double seconds = 10.0;
+    double budgetMs = 0.0;      // 0 = fair share
+    uint64_t seed = 1;
+    std::string levelPath = "../arena.lvl";
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--matches" && i + 1 < argc)
+            matchCount = std::max(1, std::atoi(argv[++i]));
+        else if (std::string(argv[i]) == "--players" && i + 1 < argc)
+            players = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--hz" && i + 1 < argc)
+            hz = std::max(1, std::atoi(argv[++i]));
+        else if (std::string(argv[i]) == "--threads" && i + 1 < argc)
+            threads = std::max(1, std::atoi(argv[++i]));
+        else if (std::string(argv[i]) == "--seconds" && i + 1 < argc)
+            seconds = std::max(0.1, std::atof(argv[++i]));
+        else if (std::string(argv[i]) == "--budget-ms" && i + 1 < argc)
+            budgetMs = std::max(0.0, std::atof(argv[++i]));
+        else if (std::string(argv[i]) == "--seed" && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::string(argv[i]) == "--level" && i + 1 < argc)
+            levelPath = argv[++i];
+        else
+            std::cout << "Warning: unknown argument '" << argv[i] << "'" << std::endl;
+    }
+
+    Level level;
+    if (!level.loadFromFile(levelPath))
+        return 1;
+    NavGrid nav;
+    buildTargetNav(nav, level);
+
+    double periodMs = 1000.0 / hz;
+    if (budgetMs == 0.0)
+        budgetMs = periodMs * threads / matchCount;
+
+    std::vector<HostedMatch> matches(matchCount);
+    for (int i = 0; i < matchCount; ++i)
+    {
+        matches[i].match.reset(new Match());
+        matches[i].match->start(seed + i, players, level, nav);
+        matches[i].budgetMs = budgetMs;
+    }
+
+    printf("[server] %d matches x %d bots at %d Hz on %d threads, %.3f ms budget per match tick\n",
+        matchCount, matches[0].match->players(), hz, threads, budgetMs);
+
+    MatchPool pool;
+    pool.start(threads);
+
+    // Fixed rate: sleep to the next tick, or run straight on when behind.
+    // More than a few ticks behind, the schedule gives up on catching up.
+    const int MAX_BEHIND = 5;
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / hz));
+    float dt = 1.0f / hz;
+    int totalTicks = (int)(seconds * hz);
+    int lateTicks = 0;
+    int skippedTicks = 0;
+    LoadTestSeries tickMs;
+    tickMs.samples.reserve(totalTicks);
+
+    auto runStart = std::chrono::steady_clock::now();
+    auto next = runStart;
+    for (int tick = 0; tick < totalTicks; ++tick)
+    {
+        auto start = std::chrono::steady_clock::now();
+        pool.tick(matches, dt);
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        tickMs.add((float)ms);
+        if (ms > periodMs)
+            lateTicks++;
+
+        next += period;
+        if (end < next)
+            std::this_thread::sleep_until(next);
+        else if (end - next > period * MAX_BEHIND)
+        {
+            skippedTicks += (int)((end - next) / period);
+            next = end;
+        }
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    double busySeconds = pool.busySeconds();
+    pool.stop();
+
+    // Per-match accounting
+    LoadTestSeries matchMs;
+    pool.collectTickMs(matchMs);
+    uint64_t matchTicks = 0;
+    uint64_t overruns = 0;
+    int overrunMatches = 0;
+    int worstMatch = 0;
+    int score = 0;
+    int deaths = 0;
+    for (int i = 0; i < matchCount; ++i)
+    {
+        const HostedMatch& hosted = matches[i];
+        matchTicks += hosted.ticks;
+        overruns += hosted.overruns;
+        overrunMatches += hosted.overruns > 0 ? 1 : 0;
+        if (hosted.overruns > matches[worstMatch].overruns)
+            worstMatch = i;
+        score += hosted.match->score();
+        deaths += hosted.match->deaths();
+    }
+
+    printf("[server] %d ticks in %.1f s: %d late (over %.2f ms), %d skipped\n",
+        totalTicks, wallSeconds, lateTicks, periodMs, skippedTicks);
+    printf("[server] ms per server tick / per match tick:\n");
+    tickMs.print("server tick");
+    matchMs.print("match tick");
+    printf("[server] match overruns: %llu of %llu ticks (%.3f%%) in %d matches, worst match %d with %llu\n",
+        (unsigned long long)overruns, (unsigned long long)matchTicks,
+        matchTicks > 0 ? 100.0 * overruns / matchTicks : 0.0, overrunMatches, worstMatch,
+        (unsigned long long)matches[worstMatch].overruns);
+
+    // Cores kept busy on average; the matches they carried over that is the
+    // per-core capacity at this tick rate
+    double coresBusy = busySeconds / wallSeconds;
+    printf("[server] %.2f of %d threads busy -> %.0f matches per core at %d Hz\n",
+        coresBusy, threads, coresBusy > 0.0 ? matchCount / coresBusy : 0.0, hz);
+    printf("[server] score %d, %d deaths over all matches\n", score, deaths);
+    return lateTicks > totalTicks / 100 ? 1 : 0;
+}
@@ -8,212 +8,444 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
-#include <learnopengl/animator.h>
-#include <learnopengl/model_animation.h>
-
-#include <stb_image.h>
 
 #include <iostream>
 #include <vector>
 #include <cstdlib>
+#include <cstddef>
+#include <cstring>
 #include <ctime>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 #include <SFML/Audio.hpp>
 
-// ==================== SOUND SYSTEM ====================
-class SoundManager {
-private:
-    sf::Music backgroundMusic;
-    sf::Music gamebackMusic;
-
-    sf::SoundBuffer chooseButtonBuffer;
-    sf::SoundBuffer gameBackBuffer;
-    sf::SoundBuffer gameOverBuffer;
-    sf::SoundBuffer gunShotBuffer;
-    sf::SoundBuffer healBuffer;
-    sf::SoundBuffer menuBackBuffer;
-    sf::SoundBuffer openingBuffer;
-    sf::SoundBuffer startGameBuffer;
-
-
-    sf::Sound* chooseButtonSound;
-    sf::Sound* gameBackSound;
-    sf::Sound* gameOverSound;
-    sf::Sound* gunShotSound;
-    sf::Sound* healSound;
-    sf::Sound* menuBackSound;
-    sf::Sound* openingSound;
-    sf::Sound* startGameSound;
+#include "profiler.h"
+#include "alloc_tracker.h"
+#include "frame_arena.h"
+#include "anim_runtime.h"
+#include "anim_import.h"
+#include "dual_quat.h"
+#include "vertex_format.h"
+#include "rng.h"
+#include "input_replay.h"
+#include "game_sim.h"
+#include "text_layout.h"
+#include "load_test.h"
+#include "render_queue.h"
+#include "stream_buffer.h"
+#include "frame_timing.h"
+#include "net_session.h"
+#include "program_cache.h"
+#include "texture_cache.h"
+#include "font_atlas.h"
+#include "asset_registry.h"
+
+// ==================== MUSIC ====================
+enum class MusicTrack {
+    Menu,
+    Game,
+    Count
+};
 
-    bool initialized;
+struct MusicAsset {
+    const char* path;
+    float volume;
+};
 
-public:
-    SoundManager() : initialized(false) {
-        // Load all sound buffers
-        std::string testPath = FileSystem::getPath("resources/audio/_choosebutton.wav");
-        std::cout << "Attempting to load sound from: " << testPath << std::endl;
-        std::cout << "Path length: " << testPath.length() << std::endl;
-        std::cout << "Path is empty: " << (testPath.empty() ? "YES" : "NO") << std::endl;
-
-        if (!chooseButtonBuffer.loadFromFile("C:/Users/ASUS/Desktop/_1/LearnOpenGL-master/resources/audio/choosebutton.wav")) {
-            std::cout << "Warning: Failed to load choosebutton sound\n";
-        }
+const MusicAsset MUSIC_ASSETS[(int)MusicTrack::Count] = {
+    { "resources/audio/_menuback.wav", 30.0f },  // Menu
+    { "resources/audio/_gameback.wav", 25.0f },  // Game
+};
 
-        if (!gameBackBuffer.loadFromFile(FileSystem::getPath("resources/audio/_gameback.wav"))) {
-            std::cout << "Warning: Failed to load gameback sound\n";
-        }
+const float MUSIC_FADE_TIME = 0.75f;   // seconds for a full fade in or out
+const int MUSIC_FADE_STEP_MS = 10;     // fade thread tick while a fade is running
 
-        if (!gameOverBuffer.loadFromFile(FileSystem::getPath("resources/audio/_gameover.wav"))) {
-            std::cout << "Warning: Failed to load gameover sound\n";
+// Every track is opened once at startup and only ever touched by the fade
+// thread afterwards. The game thread just posts a request (which track, paused
+// or not) and returns, so switching music never opens files or blocks a frame.
+class MusicManager {
+private:
+    struct Request {
+        int track;          // MusicTrack index, -1 = silence
+        bool loop;
+        bool paused;
+        float volume;       // full-gain volume override, < 0 = asset volume
+    };
+
+    sf::Music tracks[(int)MusicTrack::Count];
+    bool opened[(int)MusicTrack::Count];
+    float gain[(int)MusicTrack::Count];   // fade thread only
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    Request request;
+    bool dirty;
+    bool quit;
+
+    void post(const Request& r) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            request = r;
+            dirty = true;
         }
+        wake.notify_one();
+    }
+
+    Request current() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return request;
+    }
 
-        if (!gunShotBuffer.loadFromFile(FileSystem::getPath("resources/audio/_gunshot.wav"))) {
-            std::cout << "Warning: Failed to load gunshot sound\n";
+    // Advance every fade by dt, returns true once nothing is moving anymore
+    bool step(const Request& r, float dt) {
+        PROFILE_ZONE("music fade");
+        bool settled = true;
+        for (int i = 0; i < (int)MusicTrack::Count; ++i) {
+            if (!opened[i])
+                continue;
+            sf::Music& music = tracks[i];
+
+            if (r.paused) {
+                if (music.getStatus() == sf::Music::Status::Playing)
+                    music.pause();
+                continue;
+            }
+
+            float target = (i == r.track) ? 1.0f : 0.0f;
+            float delta = dt / MUSIC_FADE_TIME;
+            if (gain[i] < target)
+                gain[i] = std::min(target, gain[i] + delta);
+            else if (gain[i] > target)
+                gain[i] = std::max(target, gain[i] - delta);
+
+            if (gain[i] > 0.0f) {
+                float full = r.volume >= 0.0f ? r.volume : MUSIC_ASSETS[i].volume;
+                music.setVolume(full * gain[i]);
+                if (music.getStatus() != sf::Music::Status::Playing) {
+                    if (i == r.track)
+                        music.setLooping(r.loop);
+                    music.play();
+                }
+            }
+            else if (music.getStatus() != sf::Music::Status::Stopped) {
+                // Fully faded out: rewind so the next switch starts from the top
+                music.stop();
+            }
+
+            if (gain[i] != target)
+                settled = false;
         }
+        return settled;
+    }
+
+    void run() {
+        PROFILE_THREAD("music");
+        auto last = std::chrono::steady_clock::now();
+        while (true) {
+            Request r;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (quit)
+                    break;
+                r = request;
+                dirty = false;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            float dt = std::chrono::duration<float>(now - last).count();
+            last = now;
+
+            bool settled = step(r, dt);
 
-        if (!healBuffer.loadFromFile(FileSystem::getPath("resources/audio/_heal.wav"))) {
-            std::cout << "Warning: Failed to load heal sound\n";
+            std::unique_lock<std::mutex> lock(mutex);
+            if (settled) {
+                wake.wait(lock, [this] { return quit || dirty; });
+                last = std::chrono::steady_clock::now();   // don't count the idle time as fade time
+            }
+            else {
+                wake.wait_for(lock, std::chrono::milliseconds(MUSIC_FADE_STEP_MS), [this] { return quit || dirty; });
+            }
         }
+    }
 
-        if (!menuBackBuffer.loadFromFile(FileSystem::getPath("resources/audio/_menuback.wav"))) {
-            std::cout << "Warning: Failed to load menuback sound\n";
+public:
+    MusicManager() : dirty(false), quit(false) {
+        request = { -1, true, false, -1.0f };
+        for (int i = 0; i < (int)MusicTrack::Count; ++i) {
+            gain[i] = 0.0f;
+            opened[i] = tracks[i].openFromFile(FileSystem::getPath(MUSIC_ASSETS[i].path));
+            if (!opened[i])
+                std::cout << "Warning: Failed to open music " << MUSIC_ASSETS[i].path << "\n";
         }
+        worker = std::thread(&MusicManager::run, this);
+    }
 
-        if (!openingBuffer.loadFromFile(FileSystem::getPath("resources/audio/_opening.wav"))) {
-            std::cout << "Warning: Failed to load opening sound\n";
+    ~MusicManager() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
         }
+        wake.notify_one();
+        if (worker.joinable())
+            worker.join();
+        for (auto& music : tracks)
+            music.stop();
+    }
+
+    // Crossfade from whatever is playing to 'track'
+    void play(MusicTrack track, bool loop) {
+        Request r = current();
+        r.track = (int)track;
+        r.loop = loop;
+        r.paused = false;
+        post(r);
+    }
+
+    // Fade everything out
+    void stop() {
+        Request r = current();
+        r.track = -1;
+        r.paused = false;
+        post(r);
+    }
+
+    void pause() {
+        Request r = current();
+        r.paused = true;
+        post(r);
+    }
+
+    // Resumes only the track that was active, faded ones stay silent
+    void resume() {
+        Request r = current();
+        r.paused = false;
+        post(r);
+    }
+
+    void setVolume(float volume) {
+        Request r = current();
+        r.volume = volume;
+        post(r);
+    }
+};
+
+// ==================== SOUND SYSTEM ====================
+enum class Sfx {
+    ChooseButton,
+    GameBack,
+    GameOver,
+    GunShot,
+    Heal,
+    Opening,
+    StartGame,
+    Count
+};
+
+// One row per effect. Buffers are loaded once from here at startup.
+struct SfxAsset {
+    const char* path;   // relative to the resources root
+    float volume;
+    int priority;       // higher priority can steal voices from lower
+    int maxVoices;      // how many copies of this effect may overlap
+};
+
+const SfxAsset SFX_ASSETS[(int)Sfx::Count] = {
+    { "resources/audio/_choosebutton.wav",  80.0f, 2, 2 },  // ChooseButton
+    { "resources/audio/_gameback.wav",     100.0f, 2, 1 },  // GameBack
+    { "resources/audio/_gameover.wav",     100.0f, 3, 1 },  // GameOver
+    { "resources/audio/_gunshot.wav",      100.0f, 0, 6 },  // GunShot
+    { "resources/audio/_heal.wav",          60.0f, 1, 2 },  // Heal
+    { "resources/audio/_opening.wav",      100.0f, 2, 1 },  // Opening
+    { "resources/audio/_startgame.wav",    100.0f, 3, 1 },  // StartGame
+};
+
+// Total mixer voices. Every sf::Sound is created up front, playing an effect
+// never allocates; when the pool is full a voice gets stolen instead.
+const int MAX_SFX_VOICES = 12;
+
+class SoundManager {
+private:
+    MusicManager music;
+
+    sf::SoundBuffer buffers[(int)Sfx::Count];
+
+    struct Voice {
+        Sfx effect;                // effect whose buffer is bound to this voice
+        int priority;
+        unsigned long long age;    // play sequence number, smaller = older
+    };
+
+    std::vector<sf::Sound> voices;
+    std::vector<Voice> voiceInfo;
+    unsigned long long playCounter;
+
+    bool initialized;
+
+    bool isVoiceBusy(int v) const {
+        return voices[v].getStatus() != sf::Sound::Status::Stopped;
+    }
 
-        if (!startGameBuffer.loadFromFile(FileSystem::getPath("resources/audio/_startgame.wav"))) {
-            std::cout << "Warning: Failed to load startgame sound\n";
+    // Pick the voice to use for 'id', or -1 if the request should be dropped.
+    int acquireVoice(Sfx id) {
+        const SfxAsset& asset = SFX_ASSETS[(int)id];
+
+        // Per-effect cap: restart the oldest copy of the same effect
+        int sameCount = 0;
+        int oldestSame = -1;
+        for (int v = 0; v < (int)voices.size(); ++v) {
+            if (!isVoiceBusy(v) || voiceInfo[v].effect != id)
+                continue;
+            sameCount++;
+            if (oldestSame < 0 || voiceInfo[v].age < voiceInfo[oldestSame].age)
+                oldestSame = v;
         }
+        if (sameCount >= asset.maxVoices)
+            return oldestSame;
+
+        // Free voice, preferring one already bound to this buffer so rapid
+        // fire keeps reusing the same voices without rebinding
+        int freeVoice = -1;
+        for (int v = 0; v < (int)voices.size(); ++v) {
+            if (isVoiceBusy(v))
+                continue;
+            if (voiceInfo[v].effect == id)
+                return v;
+            if (freeVoice < 0)
+                freeVoice = v;
+        }
+        if (freeVoice >= 0)
+            return freeVoice;
+
+        // Pool is full: steal the lowest priority voice, oldest first,
+        // but never one that is more important than the new sound
+        int victim = -1;
+        for (int v = 0; v < (int)voices.size(); ++v) {
+            if (voiceInfo[v].priority > asset.priority)
+                continue;
+            if (victim < 0 ||
+                voiceInfo[v].priority < voiceInfo[victim].priority ||
+                (voiceInfo[v].priority == voiceInfo[victim].priority && voiceInfo[v].age < voiceInfo[victim].age))
+                victim = v;
+        }
+        return victim;
+    }
+
+    void playSfx(Sfx id) {
+        if (!initialized)
+            return;
 
+        int v = acquireVoice(id);
+        if (v < 0)
+            return;
 
-        chooseButtonSound = new sf::Sound(chooseButtonBuffer);
-        gameBackSound = new sf::Sound(gameBackBuffer);
-        gameOverSound = new sf::Sound(gameOverBuffer);
-        gunShotSound = new sf::Sound(gunShotBuffer);
-        healSound = new sf::Sound(healBuffer);
-        menuBackSound = new sf::Sound(menuBackBuffer);
-        openingSound = new sf::Sound(openingBuffer);
-        startGameSound = new sf::Sound(startGameBuffer);
+        sf::Sound& voice = voices[v];
+        voice.stop();
+        if (voiceInfo[v].effect != id) {
+            voice.setBuffer(buffers[(int)id]);
+            voiceInfo[v].effect = id;
+        }
+        voice.setVolume(SFX_ASSETS[(int)id].volume);
+        voiceInfo[v].priority = SFX_ASSETS[(int)id].priority;
+        voiceInfo[v].age = ++playCounter;
+        voice.play();
+    }
+
+public:
+    SoundManager() : playCounter(0), initialized(false) {
+        // Load every effect buffer exactly once
+        for (int i = 0; i < (int)Sfx::Count; ++i) {
+            if (!buffers[i].loadFromFile(FileSystem::getPath(SFX_ASSETS[i].path))) {
+                std::cout << "Warning: Failed to load sound " << SFX_ASSETS[i].path << "\n";
+            }
+        }
 
-        // Set volumes
-        gunShotSound->setVolume(100);
-        chooseButtonSound->setVolume(80);
-        healSound->setVolume(60);
+        // Preallocate the voice pool, all voices start bound to the gunshot
+        // buffer since that is the effect that gets fired the most
+        voices.reserve(MAX_SFX_VOICES);
+        voiceInfo.reserve(MAX_SFX_VOICES);
+        for (int v = 0; v < MAX_SFX_VOICES; ++v) {
+            voices.emplace_back(buffers[(int)Sfx::GunShot]);
+            voiceInfo.push_back({ Sfx::GunShot, 0, 0 });
+        }
 
         initialized = true;
-        std::cout << "Sound system initialized!\n";
+        std::cout << "Sound system initialized! (" << MAX_SFX_VOICES << " voices)\n";
     }
 
-
     ~SoundManager() {
-        delete chooseButtonSound;
-        delete gameBackSound;
-        delete gameOverSound;
-        delete gunShotSound;
-        delete healSound;
-        delete menuBackSound;
-        delete openingSound;
-        delete startGameSound;
+        stopAllSounds();
     }
 
     // ==================== BACKGROUND MUSIC ====================
     void playMenuMusic(bool loop = true) {
-        if (backgroundMusic.openFromFile(FileSystem::getPath("resources/audio/_menuback.wav"))) {
-            backgroundMusic.setLooping(loop);
-            backgroundMusic.setVolume(30);
-            backgroundMusic.play();
-            std::cout << "Playing menu music\n";
-        }
+        music.play(MusicTrack::Menu, loop);
     }
 
     void playGameMusic(bool loop = true) {
-        stopBackgroundMusic();
-        if (gamebackMusic.openFromFile(FileSystem::getPath("resources/audio/_gameback.wav"))) {
-            gamebackMusic.setLooping(loop);
-            gamebackMusic.setVolume(25);
-            gamebackMusic.play();
-            std::cout << "Playing game music\n";
-        }
+        music.play(MusicTrack::Game, loop);
     }
 
     void stopBackgroundMusic() {
-        backgroundMusic.stop();
-        gamebackMusic.stop();
+        music.stop();
     }
 
     void pauseBackgroundMusic() {
-        backgroundMusic.pause();
-        gamebackMusic.pause();
+        music.pause();
     }
 
     void resumeBackgroundMusic() {
-        backgroundMusic.play();
-        gamebackMusic.play();
+        music.resume();
     }
 
     void setMusicVolume(float volume) {
-        backgroundMusic.setVolume(volume);
-        gamebackMusic.setVolume(volume);
+        music.setVolume(volume);
     }
 
     // ==================== SOUND EFFECTS ====================
     void playChooseButton() {
-        if (initialized) {
-            chooseButtonSound->play();
-        }
+        playSfx(Sfx::ChooseButton);
     }
 
     void playGunShot() {
-        if (initialized) {
-            gunShotSound->play();
-        }
+        playSfx(Sfx::GunShot);
     }
 
     void playHeal() {
-        if (initialized) {
-            healSound->play();
-        }
+        playSfx(Sfx::Heal);
     }
 
     void playGameOver() {
         if (initialized) {
             stopBackgroundMusic();
-            gameOverSound->play();
+            playSfx(Sfx::GameOver);
         }
     }
 
     void playOpening() {
-        if (initialized) {
-            openingSound->play();
-        }
+        playSfx(Sfx::Opening);
     }
 
     void playStartGame() {
-        if (initialized) {
-            startGameSound->play();
-        }
+        playSfx(Sfx::StartGame);
     }
 
     void playGameBack() {
-        if (initialized) {
-            gameBackSound->play();
-        }
+        playSfx(Sfx::GameBack);
     }
 
     void stopAllSounds() {
-        chooseButtonSound->stop();
-        gameBackSound->stop();
-        gameOverSound->stop();
-        gunShotSound->stop();
-        healSound->stop();
-        menuBackSound->stop();
-        openingSound->stop();
-        startGameSound->stop();
+        for (auto& voice : voices)
+            voice.stop();
     }
 };
 
@@ -230,18 +462,134 @@ enum class GameState {
 
 GameState gameState = GameState::MENU;
 
+// Draw calls issued this frame, reported as a trace counter
+int frameDrawCalls = 0;
+
+void drawArraysCounted(GLenum mode, GLint first, GLsizei count)
+{
+    frameDrawCalls++;
+    glDrawArrays(mode, first, count);
+}
+
+// ==================== ALLOCATION BUDGET ====================
+// A PLAYING frame is expected to make no heap allocations once it has warmed
+// up. Strings and scratch arrays that only live for one frame go into
+// frameArena, which is reset at the top of every frame.
+FrameArena frameArena(64 * 1024);
+
+const int ALLOC_CHECK_WARMUP = 120;         // PLAYING frames ignored by --alloc-check
+const int ALLOC_CHECK_DEFAULT_FRAMES = 1800;
+
+// Which zones allocated in the last frame. Zones nest, so "frame" includes
+// everything below it.
+void printZoneAllocs()
+{
+#if NYX_PROFILER
+    profiler::Profiler& prof = profiler::Profiler::instance();
+    for (int z = 0; z < prof.zoneCount(); ++z)
+    {
+        profiler::ZoneStats st = prof.stats(z);
+        if (st.allocs > 0)
+            std::cout << "    " << st.name << ": " << st.allocs << std::endl;
+    }
+#endif
+}
+
+// ==================== STREAMING ====================
+// Everything rewritten per frame (text quads, bullet instances, bone
+// palettes) is written into streamBuffer, see stream_buffer.h. The per-frame
+// budget is sized in main from the target and bullet capacity.
+StreamBuffer streamBuffer;
+GLint uniformOffsetAlignment = 256;     // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+const size_t STREAM_TEXT_BYTES = 256 * 1024;
+const size_t TEXT_VERTEX_BYTES = 4 * sizeof(float);
+const size_t PALETTE_BYTES = MAX_SKIN_BONES * sizeof(glm::mat4);   // matches BonePalette in anim_model.vs
+const size_t DQ_PALETTE_BYTES = MAX_SKIN_BONES * sizeof(DualQuat); // matches BonePalette in anim_model_dq.vs
+bool dualQuatSkinning = false;          // --skinning dq: palettes of dual quaternions (dual_quat.h)
+size_t paletteBytes = PALETTE_BYTES;    // per skinned instance, for the skinning in use
+
 int selectedIndex = 0;   // 0 = Start, 1 = Quit
 int pausedSelectedIndex = 0;  // 0 = Resume, 1 = Return to Menu
 
-struct Character {
-    unsigned int TextureID;
-    glm::ivec2   Size;
-    glm::ivec2   Bearing;
-    unsigned int Advance;
-};
+Character Characters[128];    // indexed by ASCII code, rectangles of fontAtlasTexture
+unsigned int fontAtlasTexture = 0;
+unsigned int textVAO;               // reads vec4 vertices from streamBuffer
+
+// The SDF atlas is baked with FreeType the first time a font is seen, then
+// loaded from here (font_atlas.h)
+const char* FONT_CACHE_DIR = "font_cache";
+
+bool bakeFontAtlas(const std::vector<unsigned char>& fontFile, FontAtlas& atlas)
+{
+    FT_Library ft;
+    FT_Face face;
+    if (FT_Init_FreeType(&ft)) {
+        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        return false;
+    }
+    if (FT_New_Memory_Face(ft, fontFile.data(), (FT_Long)fontFile.size(), 0, &face)) {
+        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+        FT_Done_FreeType(ft);
+        return false;
+    }
+
+    FT_Set_Pixel_Sizes(face, 0, FONT_PIXEL_SIZE * FONT_BAKE_SCALE);
+    atlas.begin();
+    for (int c = FONT_FIRST_GLYPH; c <= FONT_LAST_GLYPH; c++)
+    {
+        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
+            std::cout << "ERROR::FREETYPE: Failed to load Glyph" << std::endl;
+            continue;
+        }
+        const FT_GlyphSlot glyph = face->glyph;
+        atlas.addGlyph(c, glyph->bitmap.buffer, glyph->bitmap.width, glyph->bitmap.rows, glyph->bitmap.pitch,
+            glyph->bitmap_left, glyph->bitmap_top, (unsigned int)glyph->advance.x);
+    }
+    atlas.end();
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+    return true;
+}
+
+// Fills Characters and fontAtlasTexture, from the cache when it holds an
+// atlas of this font file
+void initFontAtlas(const std::string& fontPath)
+{
+    std::ifstream file(fontPath, std::ios::binary);
+    std::vector<unsigned char> fontFile((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (fontFile.empty()) {
+        std::cout << "ERROR::FREETYPE: Failed to load font: " << fontPath << std::endl;
+        return;
+    }
 
-std::map<char, Character> Characters;
-unsigned int textVAO, textVBO;
+    FontAtlas atlas;
+    uint64_t key = FontAtlas::key(fontFile);
+    std::string cachePath = std::string(FONT_CACHE_DIR) + "/" + std::filesystem::path(fontPath).filename().string() + ".sdf";
+    bool cached = atlas.load(cachePath, key);
+    if (!cached)
+    {
+        if (!bakeFontAtlas(fontFile, atlas))
+            return;
+        std::error_code error;
+        std::filesystem::create_directories(FONT_CACHE_DIR, error);
+        if (error || !atlas.save(cachePath, key))
+            std::cout << "Warning: could not write " << cachePath << std::endl;
+    }
+    std::memcpy(Characters, atlas.glyphs, sizeof(Characters));
+
+    glGenTextures(1, &fontAtlasTexture);
+    glBindTexture(GL_TEXTURE_2D, fontAtlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas.width, atlas.height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    std::cout << "Font atlas: " << atlas.width << "x" << atlas.height << (cached ? ", from " : ", baked to ") << cachePath << std::endl;
+}
 
 
 unsigned int quadVAO = 0, quadVBO = 0;
@@ -284,7 +632,7 @@ void initTriangle()
     glBindVertexArray(0);
 }
 
-void drawTriangle(Shader& shader, glm::vec2 pos, glm::vec2 size, glm::vec3 color, float rotation = 0.0f)
+void drawTriangle(CachedProgram& shader, glm::vec2 pos, glm::vec2 size, glm::vec3 color, float rotation = 0.0f)
 {
     glm::mat4 model = glm::mat4(1.0f);
 
@@ -302,7 +650,7 @@ void drawTriangle(Shader& shader, glm::vec2 pos, glm::vec2 size, glm::vec3 color
     shader.setVec3("color", color);
 
     glBindVertexArray(triangleVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
+    drawArraysCounted(GL_TRIANGLES, 0, 3);
 }
 
 void initQuad()
@@ -328,7 +676,7 @@ bool isMouseOver(float mx, float my, float x, float y, float w, float h)
     return (mx >= x && mx <= x + w && my >= y && my <= y + h);
 }
 
-void drawButton(Shader& shader, glm::vec2 pos, glm::vec2 size, glm::vec3 color)
+void drawButton(CachedProgram& shader, glm::vec2 pos, glm::vec2 size, glm::vec3 color)
 {
     glm::mat4 model = glm::mat4(1.0f);
 
@@ -341,10 +689,10 @@ void drawButton(Shader& shader, glm::vec2 pos, glm::vec2 size, glm::vec3 color)
     shader.setVec3("color", color);
 
     glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    drawArraysCounted(GL_TRIANGLES, 0, 6);
 }
 
-void drawHealthBar(Shader& shader, float health, float maxHealth, float screenHeight)
+void drawHealthBar(CachedProgram& shader, float health, float maxHealth, float screenHeight)
 {
     float barWidth = 200.0f;
     float barHeight = 20.0f;
@@ -358,7 +706,7 @@ void drawHealthBar(Shader& shader, float health, float maxHealth, float screenHe
     shader.setMat4("model", model);
     shader.setVec3("color", glm::vec3(0.2f, 0.2f, 0.2f));
     glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    drawArraysCounted(GL_TRIANGLES, 0, 6);
 
     float healthPercent = health / maxHealth;
     float healthBarWidth = barWidth * healthPercent;
@@ -379,45 +727,43 @@ void drawHealthBar(Shader& shader, float health, float maxHealth, float screenHe
         model = glm::scale(model, glm::vec3(healthBarWidth, barHeight - 4.0f, 1.0f));
         shader.setMat4("model", model);
         shader.setVec3("color", healthColor);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        drawArraysCounted(GL_TRIANGLES, 0, 6);
     }
 }
 
 
-void RenderText(Shader& shader, std::string text, float x, float y, float scale, glm::vec3 color)
+// All quads of the string are written in one go and drawn in one call from
+// the font atlas
+void RenderText(CachedProgram& shader, const char* text, float x, float y, float scale, glm::vec3 color)
 {
+    size_t length = strlen(text);
+    if (length == 0)
+        return;
+
+    GLintptr offset;
+    float (*vertices)[4] = (float(*)[4])streamBuffer.map(length * 6 * TEXT_VERTEX_BYTES, TEXT_VERTEX_BYTES, offset);
+    if (!vertices)
+        return;
+
+    int glyphs = 0;
+    for (const char* p = text; *p; ++p)
+    {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 128)
+            continue;
+        float quad[6][4];
+        x += layoutGlyph(Characters[c], x, y, scale, quad);
+        memcpy(vertices + glyphs * 6, quad, sizeof(quad));
+        glyphs++;
+    }
+    streamBuffer.unmap();
+
     shader.use();
     shader.setVec3("textColor", color);
     glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, fontAtlasTexture);
     glBindVertexArray(textVAO);
-
-    for (auto c : text)
-    {
-        Character ch = Characters[c];
-
-        float xpos = x + ch.Bearing.x * scale;
-        float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
-
-        float w = ch.Size.x * scale;
-        float h = ch.Size.y * scale;
-
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos,     ypos,       0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 0.0f }
-        };
-
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-
-        x += (ch.Advance >> 6) * scale;
-    }
+    drawArraysCounted(GL_TRIANGLES, (GLint)(offset / TEXT_VERTEX_BYTES), glyphs * 6);
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
@@ -426,17 +772,17 @@ void RenderText(Shader& shader, std::string text, float x, float y, float scale,
 int currentScore = 0;
 int highScore = 0;
 
-void drawScore(Shader& textShader, int score, int highScore, float screenWidth, float screenHeight)
+void drawScore(CachedProgram& textShader, int score, int highScore, float screenWidth, float screenHeight)
 {
     textShader.use();
 
-    std::string scoreText = "Score: " + std::to_string(score);
+    const char* scoreText = frameArena.format("Score: %d", score);
     float scoreX = screenWidth - 200.0f;
     float scoreY = screenHeight - 40.0f;
 
     RenderText(textShader, scoreText, scoreX, scoreY, 0.8f, glm::vec3(1, 1, 1));
 
-    std::string highScoreText = "High Score: " + std::to_string(highScore);
+    const char* highScoreText = frameArena.format("High Score: %d", highScore);
     float highScoreX = screenWidth - 250.0f;
     float highScoreY = screenHeight - 75.0f;
 
@@ -444,38 +790,65 @@ void drawScore(Shader& textShader, int score, int highScore, float screenWidth,
 }
 
 
-struct Bullet {
-    glm::vec3 position;
-    glm::vec3 direction;
-    float speed;
-    float life;
-};
+// Targets and the player are entities, bullets are in their own ring;
+// components and systems are in game_sim.h
+ecs::World world;
+ProjectileRing bullets;
+ecs::Entity player = ecs::NULL_ENTITY;
+Level level;                // walls and floor everything collides with, --level file
+NavGrid navGrid;            // where targets can walk in the level
+FlowField enemyField;       // every target's way to the nearest living player
 
-std::vector<Bullet> bullets;
-const float BULLET_SPEED = 15.0f;
-const float BULLET_LIFETIME = 3.0f;
-
-struct Target {
-    glm::vec3 position;
-    float speed;
-    Animator* animator;     // per-target animator (allocated with new at spawn)
-    glm::vec3 bboxMin;      // local-space AABB min
-    glm::vec3 bboxMax;      // local-space AABB max
-    glm::vec3 modelScale;   // model scale used when rendering -> apply to bbox
-};
+const int MAX_BULLETS = 256;
+size_t bulletCapacity = MAX_BULLETS;   // size of the bullet ring, shots past it are dropped
 
-std::vector<Target> targets;
-const float TARGET_SPEED = 1.2f;
-const float SPAWN_INTERVAL = 3.0f;
+const int MAX_TARGETS = 64;
 float timeSinceLastSpawn = 0.0f;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void processInput(GLFWwindow* window);
-void updateCamera();
-bool bulletHitsTarget(const Bullet& bullet, const Target& target);
-void cleanupTargets(); // cleanup any leftover dynamic animators on exit
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void window_refresh_callback(GLFWwindow* window);
+void processInput(ecs::Entity entity, uint32_t buttons, uint32_t pressed, float yaw, float pitch);
+void movePlayer(ecs::Entity entity, uint32_t buttons, float yaw);
+InputFrame sampleInput(GLFWwindow* window, float dt);
+void applyMouseLook(const InputFrame& input);
+uint32_t simStateHash();
+void updateCamera(const glm::vec3& focus);
+void simulateTick(const InputFrame& input);
+void cleanupTargets(); // return every target's animator to the pool
+void shutdownGame();   // release audio and GL resources, then glfwTerminate
+
+// Enemy animators are all created at load time. Spawning takes one from the
+// free list, killing a target puts it back.
+std::vector<SkeletalAnimator> enemyAnimators;
+std::vector<int> freeEnemyAnimators;
+SkeletalAnimator* acquireEnemyAnimator();
+void releaseEnemyAnimator(SkeletalAnimator* animator);
+ecs::Entity spawnTarget(const glm::vec3& position);
+
+// ==================== LOAD TEST ====================
+// --load-test replaces the normal 3 s spawn with a configurable trickle plus
+// burst waves, adds bots that shoot at random targets and stops after a fixed
+// simulation time, printing frame and per-zone stats for the whole run.
+LoadTestConfig loadTest;
+
+struct Shooter {
+    glm::vec3 position;
+    float cooldown;         // seconds until the next shot
+};
+
+std::vector<Shooter> shooters;
+float loadTestSpawnBudget = 0.0f;   // targets owed by spawn_rate, fractional
+float loadTestWaveTimer = 0.0f;
+int loadTestSpawned = 0;
+int loadTestKills = 0;
+int loadTestPeakTargets = 0;
+int loadTestPeakBullets = 0;
+
+void updateLoadTest(float dt);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -488,252 +861,1637 @@ float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
 // timing
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+// The simulation runs in fixed steps of simClock.step(); a frame runs however
+// many steps its dt adds up to and draws between the last two of them.
+float deltaTime = 0.0f;     // the fixed step inside simulateTick()
+double gameTime = 0.0;      // sum of every frame's dt
+double simTime = 0.0;       // sum of every simulated step
+FixedStepClock simClock;
+FramePacer framePacer;
+InputFrame simInput = {};   // buttons for the next step, presses wait for a step to use them
+
+// ==================== INPUT ====================
+// The key, mouse and scroll callbacks only accumulate. Each tick takes the
+// totals through sampleInput() (or from a replay file), so live, recorded and
+// replayed sessions all drive the simulation through the same InputFrame.
+float pendingMouseDx = 0.0f;
+float pendingMouseDy = 0.0f;
+float pendingScroll = 0.0f;
+uint32_t heldKeyButtons = 0;        // InputButton bits of keys currently down
+bool mouseFireHeld = false;         // left mouse, fire has two sources
+uint32_t pendingPressed = 0;        // presses since the last sampleInput()
+
+Rng gameRng;                // everything the simulation randomizes
+InputRecorder inputRecorder;
+InputReplay inputReplay;
+
+// ==================== IDLE SCREENS ====================
+// The menu and pause screens only change when a key is pressed. Instead of
+// redrawing and polling every iteration they redraw when something on them
+// changed and otherwise block in glfwWaitEventsTimeout, so sitting in a menu
+// costs next to no CPU. Replays, the load test and --alloc-check keep
+// spinning since they need every frame.
+const double IDLE_WAIT_TIMEOUT = 0.25;     // seconds, also the overlay refresh rate
+
+struct IdleScreen {
+    bool enabled = true;
+    bool dirty = true;          // set by input and window callbacks
+    int drawnState = -1;        // what is on screen right now
+    int drawnSelection = -1;
+
+    // reported at exit
+    double seconds = 0.0;
+    int wakeups = 0;
+    int redraws = 0;
+
+    bool needsRedraw(GameState state, int selection, bool overlay) const {
+        return !enabled || dirty || overlay || (int)state != drawnState || selection != drawnSelection;
+    }
+
+    void drawn(GameState state, int selection) {
+        dirty = false;
+        drawnState = (int)state;
+        drawnSelection = selection;
+        redraws++;
+    }
 
-// player (character)
-glm::vec3 characterPosition = glm::vec3(0.0f, 0.09f, 0.0f);
+    // End of a menu or pause iteration. Only blocks while the game is still
+    // on one of those screens, a transition to PLAYING polls and goes on.
+    void wait(GameState state) {
+        if (enabled && (state == GameState::MENU || state == GameState::PAUSED))
+            glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT);
+        else
+            glfwPollEvents();
+    }
+};
+
+IdleScreen idleScreen;
+
+// Records frame times for a few frames after a game state change so we can
+// see whether the transition (music switch, cursor mode, cleanup) hitched.
+struct TransitionProbe {
+    const char* label = nullptr;
+    double lastTime = 0.0;
+    double typicalMs = 0.0;     // running average of ordinary frames
+    double worstMs = 0.0;
+    double totalMs = 0.0;
+    int frames = 0;
+    int framesLeft = 0;
+
+    void arm(const char* what) {
+        label = what;
+        worstMs = 0.0;
+        totalMs = 0.0;
+        frames = 0;
+        framesLeft = 30;
+    }
+
+    // call once at the top of every loop iteration
+    void onFrame(double now) {
+        double ms = (now - lastTime) * 1000.0;
+        bool first = lastTime == 0.0;
+        lastTime = now;
+        if (first)
+            return;
+
+        if (framesLeft > 0) {
+            worstMs = std::max(worstMs, ms);
+            totalMs += ms;
+            frames++;
+            if (--framesLeft == 0) {
+                std::cout << "[frame] " << label << ": " << frames << " frames, avg "
+                    << totalMs / frames << " ms, worst " << worstMs
+                    << " ms (typical " << typicalMs << " ms)" << std::endl;
+            }
+        }
+        else {
+            typicalMs = typicalMs == 0.0 ? ms : typicalMs * 0.95 + ms * 0.05;
+        }
+    }
+};
+
+TransitionProbe transitionProbe;
+
+// player (character), movement tuning is in game_sim.h
 float characterYaw = 0.0f; // rotation of the player model
 float cameraYaw = 0.0f;    // horizontal orbit angle around the player
 float cameraPitch = 0.0f;
 glm::vec3 characterScale = glm::vec3(0.5f);
-const float CHARACTER_SPEED = 2.5f; // units/sec
 const float MOUSE_SENSITIVITY = 0.1f;
 const float CAMERA_DISTANCE = 3.0f; // distance behind character
 const float CAMERA_HEIGHT = 1.5f;   // height above character
 
-// Health System
-float playerHealth = 100.0f;
-const float MAX_HEALTH = 100.0f;
-bool playerDead = false;
-float respawnTimer = 0.0f;
-const float RESPAWN_TIME = 3.0f;
-const float ENEMY_DAMAGE = 20.0f;
-float lastDamageTime = 0.0f;
-const float DAMAGE_COOLDOWN = 1.0f;
-
-// animation state (player)
-Animation* idleAnimPtr = nullptr;
-Animation* runForwardPtr = nullptr;
-Animation* runBackPtr = nullptr;
-Animation* runLeftPtr = nullptr;
-Animation* runRightPtr = nullptr;
-Animation* runForwardLeftPtr = nullptr;
-Animation* runForwardRightPtr = nullptr;
-Animation* runBackLeftPtr = nullptr;
-Animation* runBackRightPtr = nullptr;
-Animation* currentAnimPtr = nullptr;
-Animator* animatorPtr = nullptr;
-
-// Enemy model + animation pointers (point to objects created in main)
-Model* enemyModelPtr = nullptr;
-Animation* enemyRunPtr = nullptr;
-
-unsigned int cubeVAO = 0, cubeVBO = 0;
-
-float cubeVertices[] = {
-    // A simple 1x1x1 cube (36 vertices)
-    -0.5f,-0.5f,-0.5f,  0.5f,-0.5f,-0.5f,  0.5f, 0.5f,-0.5f,
-     0.5f, 0.5f,-0.5f, -0.5f, 0.5f,-0.5f, -0.5f,-0.5f,-0.5f,
-    -0.5f,-0.5f, 0.5f,  0.5f,-0.5f, 0.5f,  0.5f, 0.5f, 0.5f,
-     0.5f, 0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f,-0.5f, 0.5f,
-    -0.5f, 0.5f, 0.5f, -0.5f, 0.5f,-0.5f, -0.5f,-0.5f,-0.5f,
-    -0.5f,-0.5f,-0.5f, -0.5f,-0.5f, 0.5f, -0.5f, 0.5f, 0.5f,
-     0.5f, 0.5f, 0.5f,  0.5f, 0.5f,-0.5f,  0.5f,-0.5f,-0.5f,
-     0.5f,-0.5f,-0.5f,  0.5f,-0.5f, 0.5f,  0.5f, 0.5f, 0.5f,
-    -0.5f,-0.5f,-0.5f,  0.5f,-0.5f,-0.5f,  0.5f,-0.5f, 0.5f,
-     0.5f,-0.5f, 0.5f, -0.5f,-0.5f, 0.5f, -0.5f,-0.5f,-0.5f,
-    -0.5f, 0.5f,-0.5f,  0.5f, 0.5f,-0.5f,  0.5f, 0.5f, 0.5f,
-     0.5f, 0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f,-0.5f
+// Player-only component: the clip for each movement direction, indexed by
+// PlayerState::clip. Health and respawn tuning is in game_sim.h.
+struct Locomotion {
+    const AnimClip* clips[CLIP_COUNT];
 };
 
-void initCube() {
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
+Locomotion playerLocomotion;    // filled in main, every player uses the same clips
 
-    glBindVertexArray(cubeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
+Transform& playerTransform() { return *world.get<Transform>(player); }
+Health& playerHealth() { return *world.get<Health>(player); }
+PlayerState& playerState() { return *world.get<PlayerState>(player); }
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glBindVertexArray(0);
+ecs::Entity createPlayer(int slot, SkeletalAnimator* animator)
+{
+    const AnimClip* idle = playerLocomotion.clips[CLIP_IDLE];
+    animator->PlayAnimation(idle);
+    PlayerState state = { slot, 0.0f, 0.0f, CLIP_IDLE, false, 0.0f, 0.0f };
+    return world.create(Transform{ PLAYER_START, PLAYER_START }, Health{ MAX_HEALTH, MAX_HEALTH },
+        AnimationState{ animator, idle }, state, playerLocomotion);
 }
 
-int main()
+// Switch animation only if changed
+void setPlayerClip(ecs::Entity entity, int clip)
 {
-    srand((unsigned int)time(nullptr));
-
-    // glfw init + callbacks
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#endif
+    world.get<PlayerState>(entity)->clip = clip;
+    const AnimClip* newAnim = world.get<Locomotion>(entity)->clips[clip];
+    AnimationState& anim = *world.get<AnimationState>(entity);
+    if (newAnim != anim.clip)
+    {
+        anim.clip = newAnim;
+        anim.animator->PlayAnimation(newAnim);
+    }
+}
 
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Granny Please Go Home", NULL, NULL);
-    if (!window) { std::cout << "Failed to create window\n"; glfwTerminate(); return -1; }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+bool anyPlayerAlive()
+{
+    bool alive = false;
+    world.each<PlayerState>([&](const PlayerState& state) { alive = alive || !state.dead; });
+    return alive;
+}
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) { std::cout << "Failed GLAD\n"; return -1; }
-    stbi_set_flip_vertically_on_load(true);
-    glEnable(GL_DEPTH_TEST);
+// Camera position relative to the character for an orbit angle
+glm::vec3 cameraOffset(float yaw, float pitch)
+{
+    float yawRad = glm::radians(yaw);
+    float pitchRad = glm::radians(pitch);
 
+    // behind and up
+    glm::vec3 offset;
+    offset.x = CAMERA_DISTANCE * sin(yawRad) * cos(pitchRad);
+    offset.y = CAMERA_HEIGHT + CAMERA_DISTANCE * sin(pitchRad);
+    offset.z = CAMERA_DISTANCE * cos(yawRad) * cos(pitchRad);
+    return offset;
+}
 
-    // Load text shader (after OpenGL context exists)
-    Shader textShader("text.vs", "text.fs");
+// Where a player aims: the way its follow camera looks (see updateCamera),
+// worked out from yaw and pitch alone so the server can aim for clients
+glm::vec3 aimDirection(float yaw, float pitch)
+{
+    return glm::normalize(glm::vec3(0.0f, 1.0f, 0.0f) - cameraOffset(yaw, pitch));
+}
 
-    // ----------------- TEXT RENDERING INIT -----------------
-    FT_Library ft;
-    FT_Face face;
-    if (FT_Init_FreeType(&ft)) {
-        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+// ==================== NETWORK ====================
+// Co-op over UDP, see net_session.h. --host makes this game the server: it
+// simulates everything, remote players included, from their inputs and
+// sends snapshots. --connect makes it a client: it sends its input every
+// tick, predicts its own movement and replays the inputs the server had not
+// applied yet on top of every snapshot. Enemies and bullets go where the
+// snapshots say and keep moving locally in between.
+NetServer netServer;
+NetClient netClient;
+uint32_t simTick = 0;
+
+// Server
+ecs::Entity netPlayers[NET_MAX_PLAYERS];            // by slot, slot 0 is 'player'
+NetInput netLastInput[NET_MAX_PLAYERS] = {};
+std::vector<SkeletalAnimator> remoteAnimators;      // one per slot, made in main
+NetSnapshot netSnapshot;
+
+// Client
+std::vector<ecs::Entity> netMirror;     // local entity for each server entity id
+std::vector<uint32_t> netBulletMirror(0x10000 - NET_BULLET_ID_BASE, PROJECTILE_NONE);   // local bullet serial by server bullet id - NET_BULLET_ID_BASE
+NetSnapshot netApplied;                 // the snapshot the world matches
+int netCorrections = 0;                 // snapshots that moved the predicted player
+
+// Server: remote players appear and disappear with their clients
+void serverUpdatePlayers()
+{
+    for (int slot; (slot = netServer.popJoined()) >= 0; )
+    {
+        netPlayers[slot] = createPlayer(slot, &remoteAnimators[slot]);
+        netLastInput[slot] = NetInput();
     }
-
-    std::string fontPath = FileSystem::getPath("resources/fonts/Antonio-Regular.ttf");
-    std::cout << "Loading font from: " << fontPath << std::endl;
-
-    if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
-        std::cout << "ERROR::FREETYPE: Failed to load font: " << fontPath << std::endl;
-        FT_Done_FreeType(ft);
-        glfwTerminate();
+    for (int slot; (slot = netServer.popLeft()) >= 0; )
+    {
+        if (world.alive(netPlayers[slot]))
+            world.destroy(netPlayers[slot]);
+        netPlayers[slot] = ecs::NULL_ENTITY;
     }
+}
 
-    FT_Set_Pixel_Sizes(face, 0, 48);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // disable byte-alignment
-
-    for (unsigned char c = 0; c < 128; c++)
+// Server: this tick's input of a remote player. When none arrived in time
+// the player keeps holding what it held, and lets go if the client stalls.
+NetInput serverInput(int slot, double now)
+{
+    NetInput input;
+    if (netServer.nextInput(slot, input))
     {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            std::cout << "ERROR::FREETYPE: Failed to load Glyph" << std::endl;
-            continue;
-        }
-
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            (unsigned int)face->glyph->advance.x
-        };
-        Characters.insert(std::pair<char, Character>(c, character));
+        netLastInput[slot] = input;
+        return input;
     }
+    input = netLastInput[slot];
+    input.pressed = 0;
+    if (netServer.inputStale(slot, now, 0.25))
+        input.buttons = 0;
+    return input;
+}
 
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+// Server: what a snapshot carries. Entity indices from NET_BULLET_ID_BASE up
+// do not fit the wire id and are left out; bullets take those ids.
+void buildSnapshot(NetSnapshot& snapshot)
+{
+    snapshot.tick = simTick;
+    snapshot.score = (uint32_t)std::max(currentScore, 0);
+    snapshot.entities.clear();
+
+    auto add = [&](ecs::Entity entity, NetEntityType type, const glm::vec3& position) -> NetEntity* {
+        if (entity.index >= NET_BULLET_ID_BASE)
+            return nullptr;
+        NetEntity e = {};
+        e.id = (uint16_t)entity.index;
+        e.generation = (uint8_t)entity.generation;
+        e.type = type;
+        setNetPosition(e, position);
+        snapshot.entities.push_back(e);
+        return &snapshot.entities.back();
+    };
+
+    world.eachEntity<Transform, Health, PlayerState>([&](ecs::Entity entity, const Transform& t, const Health& health, const PlayerState& state) {
+        NetEntity* e = add(entity, NET_ENTITY_PLAYER, t.position);
+        if (!e)
+            return;
+        e->slot = (uint8_t)state.slot;
+        e->yaw = (uint16_t)quantizeAngle(state.yaw, NET_YAW_BITS);
+        e->health = (uint8_t)glm::clamp(health.current, 0.0f, 127.0f);
+        e->clip = (uint8_t)state.clip;
+        e->dead = state.dead ? 1 : 0;
+    });
+    world.eachEntity<Transform, Hitbox>([&](ecs::Entity entity, const Transform& t, const Hitbox&) {
+        add(entity, NET_ENTITY_TARGET, t.position);
+    });
+    bullets.each([&](uint32_t slot) {
+        uint32_t serial = bullets.serial(slot);
+        NetEntity e = {};
+        e.id = (uint16_t)(NET_BULLET_ID_BASE + (serial & 0x7FFF));
+        e.generation = (uint8_t)(serial >> 15);
+        e.type = NET_ENTITY_BULLET;
+        setNetPosition(e, bullets.position(slot));
+        float speed = glm::length(bullets.velocity(slot));
+        for (int axis = 0; axis < 3; ++axis)
+            e.direction[axis] = quantizeUnit(speed > 0.0f ? bullets.velocity(slot)[axis] / speed : 0.0f);
+        e.speed = (uint16_t)std::min(speed * 64.0f, 65535.0f);
+        snapshot.entities.push_back(e);
+    });
+
+    std::sort(snapshot.entities.begin(), snapshot.entities.end(),
+        [](const NetEntity& a, const NetEntity& b) { return a.id < b.id; });
+}
+
+// Client: the local player is never mirrored, the snapshot corrects it
+bool isLocalPlayer(const NetEntity& e)
+{
+    return e.type == NET_ENTITY_PLAYER && e.slot == playerState().slot;
+}
+
+void destroyMirror(const NetEntity& e)
+{
+    if (e.type == NET_ENTITY_BULLET)
+    {
+        // unless it already ran out or hit a wall locally
+        int slot = e.id >= NET_BULLET_ID_BASE ? bullets.find(netBulletMirror[e.id - NET_BULLET_ID_BASE]) : -1;
+        if (slot >= 0)
+            bullets.kill((uint32_t)slot);
+        return;
+    }
+    if (isLocalPlayer(e) || e.id >= netMirror.size())
+        return;
+    ecs::Entity mirror = netMirror[e.id];
+    netMirror[e.id] = ecs::NULL_ENTITY;
+    if (!world.alive(mirror))
+        return;
+    if (e.type == NET_ENTITY_TARGET)
+        releaseEnemyAnimator(world.get<AnimationState>(mirror)->animator);
+    world.destroy(mirror);
+}
+
+void updateMirror(const NetEntity& e)
+{
+    if (e.type == NET_ENTITY_BULLET)
+        return;     // bullets fly on their own once spawned
+    ecs::Entity mirror = netMirror[e.id];
+    if (!world.alive(mirror))
+        return;
+    world.get<Transform>(mirror)->position = netPosition(e);
+    if (e.type != NET_ENTITY_PLAYER)
+        return;
+
+    PlayerState& state = *world.get<PlayerState>(mirror);
+    state.yaw = dequantizeAngle(e.yaw, NET_YAW_BITS);
+    state.dead = e.dead != 0;
+    world.get<Health>(mirror)->current = e.health;
+    setPlayerClip(mirror, std::min((int)e.clip, CLIP_COUNT - 1));
+}
+
+void createMirror(const NetEntity& e)
+{
+    glm::vec3 position = netPosition(e);
+    if (e.type == NET_ENTITY_BULLET)
+    {
+        if (e.id < NET_BULLET_ID_BASE)
+            return;
+        glm::vec3 direction(dequantizeUnit(e.direction[0]), dequantizeUnit(e.direction[1]), dequantizeUnit(e.direction[2]));
+        netBulletMirror[e.id - NET_BULLET_ID_BASE] = createBullet(bullets, position, glm::normalize(direction), e.speed / 64.0f, simTick);
+        return;
+    }
+
+    if (netMirror.size() <= e.id)
+        netMirror.resize(e.id + 1, ecs::NULL_ENTITY);
+
+    ecs::Entity mirror = ecs::NULL_ENTITY;
+    if (e.type == NET_ENTITY_TARGET)
+        mirror = spawnTarget(position);
+    else if (e.slot < NET_MAX_PLAYERS)
+        mirror = createPlayer(e.slot, &remoteAnimators[e.slot]);
+
+    netMirror[e.id] = mirror;
+    updateMirror(e);
+}
+
+// Client: put the local player where the server had it after input
+// 'lastInput', then redo every input sent since
+void reconcilePlayer(const NetEntity& e, uint32_t lastInput)
+{
+    glm::vec3 predicted = playerTransform().position;
+    playerTransform().position = netPosition(e);
+    playerHealth().current = e.health;
+    playerState().dead = e.dead != 0;
+
+    NetInput pending[NET_INPUT_QUEUE * 8];
+    int count = netClient.pendingInputs(lastInput, pending, (int)(sizeof(pending) / sizeof(pending[0])));
+    for (int i = 0; i < count; ++i)
+        movePlayer(player, pending[i].buttons, pending[i].yaw);
+
+    if (glm::length(playerTransform().position - predicted) > 0.01f)
+        netCorrections++;
+}
+
+// Client: make the world match a snapshot. Both lists are sorted by id, so
+// one pass over them finds what the server added, removed or kept.
+void applySnapshot(const NetSnapshot& snapshot, uint32_t lastInput)
+{
+    currentScore = (int)snapshot.score;
+    highScore = std::max(highScore, currentScore);
+
+    const std::vector<NetEntity>& before = netApplied.entities;
+    size_t old = 0;
+    for (const NetEntity& e : snapshot.entities)
+    {
+        while (old < before.size() && before[old].id < e.id)
+            destroyMirror(before[old++]);
+        bool known = false;
+        if (old < before.size() && before[old].id == e.id)
+        {
+            known = before[old].generation == e.generation && before[old].type == e.type;
+            if (!known)
+                destroyMirror(before[old]);     // id reused by a new entity
+            old++;
+        }
+
+        if (isLocalPlayer(e))
+            reconcilePlayer(e, lastInput);
+        else if (known)
+            updateMirror(e);
+        else
+            createMirror(e);
+    }
+    while (old < before.size())
+        destroyMirror(before[old++]);
+
+    netApplied.tick = snapshot.tick;
+    netApplied.score = snapshot.score;
+    netApplied.entities.assign(snapshot.entities.begin(), snapshot.entities.end());
+}
+
+// Client leaving the match: everything mirrored goes, the player is local again
+void leaveNetMatch()
+{
+    netClient.disconnect(glfwGetTime());
+    for (const NetEntity& e : netApplied.entities)
+        destroyMirror(e);
+    netApplied = NetSnapshot();
+    playerState().slot = 0;
+}
+
+// One client tick: apply the newest snapshot, send and predict this tick's
+// input, and carry enemies and bullets forward until the next snapshot
+void clientTick(const InputFrame& input)
+{
+    const NetSnapshot* snapshot;
+    uint32_t lastInput;
+    if (netClient.takeSnapshot(snapshot, lastInput))
+    {
+        PROFILE_ZONE("apply snapshot");
+        applySnapshot(*snapshot, lastInput);
+    }
+
+    // The server respawns us, the timer is only for the countdown on screen
+    PlayerState& state = playerState();
+    state.respawnTimer = state.dead ? state.respawnTimer + deltaTime : 0.0f;
+
+    NetInput sent = netClient.sendInput(input.buttons, input.pressed, cameraYaw, cameraPitch, glfwGetTime());
+    movePlayer(player, sent.buttons, sent.yaw);
+    if ((sent.pressed & BUTTON_FIRE) && !playerState().dead && soundManager)
+        soundManager->playGunShot();
+
+    updateBullets(bullets, level, simTick, deltaTime);
+    glm::vec3 alive[NET_MAX_PLAYERS];
+    int aliveCount = 0;
+    world.each<Transform, PlayerState>([&](const Transform& t, const PlayerState& s) {
+        if (!s.dead && aliveCount < NET_MAX_PLAYERS)
+            alive[aliveCount++] = t.position;
+    });
+    chaseTargets(world, level, enemyField, alive, aliveCount, deltaTime);
+}
+
+// Enemy animation pointer (points to the clip created in main)
+const AnimClip* enemyRunPtr = nullptr;
+
+unsigned int cubeVAO = 0, cubeVBO = 0;
+
+float cubeVertices[] = {
+    // A simple 1x1x1 cube (36 vertices)
+    -0.5f,-0.5f,-0.5f,  0.5f,-0.5f,-0.5f,  0.5f, 0.5f,-0.5f,
+     0.5f, 0.5f,-0.5f, -0.5f, 0.5f,-0.5f, -0.5f,-0.5f,-0.5f,
+    -0.5f,-0.5f, 0.5f,  0.5f,-0.5f, 0.5f,  0.5f, 0.5f, 0.5f,
+     0.5f, 0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f,-0.5f, 0.5f,
+    -0.5f, 0.5f, 0.5f, -0.5f, 0.5f,-0.5f, -0.5f,-0.5f,-0.5f,
+    -0.5f,-0.5f,-0.5f, -0.5f,-0.5f, 0.5f, -0.5f, 0.5f, 0.5f,
+     0.5f, 0.5f, 0.5f,  0.5f, 0.5f,-0.5f,  0.5f,-0.5f,-0.5f,
+     0.5f,-0.5f,-0.5f,  0.5f,-0.5f, 0.5f,  0.5f, 0.5f, 0.5f,
+    -0.5f,-0.5f,-0.5f,  0.5f,-0.5f,-0.5f,  0.5f,-0.5f, 0.5f,
+     0.5f,-0.5f, 0.5f, -0.5f,-0.5f, 0.5f, -0.5f,-0.5f,-0.5f,
+    -0.5f, 0.5f,-0.5f,  0.5f, 0.5f,-0.5f,  0.5f, 0.5f, 0.5f,
+     0.5f, 0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f,-0.5f
+};
+
+void initCube() {
+    glGenVertexArrays(1, &cubeVAO);
+    glGenBuffers(1, &cubeVBO);
+
+    glBindVertexArray(cubeVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
 
-    // Setup VAO/VBO for text
-    glGenVertexArrays(1, &textVAO);
-    glGenBuffers(1, &textVBO);
-    glBindVertexArray(textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glBindVertexArray(0);
+}
+
+// Cube vertices plus one vec4 (position, scale) per instance. The instance
+// attribute is re-pointed into streamBuffer every frame by queueScene().
+unsigned int bulletVAO = 0;
+
+void initBulletVAO()
+{
+    glGenVertexArrays(1, &bulletVAO);
+    glBindVertexArray(bulletVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glBindVertexArray(0);
+}
+
+// Every box of the level baked into one static buffer of world-space
+// position + color vertices, so the whole level is a single draw
+unsigned int levelVAO = 0, levelVBO = 0;
+GLsizei levelVertexCount = 0;
+
+void initLevelMesh()
+{
+    std::vector<float> vertices;
+    vertices.reserve(level.boxes().size() * 36 * 6);
+    for (const LevelBox& box : level.boxes())
+    {
+        glm::vec3 center = (box.min + box.max) * 0.5f;
+        glm::vec3 size = box.max - box.min;
+        for (int v = 0; v < 36; ++v)
+        {
+            glm::vec3 p = center + glm::vec3(cubeVertices[v * 3], cubeVertices[v * 3 + 1], cubeVertices[v * 3 + 2]) * size;
+            vertices.insert(vertices.end(), { p.x, p.y, p.z, box.color.x, box.color.y, box.color.z });
+        }
+    }
+    levelVertexCount = (GLsizei)(vertices.size() / 6);
+
+    glGenVertexArrays(1, &levelVAO);
+    glGenBuffers(1, &levelVBO);
+
+    glBindVertexArray(levelVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, levelVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glBindVertexArray(0);
+}
+
+// ==================== SCENE RENDERING ====================
+// The 3D scene (player, arena, bullets, bots, enemies) goes through
+// renderQueue: queueScene() records packets, submit() sorts and draws them.
+// Menus, overlays and text are 2D painter's-order draws and stay immediate.
+RenderQueue renderQueue;
+RenderStats sceneStats;         // last submitted frame, for the overlay
+int skinnedProgram = -1;
+int colorProgram = -1;
+int bulletProgram = -1;
+int levelProgram = -1;
+
+// Per-mesh draw data gathered once at load. anim_model.fs only samples
+// texture_diffuse1 on unit 0, so each mesh needs its VAO, index count and
+// type and first diffuse texture and nothing else.
+struct MeshDraw {
+    unsigned int vao;
+    unsigned int texture;
+    GLsizei count;
+    GLenum indexType;
+};
+
+std::vector<MeshDraw> playerMeshes;
+std::vector<MeshDraw> enemyMeshes;
+
+// --vertex-format full|compact, see vertex_format.h
+VertexFormat skinnedVertexFormat = VERTEX_COMPACT;
+
+// What the skinned meshes take on the GPU, for the startup report
+struct MeshMemory {
+    int meshes = 0;
+    int compactMeshes = 0;
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+    size_t fullBytes = 0;       // the same meshes as SkinnedVertex with 32-bit indices
+};
+MeshMemory skinnedMemory;
+
+// Vertex and index buffers for every mesh of an imported model, textures
+// from the cache. The buffers live as long as the game. In the compact
+// format meshes that fit are packed and indexed with 16 bits when they can
+// be; normal, tangent and bitangent (locations 1, 3 and 4) are left
+// disabled, the shaders never read them.
+std::vector<MeshDraw> uploadSkinnedModel(const ImportedModel& model, TextureCache& textures, VertexFormat format)
+{
+    std::vector<MeshDraw> draws;
+    std::vector<CompactSkinnedVertex> compact;
+    std::vector<uint16_t> shortIndices;
+    for (const ImportedMesh& mesh : model.meshes)
+    {
+        bool packed = format == VERTEX_COMPACT && packCompactVertices(mesh.vertices, compact);
+        if (format == VERTEX_COMPACT && !packed)
+            std::cout << "Warning: a mesh of " << mesh.vertices.size() << " vertices does not fit the compact vertex format, uploading it full" << std::endl;
+        bool shortIndexed = packed && mesh.vertices.size() <= 65536;
+
+        MeshDraw draw = { 0, 0, (GLsizei)mesh.indices.size(), shortIndexed ? (GLenum)GL_UNSIGNED_SHORT : (GLenum)GL_UNSIGNED_INT };
+        unsigned int buffers[2];
+        glGenVertexArrays(1, &draw.vao);
+        glGenBuffers(2, buffers);
+        glBindVertexArray(draw.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+        size_t vertexBytes = packed ? compact.size() * sizeof(CompactSkinnedVertex) : mesh.vertices.size() * sizeof(SkinnedVertex);
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, packed ? (const void*)compact.data() : (const void*)mesh.vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+        size_t indexBytes = mesh.indices.size() * (shortIndexed ? sizeof(uint16_t) : sizeof(unsigned int));
+        if (shortIndexed)
+        {
+            shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, shortIndices.data(), GL_STATIC_DRAW);
+        }
+        else
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, mesh.indices.data(), GL_STATIC_DRAW);
+
+        if (packed)
+        {
+            const GLsizei stride = sizeof(CompactSkinnedVertex);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(CompactSkinnedVertex, position));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(CompactSkinnedVertex, texCoords));
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, MAX_SKIN_INFLUENCES, GL_UNSIGNED_BYTE, stride, (void*)offsetof(CompactSkinnedVertex, boneIds));
+            glEnableVertexAttribArray(6);
+            glVertexAttribPointer(6, MAX_SKIN_INFLUENCES, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(CompactSkinnedVertex, weights));
+        }
+        else
+        {
+            const GLsizei stride = sizeof(SkinnedVertex);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, position));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, normal));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, texCoords));
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, tangent));
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, bitangent));
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, MAX_SKIN_INFLUENCES, GL_INT, stride, (void*)offsetof(SkinnedVertex, boneIds));
+            glEnableVertexAttribArray(6);
+            glVertexAttribPointer(6, MAX_SKIN_INFLUENCES, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, weights));
+        }
+        glBindVertexArray(0);
+
+        skinnedMemory.meshes++;
+        skinnedMemory.compactMeshes += packed ? 1 : 0;
+        skinnedMemory.vertexBytes += vertexBytes;
+        skinnedMemory.indexBytes += indexBytes;
+        skinnedMemory.fullBytes += mesh.vertices.size() * sizeof(SkinnedVertex) + mesh.indices.size() * sizeof(unsigned int);
+
+        if (!mesh.diffusePath.empty())
+            draw.texture = textures.load(mesh.diffusePath);
+        draws.push_back(draw);
+    }
+    return draws;
+}
+
+void queueSkinned(const std::vector<MeshDraw>& meshes, const glm::mat4& model, const SkeletalAnimator& animator)
+{
+    DrawPacket packet = {};
+    packet.program = skinnedProgram;
+    packet.mode = GL_TRIANGLES;
+    packet.model = model;
+
+    // One palette per instance, shared by all of its meshes
+    void* palette = streamBuffer.map(paletteBytes, uniformOffsetAlignment, packet.palette);
+    if (!palette)
+        return;
+    if (dualQuatSkinning)
+        toDualQuats(animator.GetFinalBoneMatrices().data(), animator.GetBoneCount(), (DualQuat*)palette);
+    else
+        memcpy(palette, animator.GetFinalBoneMatrices().data(), animator.GetBoneCount() * sizeof(glm::mat4));
+    streamBuffer.unmap();
+
+    for (const MeshDraw& mesh : meshes)
+    {
+        packet.vao = mesh.vao;
+        packet.texture = mesh.texture;
+        packet.count = mesh.count;
+        packet.indexType = mesh.indexType;
+        renderQueue.add(packet);
+    }
+}
+
+void queueCube(const glm::mat4& model, const glm::vec3& color)
+{
+    DrawPacket packet = {};
+    packet.program = colorProgram;
+    packet.vao = cubeVAO;
+    packet.mode = GL_TRIANGLES;
+    packet.count = 36;
+    packet.model = model;
+    packet.color = color;
+    packet.palette = -1;
+    renderQueue.add(packet);
+}
+
+// alpha blends every moving object from its previous to its current step
+void queueScene(float alpha)
+{
+    // players, ours facing the camera's way as of this frame
+    world.eachEntity<Transform, PlayerState, AnimationState>([&](ecs::Entity entity, const Transform& t, const PlayerState& state, const AnimationState& anim) {
+        if (state.dead)
+            return;
+        float yaw = entity == player ? characterYaw : state.yaw;
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::mix(t.previous, t.position, alpha));
+        model = glm::rotate(model, glm::radians(yaw + 180.0f), glm::vec3(0, 1, 0));
+        model = glm::scale(model, characterScale);
+        queueSkinned(playerMeshes, model, *anim.animator);
+    });
+
+    // the level, one static draw
+    DrawPacket levelPacket = {};
+    levelPacket.program = levelProgram;
+    levelPacket.vao = levelVAO;
+    levelPacket.mode = GL_TRIANGLES;
+    levelPacket.count = levelVertexCount;
+    levelPacket.model = glm::mat4(1.0f);
+    levelPacket.palette = -1;
+    renderQueue.add(levelPacket);
+
+    // load test bots
+    for (const Shooter& shooter : shooters)
+    {
+        glm::mat4 m = glm::translate(glm::mat4(1.0f), shooter.position);
+        queueCube(glm::scale(m, glm::vec3(0.4f, 1.6f, 0.4f)), glm::vec3(0.2f, 0.6f, 1.0f));
+    }
+
+    // bullets, one instanced draw
+    size_t liveBullets = bulletCount(bullets);
+    if (liveBullets > 0)
+    {
+        GLintptr offset;
+        glm::vec4* instances = (glm::vec4*)streamBuffer.map(liveBullets * sizeof(glm::vec4), sizeof(glm::vec4), offset);
+        if (instances)
+        {
+            bullets.each([&](uint32_t slot) {
+                *instances++ = glm::vec4(glm::mix(bullets.previous(slot), bullets.position(slot), alpha), 0.06f);
+            });
+            streamBuffer.unmap();
+
+            glBindVertexArray(bulletVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, streamBuffer.buffer());
+            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)offset);
+            glBindVertexArray(0);
+
+            DrawPacket packet = {};
+            packet.program = bulletProgram;
+            packet.vao = bulletVAO;
+            packet.mode = GL_TRIANGLES;
+            packet.count = 36;
+            packet.instances = (GLsizei)liveBullets;
+            packet.color = glm::vec3(1.0f, 0.8f, 0.2f);
+            packet.palette = -1;
+            renderQueue.add(packet);
+        }
+    }
+
+    // enemies, each facing the player it chases
+    world.each<Transform, Velocity, Hitbox, AnimationState>([&](const Transform& t, const Velocity& v, const Hitbox& hitbox, const AnimationState& anim) {
+        glm::vec3 position = glm::mix(t.previous, t.position, alpha);
+        glm::mat4 em = glm::mat4(1.0f);
+        em = glm::translate(em, position);
+
+        // robust facing: compute XZ-only direction and use inverse(lookAt)
+        glm::vec3 toPlayer = v.direction;
+        toPlayer.y = 0.0f; // ignore vertical difference so enemy doesn't tilt up/down
+        if (glm::length2(toPlayer) > 1e-6f) {
+            toPlayer = glm::normalize(toPlayer);
+
+            // inverse(view) where view = lookAt(0, toPlayer, up) gives a rotation matrix
+            glm::mat4 rot = glm::inverse(glm::lookAt(glm::vec3(0.0f), toPlayer, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+            // If your model's forward axis is +Z instead of -Z
+            rot = rot * glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0, 1, 0));
+
+            em *= rot; // em = T * R
+        }
+
+        em = glm::scale(em, hitbox.scale); // finally scale: T * R * S
+        queueSkinned(enemyMeshes, em, *anim.animator);
+    });
+}
+
+// Clears and draws the 3D scene from the current camera
+void renderScene(float alpha = 1.0f)
+{
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
+        (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 view = camera.GetViewMatrix();
+
+    {
+        PROFILE_ZONE("queue scene");
+        renderQueue.begin(projection, view, camera.Position, 100.0f);
+        queueScene(alpha);
+    }
+    {
+        PROFILE_ZONE("submit scene");
+        sceneStats = renderQueue.submit();
+        frameDrawCalls += sceneStats.draws;
+    }
+}
+
+// ==================== PAUSE SCENE CACHE ====================
+// Nothing in the 3D scene moves while paused, so the pause transition
+// renders it once into an offscreen color texture and every paused frame
+// just draws that texture under the menu.
+struct SceneCache {
+    unsigned int fbo = 0;
+    unsigned int color = 0;
+    unsigned int depth = 0;
+    int width = 0;
+    int height = 0;
+    bool valid = false;     // cleared whenever the scene may have changed
+};
+
+SceneCache pauseCache;
+
+bool resizeSceneCache(SceneCache& cache, int width, int height)
+{
+    if (cache.fbo && cache.width == width && cache.height == height)
+        return true;
+
+    if (!cache.fbo)
+    {
+        glGenFramebuffers(1, &cache.fbo);
+        glGenTextures(1, &cache.color);
+        glGenRenderbuffers(1, &cache.depth);
+    }
+    cache.width = width;
+    cache.height = height;
+
+    glBindTexture(GL_TEXTURE_2D, cache.color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, cache.depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, cache.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cache.color, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, cache.depth);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete)
+        std::cout << "ERROR::FRAMEBUFFER: pause scene cache is not complete" << std::endl;
+    return complete;
+}
+
+void destroySceneCache(SceneCache& cache)
+{
+    if (!cache.fbo)
+        return;
+    glDeleteFramebuffers(1, &cache.fbo);
+    glDeleteTextures(1, &cache.color);
+    glDeleteRenderbuffers(1, &cache.depth);
+    cache = SceneCache();
+}
+
+// Renders the scene into the cache at the current framebuffer size, at the
+// same point between steps as the last PLAYING frame
+bool captureSceneCache(SceneCache& cache, GLFWwindow* window, float alpha)
+{
+    PROFILE_ZONE("capture paused scene");
+    cache.valid = false;
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    if (width <= 0 || height <= 0 || !resizeSceneCache(cache, width, height))
+        return false;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, cache.fbo);
+    glViewport(0, 0, width, height);
+    renderScene(alpha);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    cache.valid = true;
+    return true;
+}
+
+// Full screen quad with the cached scene, in the same pixel space as the menus
+void drawSceneCache(const SceneCache& cache, CachedProgram& texturedShader)
+{
+    glDisable(GL_DEPTH_TEST);
+    texturedShader.use();
+    texturedShader.setMat4("projection", glm::ortho(0.0f, (float)SCR_WIDTH, 0.0f, (float)SCR_HEIGHT));
+    texturedShader.setMat4("view", glm::mat4(1.0f));
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(SCR_WIDTH * 0.5f, SCR_HEIGHT * 0.5f, 0.0f));
+    model = glm::scale(model, glm::vec3(SCR_WIDTH, SCR_HEIGHT, 1.0f));
+    texturedShader.setMat4("model", model);
+    texturedShader.setInt("texture1", 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, cache.color);
+    glBindVertexArray(quadVAO);
+    drawArraysCounted(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// ==================== PROFILER OVERLAY ====================
+bool showProfiler = false;   // toggled with F3
+const int TRACE_HOTKEY_FRAMES = 300;   // frames captured by F4
+
+// Rolling avg / p99 / max per zone over the last profiler::HISTORY frames
+void drawProfilerOverlay(CachedProgram& textShader)
+{
+#if NYX_PROFILER
+    if (!showProfiler)
+        return;
+
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    textShader.use();
+    textShader.setMat4("projection", glm::ortho(0.0f, (float)SCR_WIDTH, 0.0f, (float)SCR_HEIGHT));
+    textShader.setInt("text", 0);
+
+    const float scale = 0.35f;
+    const float lineHeight = 18.0f;
+    const float columns[5] = { 20.0f, 150.0f, 210.0f, 270.0f, 340.0f };
+    const glm::vec3 headerColor(0.6f, 1.0f, 0.6f);
+    const glm::vec3 rowColor(1.0f, 1.0f, 1.0f);
+
+    float y = SCR_HEIGHT - 110.0f;
+    RenderText(textShader, "zone", columns[0], y, scale, headerColor);
+    RenderText(textShader, "avg", columns[1], y, scale, headerColor);
+    RenderText(textShader, "p99", columns[2], y, scale, headerColor);
+    RenderText(textShader, "max ms", columns[3], y, scale, headerColor);
+    RenderText(textShader, "alloc", columns[4], y, scale, headerColor);
+
+    profiler::Profiler& prof = profiler::Profiler::instance();
+    char value[32];
+    for (int z = 0; z < prof.zoneCount(); ++z)
+    {
+        profiler::ZoneStats st = prof.stats(z);
+        y -= lineHeight;
+
+        RenderText(textShader, st.name, columns[0], y, scale, rowColor);
+        snprintf(value, sizeof(value), "%.2f", st.avgMs);
+        RenderText(textShader, value, columns[1], y, scale, rowColor);
+        snprintf(value, sizeof(value), "%.2f", st.p99Ms);
+        RenderText(textShader, value, columns[2], y, scale, rowColor);
+        snprintf(value, sizeof(value), "%.2f", st.maxMs);
+        RenderText(textShader, value, columns[3], y, scale, rowColor);
+        snprintf(value, sizeof(value), "%d", st.allocs);
+        RenderText(textShader, value, columns[4], y, scale, st.allocs > 0 ? glm::vec3(1, 0.3f, 0.3f) : rowColor);
+    }
+
+    y -= lineHeight;
+    char line[96];
+    snprintf(line, sizeof(line), "scene: %d draws, %d state changes (%d program, %d vao, %d texture)",
+        sceneStats.draws, sceneStats.stateChanges(), sceneStats.programChanges, sceneStats.vaoChanges, sceneStats.textureChanges);
+    RenderText(textShader, line, columns[0], y, scale, headerColor);
+
+    y -= lineHeight;
+    snprintf(line, sizeof(line), "stream: %zu / %zu KB, %d stalls (%s)",
+        streamBuffer.lastFrameUsed() / 1024, streamBuffer.frameBytes() / 1024, streamBuffer.stalls(),
+        streamBuffer.persistent() ? "persistent" : "orphaned");
+    RenderText(textShader, line, columns[0], y, scale, headerColor);
+
+    if (netServer.active())
+    {
+        double now = glfwGetTime();
+        double bytesPerSecond = 0.0;
+        for (int slot = 1; slot < NET_MAX_PLAYERS; ++slot)
+            if (netServer.connected(slot))
+                bytesPerSecond += netServer.traffic(slot).bytesSent / std::max(netServer.connectedSeconds(slot, now), 1.0);
+        y -= lineHeight;
+        snprintf(line, sizeof(line), "net: host, %d clients, %.1f KB/s out, %.0f bytes per snapshot",
+            netServer.clientCount(), bytesPerSecond / 1024.0, netServer.averageSnapshotBytes());
+        RenderText(textShader, line, columns[0], y, scale, headerColor);
+    }
+    else if (netClient.connected())
+    {
+        double seconds = std::max(netClient.connectedSeconds(glfwGetTime()), 1.0);
+        y -= lineHeight;
+        snprintf(line, sizeof(line), "net: player %d, rtt %.0f ms, %.1f KB/s in, %d corrections",
+            netClient.slot(), netClient.rttMs(), netClient.traffic().bytesReceived / seconds / 1024.0, netCorrections);
+        RenderText(textShader, line, columns[0], y, scale, headerColor);
+    }
+
+    if (prof.droppedEvents() > 0)
+    {
+        snprintf(value, sizeof(value), "dropped %u", prof.droppedEvents());
+        RenderText(textShader, value, columns[0], y - lineHeight, scale, glm::vec3(1, 0.3f, 0.3f));
+    }
+#endif
+}
+
+// Wall time of each loading step up to the first frame, printed once
+struct StartupTimer {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last = start;
+    std::vector<std::pair<const char*, float>> steps;
+
+    void mark(const char* step)
+    {
+        auto now = std::chrono::steady_clock::now();
+        steps.emplace_back(step, std::chrono::duration<float, std::milli>(now - last).count());
+        last = now;
+    }
+
+    void print(const ProgramCache& programs, const TextureCache& textures, const AssetRegistry& assets) const
+    {
+        for (const auto& step : steps)
+        {
+            printf("[startup] %-18s %8.2f ms\n", step.first, step.second);
+            if (std::strcmp(step.first, "programs") == 0)
+                programs.printReport();
+            else if (std::strcmp(step.first, "models and clips") == 0)
+            {
+                assets.printReport();
+                textures.printReport();
+                printf("[startup]   %d skinned meshes, %d compact: %.1f KB vertices + %.1f KB indices (%.1f KB in the full format)\n",
+                    skinnedMemory.meshes, skinnedMemory.compactMeshes, skinnedMemory.vertexBytes / 1024.0f,
+                    skinnedMemory.indexBytes / 1024.0f, skinnedMemory.fullBytes / 1024.0f);
+            }
+        }
+        printf("[startup] total %.2f ms\n", std::chrono::duration<float, std::milli>(last - start).count());
+    }
+};
+
+const char* PROGRAM_CACHE_DIR = "program_cache";
+
+int main(int argc, char** argv)
+{
+    PROFILE_THREAD("main");
+    StartupTimer startup;
+
+    // --trace N [file] captures the first N frames as a Chrome trace
+    // --alloc-check [frames] plays unattended and fails on the first PLAYING
+    // frame that allocates after the warm-up
+    // --record file saves this session's input, --replay file plays one back
+    // (uncapped, with --headless skipping rendering, --frame-times file
+    // dumping every frame time in ms)
+    int traceFrames = 0;
+    std::string tracePath = "nyx_trace.json";
+    int allocCheckFrames = 0;
+    std::string recordPath;
+    std::string replayPath;
+    std::string frameTimesPath;
+    bool headless = false;
+    bool streamOrphan = false;      // --stream-orphan: skip persistent mapping, for comparison
+    // --sim-hz N fixed simulation rate, --vsync 0|1, --fps N frame cap (0 = none)
+    int simHz = 60;
+    int vsync = 1;
+    double targetFps = 0.0;
+    // --host [port] runs a co-op match others can join, --connect addr[:port]
+    // joins one; --net-latency ms, --net-jitter ms and --net-loss percent
+    // degrade what this side sends
+    bool hosting = false;
+    uint16_t hostPort = NET_DEFAULT_PORT;
+    std::string connectAddress;
+    LinkSettings netLink;
+    // --level file loads another level (level.h)
+    std::string levelPath = "arena.lvl";
+    // --no-program-cache compiles every shader from source
+    bool useProgramCache = true;
+    // --skinning matrix|dq picks the bone palette format (default matrix),
+    // --vertex-format full|compact the skinned vertex layout (default compact)
+    // --load-test runs the stress test with defaults, --load-test-config file
+    // and --lt key=value change settings (applied in order, see load_test.h)
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--trace" && i + 1 < argc)
+        {
+            traceFrames = std::atoi(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                tracePath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--alloc-check")
+        {
+            allocCheckFrames = ALLOC_CHECK_DEFAULT_FRAMES;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                allocCheckFrames = std::atoi(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--record" && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (std::string(argv[i]) == "--replay" && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (std::string(argv[i]) == "--frame-times" && i + 1 < argc)
+            frameTimesPath = argv[++i];
+        else if (std::string(argv[i]) == "--stream-orphan")
+            streamOrphan = true;
+        else if (std::string(argv[i]) == "--sim-hz" && i + 1 < argc)
+            simHz = std::max(1, atoi(argv[++i]));
+        else if (std::string(argv[i]) == "--vsync" && i + 1 < argc)
+            vsync = atoi(argv[++i]) != 0 ? 1 : 0;
+        else if (std::string(argv[i]) == "--fps" && i + 1 < argc)
+            targetFps = std::max(0.0, atof(argv[++i]));
+        else if (std::string(argv[i]) == "--headless")
+            headless = true;
+        else if (std::string(argv[i]) == "--host")
+        {
+            hosting = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                hostPort = (uint16_t)std::atoi(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--connect" && i + 1 < argc)
+            connectAddress = argv[++i];
+        else if (std::string(argv[i]) == "--net-latency" && i + 1 < argc)
+            netLink.latencyMs = std::max(0.0f, (float)atof(argv[++i]));
+        else if (std::string(argv[i]) == "--net-jitter" && i + 1 < argc)
+            netLink.jitterMs = std::max(0.0f, (float)atof(argv[++i]));
+        else if (std::string(argv[i]) == "--net-loss" && i + 1 < argc)
+            netLink.lossPercent = glm::clamp((float)atof(argv[++i]), 0.0f, 100.0f);
+        else if (std::string(argv[i]) == "--level" && i + 1 < argc)
+            levelPath = argv[++i];
+        else if (std::string(argv[i]) == "--no-program-cache")
+            useProgramCache = false;
+        else if (std::string(argv[i]) == "--skinning" && i + 1 < argc)
+        {
+            std::string mode = argv[++i];
+            if (mode == "dq" || mode == "matrix")
+                dualQuatSkinning = mode == "dq";
+            else
+                std::cout << "Warning: unknown skinning '" << mode << "', expected matrix or dq" << std::endl;
+        }
+        else if (std::string(argv[i]) == "--vertex-format" && i + 1 < argc)
+        {
+            std::string format = argv[++i];
+            if (format == "full" || format == "compact")
+                skinnedVertexFormat = format == "full" ? VERTEX_FULL : VERTEX_COMPACT;
+            else
+                std::cout << "Warning: unknown vertex format '" << format << "', expected full or compact" << std::endl;
+        }
+        else if (std::string(argv[i]) == "--load-test")
+            loadTest.enabled = true;
+        else if (std::string(argv[i]) == "--load-test-config" && i + 1 < argc)
+        {
+            loadTest.enabled = true;
+            if (!loadLoadTestConfig(loadTest, argv[++i]))
+                return -1;
+        }
+        else if (std::string(argv[i]) == "--lt" && i + 1 < argc)
+        {
+            loadTest.enabled = true;
+            if (!applyLoadTestSetting(loadTest, argv[++i]))
+                std::cout << "Warning: unknown load test setting '" << argv[i] << "'" << std::endl;
+        }
+    }
+
+    bool replaying = !replayPath.empty();
+    bool networked = hosting || !connectAddress.empty();
+    if (networked && (replaying || !recordPath.empty() || loadTest.enabled))
+    {
+        // Remote input is not in the recording and would not replay
+        std::cout << "Warning: --host/--connect ignore --record, --replay and the load test" << std::endl;
+        replaying = false;
+        recordPath.clear();
+        loadTest.enabled = false;
+    }
+    if (hosting && !connectAddress.empty())
+    {
+        std::cout << "ERROR::NET: --host and --connect are exclusive" << std::endl;
+        return -1;
+    }
+    NetAddress serverAddress;
+    if (!connectAddress.empty() && !parseNetAddress(connectAddress, NET_DEFAULT_PORT, serverAddress))
+    {
+        std::cout << "ERROR::NET: bad server address '" << connectAddress << "'" << std::endl;
+        return -1;
+    }
+    if (replaying && !inputReplay.load(replayPath))
+        return -1;
+    if (!level.loadFromFile(levelPath))
+        return -1;
+    buildTargetNav(navGrid, level);
+    enemyField.init(navGrid);
+    glm::vec3 levelMin = level.boundsMin(), levelMax = level.boundsMax();
+    if (networked && std::max({ -levelMin.x, -levelMin.z, levelMax.x, levelMax.z }) > NET_WORLD_EXTENT)
+        std::cout << "Warning: level " << levelPath << " is larger than the network protocol's +-" << NET_WORLD_EXTENT << ", positions past it are clamped" << std::endl;
+    headless = headless && replaying;
+
+    uint64_t seed = (uint64_t)time(nullptr);
+    if (replaying)
+        seed = inputReplay.seed();
+    else if (loadTest.enabled)
+        seed = loadTest.seed;
+    gameRng.setSeed(seed);
+
+    // A replay has to step at the rate it was recorded at
+    simClock.setRate(replaying && inputReplay.simHz() > 0 ? (int)inputReplay.simHz() : simHz);
+
+    // glfw init + callbacks
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    if (headless)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);   // still needs a context to load models
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Granny Please Go Home", NULL, NULL);
+    if (!window) { std::cout << "Failed to create window\n"; glfwTerminate(); return -1; }
+    glfwMakeContextCurrent(window);
+    // replays run as fast as they can
+    glfwSwapInterval(replaying ? 0 : vsync);
+    if (!replaying)
+        framePacer.setTargetFps(targetFps);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) { std::cout << "Failed GLAD\n"; return -1; }
+    glEnable(GL_DEPTH_TEST);
+
+
+    startup.mark("window and GL");
+
+    // ----------------- TEXT RENDERING INIT -----------------
+    std::string fontPath = FileSystem::getPath("resources/fonts/Antonio-Regular.ttf");
+    std::cout << "Loading font from: " << fontPath << std::endl;
+    initFontAtlas(fontPath);
+    startup.mark("fonts");
 
     initQuad();
     initTriangle();
 
-    // Shaders
-    Shader menuShader("menu.vs", "menu.fs");
-    Shader skinnedShader("anim_model.vs", "anim_model.fs");
-    Shader platformShader("single_color.vs", "single_color.fs");
+    // Shaders, linked programs come from the program cache when it has them
+    ProgramCache programCache;
+    programCache.init(PROGRAM_CACHE_DIR, useProgramCache);
+    CachedProgram textShader = programCache.load("text.vs", "text.fs");
+    CachedProgram menuShader = programCache.load("menu.vs", "menu.fs");
+    CachedProgram texturedShader = programCache.load("textured.vs", "textured.fs");
+    CachedProgram skinnedShader = programCache.load(dualQuatSkinning ? "anim_model_dq.vs" : "anim_model.vs", "anim_model.fs");
+    CachedProgram platformShader = programCache.load("single_color.vs", "single_color.fs");
+    CachedProgram bulletShader = programCache.load("instanced_color.vs", "single_color.fs");
+    CachedProgram levelShader = programCache.load("level.vs", "level.fs");
+    startup.mark("programs");
+
+    // Skinned meshes only ever sample texture_diffuse1 from unit 0 (see uploadSkinnedModel)
+    skinnedShader.use();
+    skinnedShader.setInt("texture_diffuse1", 0);
+    skinnedProgram = renderQueue.registerProgram(skinnedShader.ID);
+    colorProgram = renderQueue.registerProgram(platformShader.ID);
+    bulletProgram = renderQueue.registerProgram(bulletShader.ID);
+    levelProgram = renderQueue.registerProgram(levelShader.ID);
+
+    // Model textures come from their cooked files (cook/nyx_cook.cpp)
+    TextureCache textureCache;
+    textureCache.init();
+
+    // Models, skeletons and clips; every file is imported once and
+    // characters share one skeleton between all their clips (asset_registry.h)
+    AssetRegistry assets;
 
     // load model + animations (PLAYER)
-    Model ourModel(FileSystem::getPath("resources/objects/gun2/rifle.dae"));
-    Animation idleAnim(FileSystem::getPath("resources/objects/gun2/rifle_idle.dae"), &ourModel);
-    Animation runForwardAnim(FileSystem::getPath("resources/objects/gun2/run_forward.dae"), &ourModel);
-    Animation runBackAnim(FileSystem::getPath("resources/objects/gun2/run_back.dae"), &ourModel);
-    Animation runLeftAnim(FileSystem::getPath("resources/objects/gun2/run_left.dae"), &ourModel);
-    Animation runRightAnim(FileSystem::getPath("resources/objects/gun2/run_right.dae"), &ourModel);
-    Animation runForwardLeftAnim(FileSystem::getPath("resources/objects/gun2/run_forward_left.dae"), &ourModel);
-    Animation runForwardRightAnim(FileSystem::getPath("resources/objects/gun2/run_forward_right.dae"), &ourModel);
-    Animation runBackLeftAnim(FileSystem::getPath("resources/objects/gun2/run_back_left.dae"), &ourModel);
-    Animation runBackRightAnim(FileSystem::getPath("resources/objects/gun2/run_back_right.dae"), &ourModel);
-
-    // assign player animation pointers
-    idleAnimPtr = &idleAnim;
-    runForwardPtr = &runForwardAnim;
-    runBackPtr = &runBackAnim;
-    runLeftPtr = &runLeftAnim;
-    runRightPtr = &runRightAnim;
-    runForwardLeftPtr = &runForwardLeftAnim;
-    runForwardRightPtr = &runForwardRightAnim;
-    runBackLeftPtr = &runBackLeftAnim;
-    runBackRightPtr = &runBackRightAnim;
-
-    Animator animator(&idleAnim);
-    animatorPtr = &animator;
-    animator.PlayAnimation(idleAnimPtr);
-    currentAnimPtr = idleAnimPtr;
+    // The idle clip's hierarchy is the skeleton every clip is played on
+    static const char* const PLAYER_CLIPS[CLIP_COUNT] = {
+        "resources/objects/gun2/rifle_idle.dae",
+        "resources/objects/gun2/run_forward.dae",
+        "resources/objects/gun2/run_back.dae",
+        "resources/objects/gun2/run_left.dae",
+        "resources/objects/gun2/run_right.dae",
+        "resources/objects/gun2/run_forward_left.dae",
+        "resources/objects/gun2/run_forward_right.dae",
+        "resources/objects/gun2/run_back_left.dae",
+        "resources/objects/gun2/run_back_right.dae",
+    };
+    ModelHandle playerModel = assets.model(FileSystem::getPath("resources/objects/gun2/rifle.dae"));
+    SkeletonHandle playerSkeleton = assets.skeleton(playerModel, FileSystem::getPath(PLAYER_CLIPS[CLIP_IDLE]));
+    ClipHandle playerClips[CLIP_COUNT];
+    for (int i = 0; i < CLIP_COUNT; ++i)
+    {
+        playerClips[i] = assets.clip(FileSystem::getPath(PLAYER_CLIPS[i]), playerSkeleton);
+        playerLocomotion.clips[i] = playerClips[i].get();
+    }
+    if (!playerModel || !playerSkeleton || !playerClips[CLIP_IDLE])
+    {
+        glfwTerminate();
+        return -1;
+    }
+    const AnimClip* idleAnim = playerClips[CLIP_IDLE].get();
+
+    // Ours, plus one per slot for the other players of a co-op match
+    SkeletalAnimator animator(playerSkeleton.get(), idleAnim);
+    player = createPlayer(0, &animator);
+    remoteAnimators.reserve(NET_MAX_PLAYERS);
+    for (int slot = 0; slot < NET_MAX_PLAYERS; ++slot)
+        remoteAnimators.emplace_back(playerSkeleton.get(), idleAnim);
+    std::fill(std::begin(netPlayers), std::end(netPlayers), ecs::NULL_ENTITY);
+    netPlayers[0] = player;
 
     // --- ENEMY model + animation load (use your own files here) ---
-    Model enemyModel(FileSystem::getPath("resources/objects/kid/running.dae"));
-    Animation enemyRunAnim(FileSystem::getPath("resources/objects/kid/running.dae"), &enemyModel);
+    // Mesh, skeleton and clip all come from the one import of running.dae
+    std::string enemyPath = FileSystem::getPath("resources/objects/kid/running.dae");
+    ModelHandle enemyModel = assets.model(enemyPath);
+    SkeletonHandle enemySkeleton = assets.skeleton(enemyModel, enemyPath);
+    ClipHandle enemyRunAnim = assets.clip(enemyPath, enemySkeleton);
+    if (!enemyModel || !enemySkeleton || !enemyRunAnim)
+    {
+        glfwTerminate();
+        return -1;
+    }
+
+    enemyRunPtr = enemyRunAnim.get();
 
-    enemyModelPtr = &enemyModel;
-    enemyRunPtr = &enemyRunAnim;
+    // The vertex data is on the GPU now, only the registry needs to let go
+    playerMeshes = uploadSkinnedModel(*playerModel, textureCache, skinnedVertexFormat);
+    enemyMeshes = uploadSkinnedModel(*enemyModel, textureCache, skinnedVertexFormat);
+    playerModel.reset();
+    enemyModel.reset();
+    assets.releaseUnused();
+    startup.mark("models and clips");
+
+    // A load test needs room for its whole target cap and every bot bullet in flight
+    int targetCapacity = MAX_TARGETS;
+    if (loadTest.enabled)
+    {
+        targetCapacity = std::max(targetCapacity, loadTest.maxTargets);
+        bulletCapacity += (int)(loadTest.shooters * loadTest.fireRate * BULLET_LIFETIME * 1.5f);
+    }
+
+    enemyAnimators.reserve(targetCapacity);
+    freeEnemyAnimators.reserve(targetCapacity);
+    for (int i = 0; i < targetCapacity; ++i)
+    {
+        enemyAnimators.emplace_back(enemySkeleton.get(), enemyRunPtr);
+        freeEnemyAnimators.push_back(targetCapacity - 1 - i);
+    }
+    world.reserve<Transform, Velocity, Hitbox, Health, AnimationState>(targetCapacity);
+    bullets.reserve(bulletCapacity);
+    world.reserve<Transform, Health, AnimationState, PlayerState, Locomotion>(NET_MAX_PLAYERS);
+    renderQueue.reserve(NET_MAX_PLAYERS * playerMeshes.size() + targetCapacity * enemyMeshes.size() + shooters.capacity() + 64);
+
+    // One frame's worth of streamed data: text, bullet instances and a
+    // palette per skinned instance (players + every target)
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformOffsetAlignment);
+    paletteBytes = dualQuatSkinning ? DQ_PALETTE_BYTES : PALETTE_BYTES;
+    size_t paletteStride = (paletteBytes + uniformOffsetAlignment - 1) / uniformOffsetAlignment * uniformOffsetAlignment;
+    size_t streamFrameBytes = STREAM_TEXT_BYTES + bulletCapacity * sizeof(glm::vec4) + (targetCapacity + NET_MAX_PLAYERS) * paletteStride;
+    streamBuffer.init(streamFrameBytes, !streamOrphan);
+    renderQueue.setPaletteBuffer(streamBuffer.buffer(), paletteBytes);
+    std::cout << "Stream buffer: " << streamFrameBytes / 1024 << " KB per frame, "
+        << (dualQuatSkinning ? "dual quaternion" : "matrix") << " palettes of " << paletteBytes << " bytes, "
+        << (streamBuffer.persistent() ? "persistently mapped" : "orphaned per frame") << std::endl;
+
+    // Text quads come from the stream buffer, the VAO never changes
+    glGenVertexArrays(1, &textVAO);
+    glBindVertexArray(textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer.buffer());
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, TEXT_VERTEX_BYTES, 0);
+    glBindVertexArray(0);
+
+    // Bots stand evenly spaced on a ring, their first shots staggered
+    if (loadTest.enabled)
+    {
+        shooters.reserve(loadTest.shooters);
+        for (int i = 0; i < loadTest.shooters; ++i)
+        {
+            float angle = 6.2831853f * i / loadTest.shooters;
+            float firstShot = loadTest.fireRate > 0.0f ? (float)i / (loadTest.shooters * loadTest.fireRate) : 0.0f;
+            shooters.push_back({ glm::vec3(cos(angle) * 12.0f, 0.8f, sin(angle) * 12.0f), firstShot });
+        }
+    }
 
     initCube();
+    initBulletVAO();
+    initLevelMesh();
+    startup.mark("buffers");
     soundManager = new SoundManager();
     soundManager->playMenuMusic(true);
+    startup.mark("audio");
+    startup.print(programCache, textureCache, assets);
+
+    // A networked session keeps looping at full rate on every screen, the
+    // netcode is pumped once per loop and must not wait on idle wakeups
+    idleScreen.enabled = !replaying && !loadTest.enabled && allocCheckFrames == 0 && !networked;
+
+    int exitCode = 0;
+    int allocCheckFrame = 0;
+    bool lastFrameWasPlaying = false;
+    float lastSceneAlpha = 1.0f;    // of the last PLAYING frame, the pause screen freezes it
+    uint64_t frameStartAllocs = alloctrack::threadAllocs();
 
-    bool escPressedLastFrame = false;
-    bool enterPressedLastFrame = false;
+    if (allocCheckFrames > 0)
+    {
+        std::cout << "[alloc-check] " << allocCheckFrames << " PLAYING frames, "
+            << ALLOC_CHECK_WARMUP << " warm-up" << std::endl;
+        gameState = GameState::PLAYING;
+        if (soundManager) soundManager->playGameMusic(true);
+    }
 
-    std::string p = FileSystem::getPath("resources/audio/_choosebutton.wav");
-    std::cout << "Resolved path: " << p << std::endl;
+    // A replay starts in whatever state its recording started in
+    if (replaying)
+    {
+        gameState = (GameState)inputReplay.startState();
+        std::cout << "[replay] " << inputReplay.frameCount() << " frames, seed " << seed
+            << (headless ? ", headless" : "") << std::endl;
+    }
+    if (loadTest.enabled)
+    {
+        printf("[load-test] %.0f s, spawn %.1f/s, cap %d, waves of %d every %.1f s, %d bots at %.1f shots/s, seed %llu\n",
+            loadTest.duration, loadTest.spawnRate, loadTest.maxTargets, loadTest.waveSize, loadTest.waveInterval,
+            loadTest.shooters, loadTest.fireRate, (unsigned long long)seed);
+        if (!replaying)
+            gameState = GameState::PLAYING;
+        glfwSwapInterval(0);
+        framePacer.setTargetFps(0.0);
+    }
+    if (!recordPath.empty())
+        inputRecorder.open(recordPath, seed, (uint32_t)gameState, (uint32_t)simClock.hz());
+
+    // A client waits here for the server and plays at the server's rate.
+    // The window stays responsive and can be closed while it does.
+    bool netReady = !hosting || netServer.start(hostPort, netLink, seed);
+    if (netReady && !connectAddress.empty())
+    {
+        std::cout << "[net] connecting to " << connectAddress << std::endl;
+        netReady = netClient.connect(serverAddress, netLink, seed);
+        while (netReady && netClient.connecting() && !glfwWindowShouldClose(window))
+        {
+            double now = glfwGetTime();
+            netClient.receive(now);
+            netClient.flush(now);
+            glfwPollEvents();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        netReady = netReady && netClient.connected();
+    }
+    if (!netReady)
+    {
+        if (netClient.active())
+            netClient.disconnect(glfwGetTime());
+        shutdownGame();
+        return -1;
+    }
+    if (!connectAddress.empty())
+    {
+        simClock.setRate((int)netClient.simHz());
+        playerState().slot = netClient.slot();
+        gameState = GameState::PLAYING;
+        if (soundManager) soundManager->playGameMusic(true);
+    }
+
+    // Whole-run series for the load test report
+    LoadTestSeries loadTestFrameMs;
+    std::vector<LoadTestSeries> loadTestZoneMs;
+    int loadTestFrames = 0;
+    if (loadTest.enabled)
+    {
+        loadTestFrameMs.samples.reserve((size_t)(loadTest.duration * 240.0f));
+#if NYX_PROFILER
+        loadTestZoneMs.resize(profiler::MAX_ZONES);
+#endif
+    }
+
+    // Wall time of every replayed frame, for the summary at the end
+    std::vector<float> replayFrameMs;
+    replayFrameMs.reserve(inputReplay.frameCount());
+    double lastLoopTime = glfwGetTime();
+
+#if NYX_PROFILER
+    if (traceFrames > 0)
+        profiler::Profiler::instance().startCapture(traceFrames, tracePath);
+#else
+    if (traceFrames > 0)
+        std::cout << "Warning: --trace ignored, built with NYX_PROFILER=0" << std::endl;
+#endif
 
     // render loop
     while (!glfwWindowShouldClose(window))
     {
-        // ============ GLOBAL ESC HANDLER============
-        bool escPressed = glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS;
-        bool escJustPressed = escPressed && !escPressedLastFrame;
+        transitionProbe.onFrame(glfwGetTime());
+        PROFILE_FRAME();
+
+        // Heap allocations made by this thread during the previous iteration
+        uint64_t allocsNow = alloctrack::threadAllocs();
+        uint64_t lastFrameAllocs = allocsNow - frameStartAllocs;
+        frameStartAllocs = allocsNow;
+        frameArena.reset();
+        streamBuffer.nextFrame();
 
-        if (escJustPressed && gameState == GameState::PLAYING)
+        if (allocCheckFrames > 0 && lastFrameWasPlaying)
+        {
+            allocCheckFrame++;
+            if (allocCheckFrame > ALLOC_CHECK_WARMUP && lastFrameAllocs > 0)
+            {
+                std::cout << "[alloc-check] FAILED: PLAYING frame " << allocCheckFrame << " made "
+                    << lastFrameAllocs << " heap allocations" << std::endl;
+                printZoneAllocs();
+                exitCode = 1;
+                break;
+            }
+            if (allocCheckFrame >= allocCheckFrames)
+            {
+                std::cout << "[alloc-check] passed: " << allocCheckFrames - ALLOC_CHECK_WARMUP
+                    << " frames without allocating, frame arena high water "
+                    << frameArena.highWater() << " bytes" << std::endl;
+                break;
+            }
+        }
+        lastFrameWasPlaying = gameState == GameState::PLAYING;
+
+        PROFILE_COUNTER("draw calls", frameDrawCalls);
+        PROFILE_COUNTER("state changes", sceneStats.stateChanges());
+        PROFILE_COUNTER("targets", targetCount(world));
+        PROFILE_COUNTER("bullets", bulletCount(bullets));
+        frameDrawCalls = 0;
+        PROFILE_ZONE("frame");
+
+        // ============ INPUT FOR THIS TICK ============
+        double loopNow = glfwGetTime();
+        float loopDt = (float)(loopNow - lastLoopTime);
+        lastLoopTime = loopNow;
+
+        InputFrame input;
+        if (replaying)
+        {
+            if (inputReplay.framesPlayed() > 0)
+                replayFrameMs.push_back(loopDt * 1000.0f);
+            const InputFrame* recorded = inputReplay.next();
+            if (!recorded)
+                break;
+            input = *recorded;
+        }
+        else
+        {
+            input = sampleInput(window, loopDt);
+            inputRecorder.write(input);
+        }
+        gameTime += input.dt;
+        applyMouseLook(input);
+
+        // Network traffic is handled every frame, whatever the state
+        {
+            double now = glfwGetTime();
+            netServer.receive(now, (uint32_t)simClock.hz(), simTick);
+            netClient.receive(now);
+            netServer.flush(now);
+            netClient.flush(now);
+            if (netClient.active() && !netClient.connected())
+                glfwSetWindowShouldClose(window, true);     // the server went away
+        }
+
+        // Samples of the previous frame, then stop once the run is over
+        if (loadTest.enabled)
+        {
+            if (loadTestFrames++ > 0)
+            {
+                loadTestFrameMs.add(loopDt * 1000.0f);
+#if NYX_PROFILER
+                profiler::Profiler& prof = profiler::Profiler::instance();
+                for (int z = 0; z < prof.zoneCount(); ++z)
+                    loadTestZoneMs[z].add((float)prof.lastFrameMs(z));
+#endif
+            }
+            if (gameTime >= loadTest.duration)
+                break;
+        }
+
+        if (gameState == GameState::MENU || gameState == GameState::PAUSED)
+        {
+            idleScreen.seconds += input.dt;
+            idleScreen.wakeups++;
+        }
+
+        // ============ GLOBAL ESC HANDLER============
+        if (input.justPressed(BUTTON_PAUSE) && gameState == GameState::PLAYING)
         {
             gameState = GameState::PAUSED;
+            pauseCache.valid = false;   // re-captured by the first paused frame
             glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+            transitionProbe.arm("playing -> paused");
             std::cout << "Game PAUSED" << std::endl; // debug
         }
-        escPressedLastFrame = escPressed;
         // ============ END GLOBAL ESC HANDLER ============
 
-        // ============ GLOBAL ENTER EDGE DETECTION ============
-        bool enterPressed = glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS;
-        bool enterJustPressed = enterPressed && !enterPressedLastFrame;
-        enterPressedLastFrame = enterPressed;
-        // ============ END GLOBAL ENTER EDGE DETECTION ============
+        if (gameState == GameState::MENU)
+        {
+            // --- INPUT CONTROL ---
+            // Held arrows step through key repeat, not a timer
+            if (input.justPressed(BUTTON_UP))
+            {
+                if (soundManager) soundManager->playChooseButton();
+                selectedIndex--;
+                if (selectedIndex < 0) selectedIndex = 0;
+            }
+            if (input.justPressed(BUTTON_DOWN))
+            {
+                if (soundManager) soundManager->playChooseButton();
+                selectedIndex++;
+                if (selectedIndex > 1) selectedIndex = 1;
+            }
+            if (input.justPressed(BUTTON_CONFIRM))
+            {
+                if (selectedIndex == 0)
+                {
+                    if (soundManager) soundManager->playStartGame();
+                    gameState = GameState::PLAYING;
+                    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+                    if (soundManager) soundManager->playGameMusic(true);
+                    transitionProbe.arm("menu -> playing");
+                    std::cout << "Game STARTED" << std::endl;
+                }
+                if (selectedIndex == 1)
+                    glfwSetWindowShouldClose(window, true);
+            }
+
+            if (headless)
+                continue;
+
+            if (!idleScreen.needsRedraw(gameState, selectedIndex, showProfiler))
+            {
+                idleScreen.wait(gameState);
+                continue;
+            }
 
-        if (gameState == GameState::MENU)
-        {
+            PROFILE_ZONE("render menu");
             glDisable(GL_DEPTH_TEST);
             glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
             glClear(GL_COLOR_BUFFER_BIT);
@@ -743,44 +2501,6 @@ int main()
             menuShader.use();
             menuShader.setMat4("projection", projection);
 
-            // --- INPUT CONTROL ---
-            static double lastInputTime = 0.0;
-            double now = glfwGetTime();
-
-            if (now - lastInputTime > 0.15)
-            {
-                if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
-                {
-                    if (soundManager) soundManager->playChooseButton();
-                    selectedIndex--;
-                    if (selectedIndex < 0) selectedIndex = 0;
-                    lastInputTime = now;
-                }
-                if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
-                {
-                    if (soundManager) soundManager->playChooseButton();
-                    selectedIndex++;
-                    if (selectedIndex > 1) selectedIndex = 1;
-                    lastInputTime = now;
-                }
-                if (enterJustPressed)
-                {
-                    if (selectedIndex == 0)
-                    {
-                        if (soundManager) soundManager->playStartGame();
-                        gameState = GameState::PLAYING;
-                        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-                        if (soundManager) soundManager->playGameMusic(true);
-                        std::cout << "Game STARTED" << std::endl;
-                    }
-                    if (selectedIndex == 1)
-                        glfwSetWindowShouldClose(window, true);
-
-                    lastInputTime = now;
-                }
-            }
-
-
             // --- DRAW MENU BUTTONS ---
             glm::vec2 startPos = glm::vec2(300, 350);
             glm::vec2 quitPos = glm::vec2(300, 230);
@@ -826,171 +2546,83 @@ int main()
                 RenderText(textShader, "QUIT", 350.0f, 260.0f, 1.0f, glm::vec3(0, 1, 1));
             }
 
+            drawProfilerOverlay(textShader);
 
+            PROFILE_ZONE("swap");
             glfwSwapBuffers(window);
-            glfwPollEvents();
+            idleScreen.drawn(gameState, selectedIndex);
+            idleScreen.wait(gameState);
             continue;
         }
         // ============ PAUSED STATE ============
         if (gameState == GameState::PAUSED)
         {
             // Input handling
-            static double lastPauseInputTime = 0.0;
-            double now = glfwGetTime();
-
-            if (now - lastPauseInputTime > 0.15)
+            if (input.justPressed(BUTTON_UP))
             {
-
-                if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
-                {
-                    if (soundManager) soundManager->playChooseButton();
-                    pausedSelectedIndex--;
-                    if (pausedSelectedIndex < 0) pausedSelectedIndex = 0;
-                    lastPauseInputTime = now;
-                }
-                if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
+                if (soundManager) soundManager->playChooseButton();
+                pausedSelectedIndex--;
+                if (pausedSelectedIndex < 0) pausedSelectedIndex = 0;
+            }
+            if (input.justPressed(BUTTON_DOWN))
+            {
+                if (soundManager) soundManager->playChooseButton();
+                pausedSelectedIndex++;
+                if (pausedSelectedIndex > 1) pausedSelectedIndex = 1;
+            }
+            if (input.justPressed(BUTTON_CONFIRM))
+            {
+                if (pausedSelectedIndex == 0)
                 {
-                    if (soundManager) soundManager->playChooseButton();
-                    pausedSelectedIndex++;
-                    if (pausedSelectedIndex > 1) pausedSelectedIndex = 1;
-                    lastPauseInputTime = now;
+                    gameState = GameState::PLAYING;
+                    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+                    transitionProbe.arm("paused -> playing");
+                    std::cout << "Game RESUMED" << std::endl;
                 }
-                if (enterJustPressed)
+                if (pausedSelectedIndex == 1)
                 {
-                    if (pausedSelectedIndex == 0)
-                    {
-                        gameState = GameState::PLAYING;
-                        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-                        std::cout << "Game RESUMED" << std::endl;
+                    // Return to main menu
+                    if (soundManager) {
+                        soundManager->playGameBack();
+                        soundManager->playMenuMusic(true);
                     }
-                    if (pausedSelectedIndex == 1)
-                    {
-                        // Return to main menu
-                        if (soundManager) {
-                            soundManager->playGameBack();
-                            soundManager->playMenuMusic(true);
-                        }
-                        gameState = GameState::MENU;
-                        selectedIndex = 0;
-                        pausedSelectedIndex = 0;
-                        cleanupTargets();
-                        bullets.clear();
-                        currentScore = 0;
-                        playerHealth = MAX_HEALTH;
-                        playerDead = false;
-                        characterPosition = glm::vec3(0.0f, 0.09f, 0.0f);
-                        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-                        std::cout << "Returned to MENU" << std::endl;
-                    }
-                    lastPauseInputTime = now;
+                    gameState = GameState::MENU;
+                    selectedIndex = 0;
+                    pausedSelectedIndex = 0;
+                    if (netClient.active())
+                        leaveNetMatch();
+                    cleanupTargets();
+                    bullets.clear();
+                    currentScore = 0;
+                    resetPlayer(world, player);
+                    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+                    transitionProbe.arm("paused -> menu");
+                    std::cout << "Returned to MENU" << std::endl;
                 }
-
             }
 
-            // Render frozen game scene
-            glEnable(GL_DEPTH_TEST);
-            glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-            glm::mat4 view = camera.GetViewMatrix();
-
-            // Draw player
-            if (!playerDead)
-            {
-                skinnedShader.use();
-                skinnedShader.setMat4("projection", projection);
-                skinnedShader.setMat4("view", view);
-
-                auto transforms = animator.GetFinalBoneMatrices();
-                for (int i = 0; i < (int)transforms.size(); ++i)
-                    skinnedShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
-
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, characterPosition);
-                model = glm::rotate(model, glm::radians(characterYaw + 180.0f), glm::vec3(0, 1, 0));
-                model = glm::scale(model, characterScale);
-                skinnedShader.setMat4("model", model);
-
-                ourModel.Draw(skinnedShader);
-            }
+            if (headless)
+                continue;
 
-            // Draw platform
-            platformShader.use();
-            platformShader.setMat4("projection", projection);
-            platformShader.setMat4("view", view);
-            platformShader.setVec3("color", glm::vec3(0.4f, 0.4f, 0.4f));
-            glm::mat4 m = glm::mat4(1.0f);
-            m = glm::scale(m, glm::vec3(10.0f, 0.2f, 10.0f));
-            platformShader.setMat4("model", m);
-            glBindVertexArray(cubeVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            // Draw walls (same as in playing state)
-            platformShader.setVec3("color", glm::vec3(0.2f, 0.2f, 0.2f));
-            m = glm::mat4(1.0f);
-            m = glm::translate(m, glm::vec3(0.0f, 1.0f, -5.0f));
-            m = glm::scale(m, glm::vec3(10.0f, 2.0f, 0.2f));
-            platformShader.setMat4("model", m);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            m = glm::mat4(1.0f);
-            m = glm::translate(m, glm::vec3(0.0f, 1.0f, 5.0f));
-            m = glm::scale(m, glm::vec3(10.0f, 2.0f, 0.2f));
-            platformShader.setMat4("model", m);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            m = glm::mat4(1.0f);
-            m = glm::translate(m, glm::vec3(-5.0f, 1.0f, 0.0f));
-            m = glm::scale(m, glm::vec3(0.2f, 2.0f, 10.0f));
-            platformShader.setMat4("model", m);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            m = glm::mat4(1.0f);
-            m = glm::translate(m, glm::vec3(5.0f, 1.0f, 0.0f));
-            m = glm::scale(m, glm::vec3(0.2f, 2.0f, 10.0f));
-            platformShader.setMat4("model", m);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            // Draw bullets
-            platformShader.setVec3("color", glm::vec3(1.0f, 0.8f, 0.2f));
-            for (auto& bullet : bullets)
+            if (!idleScreen.needsRedraw(gameState, pausedSelectedIndex, showProfiler))
             {
-                glm::mat4 bm = glm::mat4(1.0f);
-                bm = glm::translate(bm, bullet.position);
-                bm = glm::scale(bm, glm::vec3(0.06f));
-                platformShader.setMat4("model", bm);
-                glBindVertexArray(cubeVAO);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
+                idleScreen.wait(gameState);
+                continue;
             }
 
-            // Draw enemies
-            skinnedShader.use();
-            skinnedShader.setMat4("projection", projection);
-            skinnedShader.setMat4("view", view);
-
-            for (auto& t : targets)
+            // Frozen game scene, rendered once when the pause started
+            PROFILE_ZONE("render paused");
+            int fbWidth, fbHeight;
+            glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+            if (!pauseCache.valid || fbWidth != pauseCache.width || fbHeight != pauseCache.height)
+                captureSceneCache(pauseCache, window, lastSceneAlpha);
+            if (pauseCache.valid)
             {
-                auto boneTransforms = t.animator->GetFinalBoneMatrices();
-                for (int bi = 0; bi < (int)boneTransforms.size(); ++bi)
-                    skinnedShader.setMat4("finalBonesMatrices[" + std::to_string(bi) + "]", boneTransforms[bi]);
-
-                glm::mat4 em = glm::mat4(1.0f);
-                em = glm::translate(em, t.position);
-
-                glm::vec3 toPlayer = characterPosition - t.position;
-                toPlayer.y = 0.0f;
-                if (glm::length2(toPlayer) > 1e-6f) {
-                    toPlayer = glm::normalize(toPlayer);
-                    glm::mat4 rot = glm::inverse(glm::lookAt(glm::vec3(0.0f), toPlayer, glm::vec3(0.0f, 1.0f, 0.0f)));
-                    rot = rot * glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0, 1, 0));
-                    em *= rot;
-                }
-
-                em = glm::scale(em, t.modelScale);
-                skinnedShader.setMat4("model", em);
-                enemyModelPtr->Draw(skinnedShader);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                drawSceneCache(pauseCache, texturedShader);
             }
+            else
+                renderScene(lastSceneAlpha);      // no FBO, draw it live
 
             // Draw semi-transparent overlay
             glDisable(GL_DEPTH_TEST);
@@ -1007,8 +2639,10 @@ int main()
             overlayModel = glm::scale(overlayModel, glm::vec3(SCR_WIDTH, SCR_HEIGHT, 1.0f));
             menuShader.setMat4("model", overlayModel);
             menuShader.setVec3("color", glm::vec3(0.0f, 0.0f, 0.0f));
+            menuShader.setFloat("alpha", 0.5f);
             glBindVertexArray(quadVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            drawArraysCounted(GL_TRIANGLES, 0, 6);
+            menuShader.setFloat("alpha", 1.0f);
 
             // Draw pause menu buttons
             glm::vec2 resumePos = glm::vec2(275, 350);
@@ -1046,379 +2680,211 @@ int main()
                 RenderText(textShader, "MAIN MENU", 290.0f, 260.0f, 1.0f, glm::vec3(0, 1, 1));
             }
 
+            drawProfilerOverlay(textShader);
             glDisable(GL_BLEND);
 
+            PROFILE_ZONE("swap");
             glfwSwapBuffers(window);
-            glfwPollEvents();
+            idleScreen.drawn(gameState, pausedSelectedIndex);
+            idleScreen.wait(gameState);
             continue;
         }
 
         // ============ PLAYING STATE ============
         if (gameState == GameState::PLAYING)
         {
-            // 1. Update Time
             glEnable(GL_DEPTH_TEST);
-            float currentFrame = glfwGetTime();
-            deltaTime = currentFrame - lastFrame;
-            lastFrame = currentFrame;
 
-            // 2. Handle Player Death and Respawn
-            if (playerDead)
+            // 1. Run the fixed steps this frame's time adds up to. Presses
+            // are kept until a step has seen them, so a click in a frame
+            // without a step is not lost.
+            simInput.buttons = input.buttons;
+            simInput.pressed |= input.pressed;
+            int steps = simClock.advance(input.dt);
+            for (int step = 0; step < steps; ++step)
             {
-                respawnTimer += deltaTime;
-                if (respawnTimer >= RESPAWN_TIME)
-                {
-                    // Respawn
-                    playerDead = false;
-                    playerHealth = MAX_HEALTH;
-                    respawnTimer = 0.0f;
-                    characterPosition = glm::vec3(0.0f, 0.09f, 0.0f);
-                    currentScore = 0;
-                    cleanupTargets();
-                    std::cout << "Player Respawned!" << std::endl;
-                }
+                PROFILE_ZONE("sim step");
+                simulateTick(simInput);
+                simInput.pressed = 0;
             }
+            PROFILE_COUNTER("sim steps", steps);
 
-            // 3. Update Game Logic (only if player is alive)
-            if (!playerDead)
-            {
-                processInput(window);
-                updateCamera();
-                animator.UpdateAnimation(deltaTime);
-
-                // Update existing enemies' animations
-                for (auto& t : targets) {
-                    if (t.animator) t.animator->UpdateAnimation(deltaTime);
-                }
-
-                // Target spawn logic
-                timeSinceLastSpawn += deltaTime;
-                if (timeSinceLastSpawn >= SPAWN_INTERVAL)
-                {
-                    timeSinceLastSpawn = 0.0f;
-
-                    float range = 12.0f;
-                    glm::vec3 pos;
-                    do {
-                        pos = glm::vec3(
-                            (rand() % 100 / 100.0f - 0.5f) * 2.0f * range,
-                            0.1f,
-                            (rand() % 100 / 100.0f - 0.5f) * 2.0f * range
-                        );
-                    } while (glm::length(pos - characterPosition) < 2.5f);
-
-                    Target t;
-                    t.position = pos;
-                    t.speed = TARGET_SPEED;
-                    t.animator = new Animator(enemyRunPtr);
-                    t.animator->PlayAnimation(enemyRunPtr);
-
-                    t.modelScale = glm::vec3(0.6f);
-                    t.bboxMin = glm::vec3(-0.3f, 0.0f, -0.3f);
-                    t.bboxMax = glm::vec3(0.3f, 1.5f, 0.3f);
-
-                    targets.push_back(t);
-                }
-
-                // Update bullets
-                for (int i = 0; i < (int)bullets.size(); )
-                {
-                    bullets[i].position += bullets[i].direction * bullets[i].speed * deltaTime;
-                    bullets[i].life -= deltaTime;
-
-                    if (bullets[i].life <= 0.0f)
-                        bullets.erase(bullets.begin() + i);
-                    else
-                        ++i;
-                }
-
-                // Update targets (move toward player)
-                for (auto& t : targets)
-                {
-                    for (auto& t : targets)
-                    {
-                        float distanceToPlayer = glm::length(characterPosition - t.position);
-                        if (distanceToPlayer > 0.5f)
-                        {
-                            glm::vec3 dir = glm::normalize(characterPosition - t.position);
-                            t.position += dir * t.speed * deltaTime;
-                        }
-                    }
-                }
-
-                // Enemy-player collision (damage)
-                if (currentFrame - lastDamageTime >= DAMAGE_COOLDOWN)
-                {
-                    for (const auto& t : targets)
-                    {
-                        float distance = glm::length(t.position - characterPosition);
-                        if (distance < 0.8f)
-                        {
-                            playerHealth -= ENEMY_DAMAGE;
-                            lastDamageTime = currentFrame;
-
-                            std::cout << "Player Hit! Health: " << playerHealth << std::endl;
-
-                            if (playerHealth <= 0.0f)
-                            {
-                                playerHealth = 0.0f;
-                                playerDead = true;
-                                if (soundManager) soundManager->playGameOver();
-                                std::cout << "Player Died!" << std::endl;
-                            }
-                            break;
-                        }
-                    }
-                }
-
-                // Bullet-target collision
-                for (int i = 0; i < (int)bullets.size(); )
-                {
-                    bool bulletRemoved = false;
-
-                    for (int j = 0; j < (int)targets.size(); )
-                    {
-                        if (bulletHitsTarget(bullets[i], targets[j]))
-                        {
-                            if (targets[j].animator) {
-                                delete targets[j].animator;
-                                targets[j].animator = nullptr;
-                            }
-                            targets.erase(targets.begin() + j);
-                            bullets.erase(bullets.begin() + i);
-                            bulletRemoved = true;
-                            currentScore++;
-                            std::cout << "Score: " << currentScore << std::endl;
-
-                            // Update High Score
-                            if (currentScore > highScore) {
-                                highScore = currentScore;
-                                std::cout << "High Score: " << highScore << std::endl;
-                            }
-                            break;
-                        }
-                        else
-                        {
-                            ++j;
-                        }
-                    }
-
-                    if (!bulletRemoved)
-                        ++i;
-                }
-            }
-            else // if player is dead
+            // 2. Poses are only needed for drawing, so they advance once per
+            // frame by the frame's time instead of once per step
+            if (anyPlayerAlive())
             {
-                updateCamera();
+                PROFILE_ZONE("animation");
+                float animDt = simClock.frameTime();
+                world.each<AnimationState>([&](AnimationState& anim) {
+                    anim.animator->UpdateAnimation(animDt);
+                });
             }
 
-            // 4. Render Everything
-            glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            if (headless)
+                continue;
 
-            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
-                (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-            glm::mat4 view = camera.GetViewMatrix();
+            // 3. Render between the last two steps
+            float alpha = simClock.alpha();
+            updateCamera(glm::mix(playerTransform().previous, playerTransform().position, alpha));
+            renderScene(alpha);
+            lastSceneAlpha = alpha;
 
-            // Draw player (skinned)
-            if (!playerDead)
+            // 4. Draw HUD (health bar, scores, messages)
             {
-                skinnedShader.use();
-                skinnedShader.setMat4("projection", projection);
-                skinnedShader.setMat4("view", view);
-
-                auto transforms = animator.GetFinalBoneMatrices();
-                for (int i = 0; i < (int)transforms.size(); ++i)
-                    skinnedShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+                PROFILE_ZONE("render hud");
+                glDisable(GL_DEPTH_TEST);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, characterPosition);
-                model = glm::rotate(model, glm::radians(characterYaw + 180.0f), glm::vec3(0, 1, 0));
-                model = glm::scale(model, characterScale);
-                skinnedShader.setMat4("model", model);
-
-                ourModel.Draw(skinnedShader);
-            }
+                glm::mat4 orthoProjection = glm::ortho(0.0f, (float)SCR_WIDTH, 0.0f, (float)SCR_HEIGHT);
+                menuShader.use();
+                menuShader.setMat4("projection", orthoProjection);
 
-            // Draw platform & bullets & non-skinned objects
-            platformShader.use();
-            platformShader.setMat4("projection", projection);
-            platformShader.setMat4("view", view);
-
-            // platform
-            platformShader.setVec3("color", glm::vec3(0.4f, 0.4f, 0.4f));
-            glm::mat4 m = glm::mat4(1.0f);
-            m = glm::scale(m, glm::vec3(30.0f, 0.2f, 30.0f));
-            platformShader.setMat4("model", m);
-            glBindVertexArray(cubeVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            // walls
-            platformShader.setVec3("color", glm::vec3(0.2f, 0.2f, 0.2f));
-
-            // back wall
-            m = glm::mat4(1.0f);
-            m = glm::translate(m, glm::vec3(0.0f, 1.0f, -15.0f));
-            m = glm::scale(m, glm::vec3(30.0f, 2.0f, 0.2f));
-            platformShader.setMat4("model", m);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            // front
-            m = glm::mat4(1.0f);
-            m = glm::translate(m, glm::vec3(0.0f, 1.0f, 15.0f));
-            m = glm::scale(m, glm::vec3(30.0f, 2.0f, 0.2f));
-            platformShader.setMat4("model", m);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            // left
-            m = glm::mat4(1.0f);
-            m = glm::translate(m, glm::vec3(-15.0f, 1.0f, 0.0f));
-            m = glm::scale(m, glm::vec3(0.2f, 2.0f, 30.0f));
-            platformShader.setMat4("model", m);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            // right
-            m = glm::mat4(1.0f);
-            m = glm::translate(m, glm::vec3(15.0f, 1.0f, 0.0f));
-            m = glm::scale(m, glm::vec3(0.2f, 2.0f, 30.0f));
-            platformShader.setMat4("model", m);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            // bullets
-            platformShader.use();
-            platformShader.setMat4("projection", projection);
-            platformShader.setMat4("view", view);
-            platformShader.setVec3("color", glm::vec3(1.0f, 0.8f, 0.2f)); // yellowish
-
-            for (auto& bullet : bullets)
-            {
-                glm::mat4 bm = glm::mat4(1.0f);
-                bm = glm::translate(bm, bullet.position);
-                bm = glm::scale(bm, glm::vec3(0.06f)); // small bullet
-                platformShader.setMat4("model", bm);
-                glBindVertexArray(cubeVAO);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
+                drawHealthBar(menuShader, playerHealth().current, MAX_HEALTH, (float)SCR_HEIGHT);
 
-            // Draw enemies (skinned)
-            skinnedShader.use();
-            skinnedShader.setMat4("projection", projection);
-            skinnedShader.setMat4("view", view);
+                // Draw scores
+                textShader.use();
+                textShader.setMat4("projection", orthoProjection);
+                drawScore(textShader, currentScore, highScore, (float)SCR_WIDTH, (float)SCR_HEIGHT);
 
-            for (auto& t : targets)
-            {
-                // Set bone transforms from this enemy animator
-                auto boneTransforms = t.animator->GetFinalBoneMatrices();
-                for (int bi = 0; bi < (int)boneTransforms.size(); ++bi)
-                    skinnedShader.setMat4("finalBonesMatrices[" + std::to_string(bi) + "]", boneTransforms[bi]);
+                // show "You Died" message if player is dead
+                if (playerState().dead)
+                {
+                    textShader.use();
+                    textShader.setMat4("projection", orthoProjection);
 
-                // Compute model transform so enemy faces the player
-                glm::mat4 em = glm::mat4(1.0f);
-                em = glm::translate(em, t.position);
+                    float remainingTime = std::max(RESPAWN_TIME - playerState().respawnTimer, 0.0f);
+                    const char* respawnText = frameArena.format("Respawning in %d...", (int)remainingTime + 1);
 
-                // robust facing: compute XZ-only direction and use inverse(lookAt)
-                glm::vec3 toPlayer = characterPosition - t.position;
-                toPlayer.y = 0.0f; // ignore vertical difference so enemy doesn't tilt up/down
-                if (glm::length2(toPlayer) > 1e-6f) {
-                    toPlayer = glm::normalize(toPlayer);
+                    // YOU DIED!
+                    float deathX = 400.0f - 150.0f;  // = 250
+                    float deathY = 350.0f;
 
-                    // inverse(view) where view = lookAt(0, toPlayer, up) gives a rotation matrix
-                    glm::mat4 rot = glm::inverse(glm::lookAt(glm::vec3(0.0f), toPlayer, glm::vec3(0.0f, 1.0f, 0.0f)));
+                    // Respawning 
+                    float respawnX = 400.0f - 200.0f;  // = 200
+                    float respawnY = 280.0f;
 
-                    // If your model's forward axis is +Z instead of -Z
-                    rot = rot * glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0, 1, 0));
+                    RenderText(textShader, "YOU DIED!", deathX, deathY, 1.8f, glm::vec3(1, 0, 0));
+                    RenderText(textShader, respawnText, respawnX, respawnY, 1.0f, glm::vec3(1, 1, 1));
 
-                    em *= rot; // em = T * R
+                    // Final Score
+                    const char* finalScoreText = frameArena.format("Final Score: %d", currentScore);
+                    RenderText(textShader, finalScoreText, 250.0f, 220.0f, 0.9f, glm::vec3(1, 1, 0));
                 }
-
-                em = glm::scale(em, t.modelScale); // finally scale: T * R * S
-                skinnedShader.setMat4("model", em);
-
-                // draw the enemy model
-                enemyModelPtr->Draw(skinnedShader);
             }
 
-            // 5. Draw HUD (health bar, scores, messages)
-            glDisable(GL_DEPTH_TEST);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-            glm::mat4 orthoProjection = glm::ortho(0.0f, (float)SCR_WIDTH, 0.0f, (float)SCR_HEIGHT);
-            menuShader.use();
-            menuShader.setMat4("projection", orthoProjection);
-
-            drawHealthBar(menuShader, playerHealth, MAX_HEALTH, (float)SCR_HEIGHT);
+            drawProfilerOverlay(textShader);
+            glDisable(GL_BLEND);
 
-            // Draw scores
-            textShader.use();
-            textShader.setMat4("projection", orthoProjection);
-            drawScore(textShader, currentScore, highScore, (float)SCR_WIDTH, (float)SCR_HEIGHT);
+            PROFILE_ZONE("swap");
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            framePacer.wait();
+        }
 
-            // show "You Died" message if player is dead
-            if (playerDead)
-            {
-                textShader.use();
-                textShader.setMat4("projection", orthoProjection);
+    }
 
-                float remainingTime = RESPAWN_TIME - respawnTimer;
-                std::string respawnText = "Respawning in " + std::to_string((int)remainingTime + 1) + "...";
+    if (simClock.droppedSteps() > 0)
+        std::cout << "[sim] dropped " << simClock.droppedSteps() << " steps on frames longer than "
+            << FixedStepClock::MAX_STEPS << " steps" << std::endl;
 
-                // YOU DIED!
-                float deathX = 400.0f - 150.0f;  // = 250
-                float deathY = 350.0f;
+    // How much work the menu and pause screens did, compare with the ~1
+    // redraw per wakeup of a spinning loop
+    if (idleScreen.enabled && idleScreen.wakeups > 0)
+    {
+        printf("[idle] menu/pause: %.1f s, %d wakeups, %d redraws (%.1f redraws/s)\n",
+            idleScreen.seconds, idleScreen.wakeups, idleScreen.redraws,
+            idleScreen.seconds > 0.0 ? idleScreen.redraws / idleScreen.seconds : 0.0);
+    }
 
-                // Respawning 
-                float respawnX = 400.0f - 200.0f;  // = 200
-                float respawnY = 280.0f;
 
-                RenderText(textShader, "YOU DIED!", deathX, deathY, 1.8f, glm::vec3(1, 0, 0));
-                RenderText(textShader, respawnText, respawnX, respawnY, 1.0f, glm::vec3(1, 1, 1));
+    if (loadTest.enabled)
+    {
+        printf("[load-test] %.1f s simulated, %d frames, spawned %d, killed %d, peak %d targets / %d bullets\n",
+            gameTime, loadTestFrames, loadTestSpawned, loadTestKills, loadTestPeakTargets, loadTestPeakBullets);
+        printf("[load-test] ms per frame over the whole run:\n");
+        loadTestFrameMs.print("frame time");
+#if NYX_PROFILER
+        profiler::Profiler& prof = profiler::Profiler::instance();
+        for (int z = 0; z < prof.zoneCount(); ++z)
+            loadTestZoneMs[z].print(prof.stats(z).name);
+#endif
+    }
 
-                // Final Score
-                std::string finalScoreText = "Final Score: " + std::to_string(currentScore);
-                RenderText(textShader, finalScoreText, 250.0f, 220.0f, 0.9f, glm::vec3(1, 1, 0));
-            }
+    if (netServer.active())
+    {
+        netServer.stop(glfwGetTime());
+        printf("[net] hosted: %d snapshots (%d full), avg %.0f bytes; link dropped %d of %d packets\n",
+            netServer.snapshotsSent(), netServer.fullSnapshotsSent(), netServer.averageSnapshotBytes(),
+            netServer.link().dropped(), netServer.link().sent());
+    }
+    if (netClient.active())
+    {
+        double now = glfwGetTime();
+        double seconds = std::max(netClient.connectedSeconds(now), 0.001);
+        const NetTraffic& traffic = netClient.traffic();
+        printf("[net] client: %.0f s, %.2f KB/s in, %.2f KB/s out, rtt %.0f ms, %d prediction corrections, link dropped %d of %d packets\n",
+            seconds, traffic.bytesReceived / 1024.0 / seconds, traffic.bytesSent / 1024.0 / seconds, netClient.rttMs(),
+            netCorrections, netClient.link().dropped(), netClient.link().sent());
+        netClient.disconnect(now);
+    }
 
-            glDisable(GL_BLEND);
+    uint32_t finalHash = simStateHash();
+    inputRecorder.finish(finalHash);
 
-            glfwSwapBuffers(window);
-            glfwPollEvents();
+    if (replaying)
+    {
+        std::cout << "[replay] played " << inputReplay.framesPlayed() << "/" << inputReplay.frameCount() << " frames" << std::endl;
+        if (inputReplay.framesPlayed() == inputReplay.frameCount())
+        {
+            bool exact = finalHash == inputReplay.expectedHash();
+            std::cout << "[replay] final state " << (exact ? "matches" : "DIFFERS FROM") << " the recording" << std::endl;
+            if (!exact)
+                exitCode = 1;
         }
 
-    }
-
-
-    // cleanup dynamic animators attached to targets
-    cleanupTargets();
+        if (!replayFrameMs.empty())
+        {
+            if (!frameTimesPath.empty())
+            {
+                FILE* file = fopen(frameTimesPath.c_str(), "w");
+                if (file)
+                {
+                    for (float ms : replayFrameMs)
+                        fprintf(file, "%.4f\n", ms);
+                    fclose(file);
+                }
+                else
+                    std::cout << "Warning: could not write " << frameTimesPath << std::endl;
+            }
 
-    if (soundManager) {
-        delete soundManager;
-        soundManager = nullptr;
+            std::vector<float> sorted = replayFrameMs;
+            std::sort(sorted.begin(), sorted.end());
+            double total = 0.0;
+            for (float ms : sorted)
+                total += ms;
+            size_t n = sorted.size();
+            printf("[replay] frame ms: avg %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f  (%.1f s)\n",
+                total / n, sorted[n / 2], sorted[std::min(n - 1, n * 95 / 100)],
+                sorted[std::min(n - 1, n * 99 / 100)], sorted[n - 1], total / 1000.0);
+        }
     }
 
-    glfwTerminate();
-    return 0;
+    shutdownGame();
+    return exitCode;
 }
 
 // Update camera position to follow character
-void updateCamera()
+// Orbit camera around 'focus', the character position (interpolated when drawing)
+void updateCamera(const glm::vec3& focus)
 {
     characterYaw = cameraYaw;
 
     // Calculate camera position behind character
-    float yawRad = glm::radians(cameraYaw);
-    float pitchRad = glm::radians(cameraPitch);
-
-    // Offset from character (behind and up)
-    glm::vec3 offset;
-    offset.x = CAMERA_DISTANCE * sin(yawRad) * cos(pitchRad);
-    offset.y = CAMERA_HEIGHT + CAMERA_DISTANCE * sin(pitchRad);
-    offset.z = CAMERA_DISTANCE * cos(yawRad) * cos(pitchRad);
-
-    camera.Position = characterPosition + offset;
+    camera.Position = focus + cameraOffset(cameraYaw, cameraPitch);
 
     // Make camera look at character (slightly above center)
-    glm::vec3 lookAtPoint = characterPosition + glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec3 lookAtPoint = focus + glm::vec3(0.0f, 1.0f, 0.0f);
     glm::vec3 direction = glm::normalize(lookAtPoint - camera.Position);
 
     // Update camera's front vector
@@ -1427,96 +2893,169 @@ void updateCamera()
     camera.Up = glm::normalize(glm::cross(camera.Right, camera.Front));
 }
 
-void processInput(GLFWwindow* window)
+// One fixed step of gameplay. Everything that moves remembers where it was
+// so the frame can draw in between steps.
+void simulateTick(const InputFrame& input)
 {
-    if (playerDead) return;
-
-    float yawRad = glm::radians(cameraYaw);
-    glm::vec3 camForward = glm::normalize(glm::vec3(-sin(yawRad), 0.0f, -cos(yawRad)));
-    glm::vec3 camRight = glm::normalize(glm::vec3(cos(yawRad), 0.0f, -sin(yawRad)));
-
-    glm::vec3 moveDir(0.0f);
-
-    bool w = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
-    bool s = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
-    bool a = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
-    bool d = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
-
-    if (w) moveDir += camForward;
-    if (s) moveDir -= camForward;
-    if (a) moveDir -= camRight;
-    if (d) moveDir += camRight;
-
-    bool moving = glm::length(moveDir) > 0.01f;
-    if (moving)
-    {
-        moveDir = glm::normalize(moveDir);
-        characterPosition += moveDir * CHARACTER_SPEED * deltaTime;
-    }
-
-    // Keep within area
-    float limit = 15.0f;
-    characterPosition.x = glm::clamp(characterPosition.x, -limit, limit);
-    characterPosition.z = glm::clamp(characterPosition.z, -limit, limit);
-
-    // Pick the right animation
-    Animation* newAnim = idleAnimPtr;
-    if (moving)
-    {
-        if (w && a && !s && !d)
-            newAnim = runForwardLeftPtr;
-        else if (w && d && !s && !a)
-            newAnim = runForwardRightPtr;
-        else if (s && a && !w && !d)
-            newAnim = runBackLeftPtr;
-        else if (s && d && !w && !a)
-            newAnim = runBackRightPtr;
-        else if (w && !a && !s && !d)
-            newAnim = runForwardPtr;
-        else if (s && !a && !w && !d)
-            newAnim = runBackPtr;
-        else if (a && !w && !s && !d)
-            newAnim = runLeftPtr;
-        else if (d && !w && !s && !a)
-            newAnim = runRightPtr;
-        else
-            newAnim = runForwardPtr; // fallback
+    deltaTime = simClock.step();
+    simTime += deltaTime;
+    simTick++;
+    float currentFrame = (float)simTime;
+
+    storePreviousPositions(world, bullets);
+
+    if (netClient.connected())
+    {
+        clientTick(input);
+        return;
     }
+    if (netServer.active())
+        serverUpdatePlayers();
 
-    // Switch animation only if changed
-    if (newAnim != currentAnimPtr)
+    // Handle Player Death and Respawn
+    bool respawned = false;
+    updateRespawns(world, deltaTime, [&](ecs::Entity entity) { respawned = respawned || entity == player; });
+    if (respawned)
     {
-        currentAnimPtr = newAnim;
-        animatorPtr->PlayAnimation(newAnim);
+        // Alone, dying ends the round; in co-op the others play on
+        if (!netServer.active())
+        {
+            currentScore = 0;
+            cleanupTargets();
+        }
+        std::cout << "Player Respawned!" << std::endl;
     }
 
-    // Shooting (press J or Left Mouse)
-    static bool shootPressedLastFrame = false;
-    bool jPressed = glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS;
-    bool mousePressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
-    bool shootPressed = jPressed || mousePressed;
+    // Every player moves and shoots from its own input, ours from this machine
+    {
+        PROFILE_ZONE("input");
+        processInput(player, input.buttons, input.pressed, cameraYaw, cameraPitch);
+        double now = glfwGetTime();
+        for (int slot = 1; slot < NET_MAX_PLAYERS; ++slot)
+        {
+            if (!world.alive(netPlayers[slot]))
+                continue;
+            NetInput remote = serverInput(slot, now);
+            processInput(netPlayers[slot], remote.buttons, remote.pressed, remote.yaw, remote.pitch);
+        }
+    }
 
-    if (shootPressed && !shootPressedLastFrame)
+    // Update Game Logic (only while someone is alive)
+    glm::vec3 players[NET_MAX_PLAYERS];
+    int aliveCount = alivePlayers(world, players, NET_MAX_PLAYERS);
+    if (aliveCount > 0)
     {
-        // Aim where the camera looks
-        glm::vec3 forward = glm::normalize(glm::vec3(camera.Front.x, camera.Front.y, camera.Front.z));
+        // Target spawn logic
+        {
+            PROFILE_ZONE("spawning");
+            timeSinceLastSpawn += deltaTime;
+            if (loadTest.enabled)
+            {
+                updateLoadTest(deltaTime);
+            }
+            else if (timeSinceLastSpawn >= SPAWN_INTERVAL && !freeEnemyAnimators.empty())
+            {
+                timeSinceLastSpawn = 0.0f;
+                glm::vec3 position;
+                if (randomSpawnPoint(gameRng, level, players, aliveCount, position))
+                    spawnTarget(position);
+            }
+        }
+
+        // Update bullets
+        {
+            PROFILE_ZONE("bullets");
+            updateBullets(bullets, level, simTick, deltaTime);
+        }
+
+        // Update targets (follow the flow field to the nearest player)
+        {
+            PROFILE_ZONE("chase");
+            chaseTargets(world, level, enemyField, players, aliveCount, deltaTime);
+        }
+
+        PROFILE_ZONE("collision");
 
-        Bullet bullet;
-        bullet.position = characterPosition + glm::vec3(-0.1f, 0.8f, 0.0f);
-        bullet.direction = forward;
-        bullet.speed = BULLET_SPEED;
-        bullet.life = BULLET_LIFETIME;
-        bullets.push_back(bullet);
+        // Enemy-player collision (damage)
+        bool invulnerable = loadTest.enabled && loadTest.invulnerable;
+        if (!invulnerable)
+        {
+            applyContactDamage(world, currentFrame, [](ecs::Entity entity, const Health& health, bool died) {
+                if (entity != player)
+                    return;
+                std::cout << "Player Hit! Health: " << health.current << std::endl;
+                if (died)
+                {
+                    if (soundManager) soundManager->playGameOver();
+                    std::cout << "Player Died!" << std::endl;
+                }
+            });
+        }
+
+        // Bullet-target collision
+        resolveBulletHits(world, bullets, [](ecs::Entity target) {
+            releaseEnemyAnimator(world.get<AnimationState>(target)->animator);
+            currentScore++;
+            if (loadTest.enabled)
+                loadTestKills++;    // thousands of kills, keep the console quiet
+            else
+                std::cout << "Score: " << currentScore << std::endl;
+
+            // Update High Score
+            if (currentScore > highScore) {
+                highScore = currentScore;
+                if (!loadTest.enabled)
+                    std::cout << "High Score: " << highScore << std::endl;
+            }
+        });
+    }
 
-        if (soundManager) soundManager->playGunShot();
+    if (netServer.active() && simTick % (uint32_t)std::max(simClock.hz() / NET_SNAPSHOT_RATE, 1) == 0)
+    {
+        PROFILE_ZONE("snapshot");
+        buildSnapshot(netSnapshot);
+        netServer.sendSnapshot(netSnapshot, glfwGetTime());
     }
+}
+
+// Walking and the locomotion clip for one tick of a player's buttons. The
+// server and client prediction both move players through here.
+void movePlayer(ecs::Entity entity, uint32_t buttons, float yaw)
+{
+    PlayerState& state = *world.get<PlayerState>(entity);
+    if (state.dead) return;
+    state.yaw = yaw;
+
+    glm::vec3& position = world.get<Transform>(entity)->position;
+    int clip = stepPlayer(level, position, (buttons & BUTTON_FORWARD) != 0, (buttons & BUTTON_BACK) != 0,
+        (buttons & BUTTON_LEFT) != 0, (buttons & BUTTON_RIGHT) != 0, yaw, deltaTime);
+    setPlayerClip(entity, clip);
+}
+
+// One tick of a player's input on the machine that owns the simulation
+void processInput(ecs::Entity entity, uint32_t buttons, uint32_t pressed, float yaw, float pitch)
+{
+    PlayerState& state = *world.get<PlayerState>(entity);
+    if (state.dead) return;
+    state.pitch = pitch;
 
-    shootPressedLastFrame = shootPressed;
+    movePlayer(entity, buttons, yaw);
+
+    // Shooting (press J or Left Mouse)
+    if (pressed & BUTTON_FIRE)
+    {
+        // Aim where the player's camera looks
+        glm::vec3 position = world.get<Transform>(entity)->position;
+        createBullet(bullets, position + MUZZLE_OFFSET, aimDirection(yaw, pitch), BULLET_SPEED, simTick);
+
+        if (soundManager && entity == player) soundManager->playGunShot();
+    }
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    idleScreen.dirty = true;
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
@@ -1528,13 +3067,104 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
         firstMouse = false;
     }
 
-    float xoffset = xpos - lastX;
-    float yoffset = ypos - lastY;
+    pendingMouseDx += (float)(xpos - lastX);
+    pendingMouseDy += (float)(ypos - lastY);
     lastX = xpos;
     lastY = ypos;
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    pendingScroll += (float)yoffset;
+}
+
+uint32_t buttonForKey(int key)
+{
+    switch (key)
+    {
+    case GLFW_KEY_W: return BUTTON_FORWARD;
+    case GLFW_KEY_S: return BUTTON_BACK;
+    case GLFW_KEY_A: return BUTTON_LEFT;
+    case GLFW_KEY_D: return BUTTON_RIGHT;
+    case GLFW_KEY_J: return BUTTON_FIRE;
+    case GLFW_KEY_ESCAPE: return BUTTON_PAUSE;
+    case GLFW_KEY_ENTER: return BUTTON_CONFIRM;
+    case GLFW_KEY_UP: return BUTTON_UP;
+    case GLFW_KEY_DOWN: return BUTTON_DOWN;
+    default: return 0;
+    }
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    idleScreen.dirty = true;
+
+    // Debug hotkeys act right away and never reach the simulation
+    if (action == GLFW_PRESS && key == GLFW_KEY_F3)
+        showProfiler = !showProfiler;
+#if NYX_PROFILER
+    // F4 records the next few seconds as a Chrome trace
+    if (action == GLFW_PRESS && key == GLFW_KEY_F4 && !profiler::Profiler::instance().capturing())
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "nyx_trace_%ld.json", (long)time(nullptr));
+        profiler::Profiler::instance().startCapture(TRACE_HOTKEY_FRAMES, name);
+    }
+#endif
+
+    uint32_t button = buttonForKey(key);
+    if (action == GLFW_PRESS)
+    {
+        heldKeyButtons |= button;
+        pendingPressed |= button;
+    }
+    else if (action == GLFW_REPEAT)
+    {
+        pendingPressed |= button & (BUTTON_UP | BUTTON_DOWN);  // menu scrolling
+    }
+    else if (action == GLFW_RELEASE)
+    {
+        heldKeyButtons &= ~button;
+    }
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    if (button != GLFW_MOUSE_BUTTON_LEFT)
+        return;
+    mouseFireHeld = action == GLFW_PRESS;
+    if (action == GLFW_PRESS)
+        pendingPressed |= BUTTON_FIRE;
+}
+
+void window_refresh_callback(GLFWwindow* window)
+{
+    idleScreen.dirty = true;
+}
+
+// Everything the simulation reads from the keyboard and mouse this tick
+InputFrame sampleInput(GLFWwindow* window, float dt)
+{
+    InputFrame input = {};
+    input.dt = dt;
+
+    input.buttons = heldKeyButtons | (mouseFireHeld ? BUTTON_FIRE : 0u);
+    input.pressed = pendingPressed;
+    pendingPressed = 0;
+
+    input.mouseDx = pendingMouseDx;
+    input.mouseDy = pendingMouseDy;
+    input.scroll = pendingScroll;
+    pendingMouseDx = 0.0f;
+    pendingMouseDy = 0.0f;
+    pendingScroll = 0.0f;
+    return input;
+}
 
-    xoffset *= MOUSE_SENSITIVITY;
-    yoffset *= MOUSE_SENSITIVITY;
+void applyMouseLook(const InputFrame& input)
+{
+    float xoffset = input.mouseDx * MOUSE_SENSITIVITY;
+    float yoffset = input.mouseDy * MOUSE_SENSITIVITY;
 
     // Rotate camera (not character)
     characterYaw -= xoffset;
@@ -1545,34 +3175,136 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
         cameraPitch = 45.0f;
     if (cameraPitch < -45.0f)
         cameraPitch = -45.0f;
+
+    if (input.scroll != 0.0f)
+        camera.ProcessMouseScroll(input.scroll);
 }
 
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+// Fingerprint of everything the simulation owns, compared at the end of a replay
+uint32_t simStateHash()
 {
-    camera.ProcessMouseScroll(yoffset);
+    uint32_t hash = HASH_SEED;
+    hash = hashBytes(hash, &gameState, sizeof(gameState));
+    hash = hashBytes(hash, &playerTransform().position, sizeof(glm::vec3));
+    hash = hashBytes(hash, &cameraYaw, sizeof(cameraYaw));
+    hash = hashBytes(hash, &cameraPitch, sizeof(cameraPitch));
+    hash = hashBytes(hash, &playerHealth().current, sizeof(float));
+    hash = hashBytes(hash, &currentScore, sizeof(currentScore));
+    world.each<Transform, Hitbox>([&](const Transform& t, const Hitbox&) {
+        hash = hashBytes(hash, &t.position, sizeof(t.position));
+    });
+    bullets.each([&](uint32_t slot) {
+        hash = hashBytes(hash, &bullets.position(slot), sizeof(glm::vec3));
+    });
+    return hash;
 }
 
-// Precise AABB test using world-space bullet position and target's local bbox scaled/translated to world
-bool bulletHitsTarget(const Bullet& bullet, const Target& target)
+void cleanupTargets()
 {
-    // Compute world AABB for the target
-    glm::vec3 minWorld = target.position + target.bboxMin * target.modelScale;
-    glm::vec3 maxWorld = target.position + target.bboxMax * target.modelScale;
-
-    // Simple point-in-AABB test for bullet position
-    const glm::vec3& p = bullet.position;
-    return (p.x >= minWorld.x && p.x <= maxWorld.x) &&
-        (p.y >= minWorld.y && p.y <= maxWorld.y) &&
-        (p.z >= minWorld.z && p.z <= maxWorld.z);
+    world.each<Hitbox, AnimationState>([](const Hitbox&, const AnimationState& anim) {
+        releaseEnemyAnimator(anim.animator);
+    });
+    world.destroyAll<Transform, Hitbox>();
 }
 
-void cleanupTargets()
+void shutdownGame()
+{
+    // hand the target animators back to the pool
+    cleanupTargets();
+
+    if (soundManager) {
+        delete soundManager;
+        soundManager = nullptr;
+    }
+
+    destroySceneCache(pauseCache);
+    streamBuffer.destroy();
+    glfwTerminate();
+}
+
+SkeletalAnimator* acquireEnemyAnimator()
+{
+    if (freeEnemyAnimators.empty())
+        return nullptr;
+    int index = freeEnemyAnimators.back();
+    freeEnemyAnimators.pop_back();
+    return &enemyAnimators[index];
+}
+
+void releaseEnemyAnimator(SkeletalAnimator* animator)
+{
+    if (!animator)
+        return;
+    freeEnemyAnimators.push_back((int)(animator - enemyAnimators.data()));
+}
+
+// NULL_ENTITY when every pooled animator is in use
+ecs::Entity spawnTarget(const glm::vec3& position)
+{
+    SkeletalAnimator* animator = acquireEnemyAnimator();
+    if (!animator)
+        return ecs::NULL_ENTITY;
+
+    animator->PlayAnimation(enemyRunPtr);
+    return createTarget(world, position, TARGET_SPEED, targetHitbox(), AnimationState{ animator, enemyRunPtr });
+}
+
+// Somewhere on a ring around the arena center, no rejection sampling
+static void spawnLoadTestTarget()
+{
+    float angle = gameRng.nextFloat() * 6.2831853f;
+    float radius = 6.0f + gameRng.nextFloat() * 8.0f;
+    if (spawnTarget(glm::vec3(cos(angle) * radius, 0.1f, sin(angle) * radius)) != ecs::NULL_ENTITY)
+        loadTestSpawned++;
+}
+
+void updateLoadTest(float dt)
 {
-    for (auto& t : targets) {
-        if (t.animator) {
-            delete t.animator;
-            t.animator = nullptr;
+    int cap = loadTest.maxTargets;
+
+    // Steady trickle; budget left over while at the cap is dropped
+    loadTestSpawnBudget += loadTest.spawnRate * dt;
+    while (loadTestSpawnBudget >= 1.0f && (int)targetCount(world) < cap)
+    {
+        loadTestSpawnBudget -= 1.0f;
+        spawnLoadTestTarget();
+    }
+    loadTestSpawnBudget = std::min(loadTestSpawnBudget, 1.0f);
+
+    // Burst waves
+    if (loadTest.waveInterval > 0.0f)
+    {
+        loadTestWaveTimer += dt;
+        if (loadTestWaveTimer >= loadTest.waveInterval)
+        {
+            loadTestWaveTimer -= loadTest.waveInterval;
+            for (int i = 0; i < loadTest.waveSize && (int)targetCount(world) < cap; ++i)
+                spawnLoadTestTarget();
         }
     }
-    targets.clear();
+
+    // Bots aim at a random live target, bullets go through the normal pass
+    if (loadTest.fireRate > 0.0f)
+    {
+        PROFILE_ZONE("bots");
+        float interval = 1.0f / loadTest.fireRate;
+        for (Shooter& shooter : shooters)
+        {
+            shooter.cooldown -= dt;
+            while (shooter.cooldown <= 0.0f)
+            {
+                shooter.cooldown += interval;
+                size_t liveTargets = targetCount(world);
+                if (liveTargets == 0 || bulletCount(bullets) >= bulletCapacity)
+                    continue;
+
+                ecs::Entity target = world.at<Transform, Hitbox>(gameRng.range((int)liveTargets));
+                glm::vec3 aim = world.get<Transform>(target)->position + glm::vec3(0.0f, 0.5f, 0.0f);
+                createBullet(bullets, shooter.position, glm::normalize(aim - shooter.position), BULLET_SPEED, simTick);
+            }
+        }
+    }
+
+    loadTestPeakTargets = std::max(loadTestPeakTargets, (int)targetCount(world));
+    loadTestPeakBullets = std::max(loadTestPeakBullets, (int)bulletCount(bullets));
 }
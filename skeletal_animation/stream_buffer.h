@@ -0,0 +1,194 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstddef>
+#include <iostream>
+
+// Ring buffer for data the CPU rewrites every frame (text quads, bullet
+// instances, bone palettes). Callers map() a slice, memcpy into it, unmap()
+// and draw from the returned offset; nothing goes through glBufferSubData or
+// per-draw uniform arrays.
+//
+// With GL_ARB_buffer_storage the buffer is mapped once, persistently and
+// coherently, and split into FRAMES regions. nextFrame() fences the region
+// the GPU was just given and waits on the oldest fence before it is reused,
+// so the CPU can run FRAMES - 1 frames ahead without the driver syncing.
+//
+// Without it (plain GL 3.3) the buffer is orphaned once per frame and every
+// map() is unsynchronized, which gives the driver a fresh allocation to write
+// into instead of a stall.
+
+// Not in the GL 3.3 headers
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+class StreamBuffer {
+public:
+    static const int FRAMES = 3;
+
+    StreamBuffer() = default;
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    ~StreamBuffer() { destroy(); }
+
+    // frameBytes is the most one frame may write. allowPersistent = false
+    // forces the orphaning path even where buffer storage exists.
+    void init(size_t frameBytes, bool allowPersistent = true)
+    {
+        m_FrameBytes = frameBytes;
+
+        BufferStorageProc bufferStorage = nullptr;
+        if (allowPersistent && glfwExtensionSupported("GL_ARB_buffer_storage"))
+            bufferStorage = (BufferStorageProc)glfwGetProcAddress("glBufferStorage");
+
+        glGenBuffers(1, &m_Buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+        if (bufferStorage)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            m_Size = frameBytes * FRAMES;
+            bufferStorage(GL_COPY_WRITE_BUFFER, (GLsizeiptr)m_Size, nullptr, flags);
+            m_Mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)m_Size, flags);
+            m_Persistent = m_Mapped != nullptr;
+        }
+        if (!m_Persistent)
+        {
+            if (bufferStorage)
+                std::cout << "Warning: persistent mapping failed, streaming through orphaned buffers" << std::endl;
+            // Storage made with glBufferStorage is immutable, start over
+            glDeleteBuffers(1, &m_Buffer);
+            glGenBuffers(1, &m_Buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+            m_Size = frameBytes;
+            glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)m_Size, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        m_Frame = 0;
+        m_Head = 0;
+        m_End = m_FrameBytes;
+    }
+
+    void destroy()
+    {
+        for (GLsync& fence : m_Fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+        if (m_Buffer)
+        {
+            if (m_Persistent)
+            {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+                glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &m_Buffer);
+        }
+        m_Buffer = 0;
+        m_Mapped = nullptr;
+        m_Persistent = false;
+    }
+
+    // Call once per frame before anything is mapped
+    void nextFrame()
+    {
+        m_LastFrameUsed = m_Head - (m_End - m_FrameBytes);
+
+        if (!m_Persistent)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)m_Size, nullptr, GL_STREAM_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            m_Head = 0;
+            m_End = m_FrameBytes;
+            return;
+        }
+
+        // Everything submitted so far may still read the region just used
+        if (m_Fences[m_Frame])
+            glDeleteSync(m_Fences[m_Frame]);
+        m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        m_Frame = (m_Frame + 1) % FRAMES;
+        if (GLsync fence = m_Fences[m_Frame])
+        {
+            GLenum result = glClientWaitSync(fence, 0, 0);
+            if (result == GL_TIMEOUT_EXPIRED)
+            {
+                m_Stalls++;
+                glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            }
+            glDeleteSync(fence);
+            m_Fences[m_Frame] = nullptr;
+        }
+        m_Head = m_Frame * m_FrameBytes;
+        m_End = m_Head + m_FrameBytes;
+    }
+
+    // Writable slice of 'size' bytes, its buffer offset in 'offset'. Returns
+    // nullptr once the frame's budget is used up (warns once).
+    void* map(size_t size, size_t align, GLintptr& offset)
+    {
+        size_t start = (m_Head + align - 1) / align * align;
+        if (start + size > m_End)
+        {
+            if (!m_Overflowed)
+                std::cout << "Warning: stream buffer out of space (" << m_FrameBytes << " bytes per frame)" << std::endl;
+            m_Overflowed = true;
+            return nullptr;
+        }
+        m_Head = start + size;
+        offset = (GLintptr)start;
+
+        if (m_Persistent)
+            return m_Mapped + start;
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+        return glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, (GLsizeiptr)size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    }
+
+    // Must follow every successful map() before the data is drawn from
+    void unmap()
+    {
+        if (m_Persistent)
+            return;
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    unsigned int buffer() const { return m_Buffer; }
+    bool persistent() const { return m_Persistent; }
+    size_t frameBytes() const { return m_FrameBytes; }
+    size_t lastFrameUsed() const { return m_LastFrameUsed; }
+    int stalls() const { return m_Stalls; }      // frames that had to wait on the GPU
+
+private:
+    typedef void (APIENTRY* BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    unsigned int m_Buffer = 0;
+    unsigned char* m_Mapped = nullptr;
+    bool m_Persistent = false;
+    size_t m_Size = 0;
+    size_t m_FrameBytes = 0;
+    int m_Frame = 0;
+    size_t m_Head = 0;
+    size_t m_End = 0;
+    size_t m_LastFrameUsed = 0;
+    GLsync m_Fences[FRAMES] = {};
+    int m_Stalls = 0;
+    bool m_Overflowed = false;
+};
+
+#endif
@@ -2,11 +2,15 @@
 in vec2 TexCoords;
 out vec4 color;
 
+// Signed distance field atlas (font_atlas.h): 0.5 on the outline, more
+// inside. fwidth keeps the edge about a pixel wide at any scale.
 uniform sampler2D text;
 uniform vec3 textColor;
 
 void main()
-{    
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-    color = vec4(textColor, 1.0) * sampled;
+{
+    float distance = texture(text, TexCoords).r;
+    float edge = max(fwidth(distance) * 0.5, 1e-4);
+    float alpha = smoothstep(0.5 - edge, 0.5 + edge, distance);
+    color = vec4(textColor, alpha);
 }
\ No newline at end of file
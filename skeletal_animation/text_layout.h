@@ -0,0 +1,46 @@
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include <glm/glm.hpp>
+
+// Glyph metrics and quad layout for RenderText, kept free of GL calls so the
+// layout math can be benchmarked on its own. Every glyph is a rectangle of
+// the one font atlas (font_atlas.h).
+
+struct Character {
+    glm::ivec2   Size;
+    glm::ivec2   Bearing;
+    unsigned int Advance;   // in 1/64 pixels
+    glm::vec2    UvMin;     // atlas rectangle, UvMin at the glyph's top left
+    glm::vec2    UvMax;
+};
+
+// Screen-space quad (pos.xy, uv) for one glyph with its baseline at (x, y).
+// Returns the pen advance in pixels.
+inline float layoutGlyph(const Character& ch, float x, float y, float scale, float vertices[6][4])
+{
+    float xpos = x + ch.Bearing.x * scale;
+    float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
+
+    float w = ch.Size.x * scale;
+    float h = ch.Size.y * scale;
+
+    float u0 = ch.UvMin.x, v0 = ch.UvMin.y;
+    float u1 = ch.UvMax.x, v1 = ch.UvMax.y;
+    const float quad[6][4] = {
+        { xpos,     ypos + h,   u0, v0 },
+        { xpos,     ypos,       u0, v1 },
+        { xpos + w, ypos,       u1, v1 },
+
+        { xpos,     ypos + h,   u0, v0 },
+        { xpos + w, ypos,       u1, v1 },
+        { xpos + w, ypos + h,   u1, v0 }
+    };
+    for (int v = 0; v < 6; ++v)
+        for (int i = 0; i < 4; ++i)
+            vertices[v][i] = quad[v][i];
+
+    return (ch.Advance >> 6) * scale;
+}
+
+#endif
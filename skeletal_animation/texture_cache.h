@@ -0,0 +1,189 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <stb_image.h>
+
+#include "texture_file.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Model textures for the GL side. load() takes a source image path and
+// uploads its cooked file (texture_file.h) when there is an up-to-date one:
+// mapped, every level passed to GL as it sits in the file, no decode and no
+// glGenerateMipmap. Otherwise the source is decoded with stb_image and the
+// driver builds the mips, as learnopengl's TextureFromFile does, with a
+// warning to run the cook tool.
+//
+// Block compressed files need GL_EXT_texture_compression_s3tc (every
+// desktop driver has it, it is just not core); without it they count as
+// missing. Each path is loaded once, later calls return the same texture.
+
+// Not in the GL 3.3 headers
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+class TextureCache {
+public:
+    // Call with a current context
+    void init()
+    {
+        m_Compressed = glfwExtensionSupported("GL_EXT_texture_compression_s3tc") != 0;
+    }
+
+    GLuint load(const std::string& path)
+    {
+        auto found = m_Textures.find(path);
+        if (found != m_Textures.end())
+            return found->second;
+
+        auto start = std::chrono::steady_clock::now();
+        Entry entry;
+        entry.name = path;
+        GLuint texture = loadCooked(path, entry);
+        if (!texture)
+            texture = loadSource(path, entry);
+        entry.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_Entries.push_back(entry);
+        m_Textures[path] = texture;
+        return texture;
+    }
+
+    // One line per texture and the totals, for the startup report
+    void printReport() const
+    {
+        float total = 0.0f;
+        size_t bytes = 0;
+        int cooked = 0;
+        for (const Entry& entry : m_Entries)
+        {
+            std::string name = entry.name.size() > 40 ? "..." + entry.name.substr(entry.name.size() - 37) : entry.name;
+            printf("[startup]   %-40s %-8s %7.2f ms %8.1f KB\n", name.c_str(), entry.source, entry.ms, entry.bytes / 1024.0f);
+            total += entry.ms;
+            bytes += entry.bytes;
+            cooked += entry.cooked ? 1 : 0;
+        }
+        printf("[startup]   %d textures in %.2f ms, %d cooked, %.1f KB of texture memory%s\n",
+            (int)m_Entries.size(), total, cooked, bytes / 1024.0f, m_Compressed ? "" : " (no s3tc)");
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        const char* source = "";    // rgba8 / bc1 / bc3 (cooked), decoded, stale (then decoded) or missing
+        float ms = 0.0f;
+        size_t bytes = 0;           // every level as stored by GL
+        bool cooked = false;
+    };
+
+    GLuint loadCooked(const std::string& path, Entry& entry)
+    {
+        MappedFile file;
+        if (!file.open(cookedTexturePath(path)))
+            return 0;
+        TextureFileHeader header;
+        const TextureFileLevel* levels = nullptr;
+        if (!parseTextureFile(file.data(), file.size(), header, levels))
+        {
+            std::cout << "Warning: " << cookedTexturePath(path) << " is not a cooked texture, ignoring it" << std::endl;
+            return 0;
+        }
+        uint64_t sourceSize = 0;
+        int64_t sourceTime = 0;
+        if (textureSourceStamp(path, sourceSize, sourceTime) && (sourceSize != header.sourceSize || sourceTime != header.sourceTime))
+        {
+            std::cout << "Warning: " << path << " changed since it was cooked, decoding it (run nyx_cook)" << std::endl;
+            entry.source = "stale";
+            return 0;
+        }
+        if (header.format != TEXTURE_RGBA8 && !m_Compressed)
+            return 0;
+
+        static const char* const NAMES[] = { "rgba8", "bc1", "bc3" };
+        static const GLenum FORMATS[] = { GL_RGBA8, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT };
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        uint32_t width = header.width, height = header.height;
+        for (uint32_t i = 0; i < header.levels; ++i)
+        {
+            const unsigned char* data = file.data() + levels[i].offset;
+            if (header.format == TEXTURE_RGBA8)
+                glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            else
+                glCompressedTexImage2D(GL_TEXTURE_2D, i, FORMATS[header.format], width, height, 0, (GLsizei)levels[i].size, data);
+            entry.bytes += levels[i].size;
+            width = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.levels - 1);
+        setSampling();
+        entry.source = NAMES[header.format];
+        entry.cooked = true;
+        return texture;
+    }
+
+    GLuint loadSource(const std::string& path, Entry& entry)
+    {
+        stbi_set_flip_vertically_on_load(true);
+        int width, height, components;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &components, 0);
+        GLuint texture;
+        glGenTextures(1, &texture);
+        if (!data)
+        {
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+            entry.source = "missing";
+            return texture;
+        }
+        if (entry.source[0] == '\0')
+        {
+            std::cout << "Warning: " << path << " has no cooked texture, decoding it (run nyx_cook)" << std::endl;
+            entry.source = "decoded";
+        }
+
+        GLenum format = components == 1 ? GL_RED : components == 3 ? GL_RGB : GL_RGBA;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        setSampling();
+        stbi_image_free(data);
+
+        // Drivers pad RGB to four bytes a texel; the mips add a third
+        entry.bytes = (size_t)width * height * (components == 1 ? 1 : 4) * 4 / 3;
+        return texture;
+    }
+
+    static void setSampling()
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    bool m_Compressed = false;
+    std::map<std::string, GLuint> m_Textures;
+    std::vector<Entry> m_Entries;
+};
+
+#endif
@@ -0,0 +1,431 @@
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Cooked textures: what the GPU wants, ready to upload. A cooked file holds
+// every mip level, already flipped to GL's bottom-up row order, raw RGBA8
+// or block compressed (BC1 for opaque images, BC3 when any texel has alpha).
+// The game memory-maps it and hands each level straight to glTexImage2D /
+// glCompressedTexImage2D (texture_cache.h); nothing is decoded at startup.
+//
+// Layout, little endian:
+//
+//   TextureFileHeader
+//   TextureFileLevel[levels]     level 0 is full size
+//   level data, each level starting on a TEXTURE_FILE_ALIGN boundary
+//
+// The header keeps the size and modification time of the image it was
+// cooked from, so a cooked file older than its source is noticed and the
+// source used instead.
+
+const uint32_t TEXTURE_FILE_MAGIC = 0x5458594E;     // "NYXT"
+const uint32_t TEXTURE_FILE_VERSION = 1;
+const uint32_t TEXTURE_FILE_ALIGN = 16;
+const char* const TEXTURE_FILE_EXTENSION = ".nyxtex";  // appended to the source's name
+
+enum TextureFormat : uint32_t {
+    TEXTURE_RGBA8 = 0,
+    TEXTURE_BC1 = 1,        // 8 bytes per 4x4 block, no alpha
+    TEXTURE_BC3 = 2,        // 16 bytes per 4x4 block, BC1 colour plus interpolated alpha
+};
+
+struct TextureFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;        // TextureFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    uint64_t sourceSize;    // bytes of the image it was cooked from
+    int64_t sourceTime;     // and its last write time, in filesystem clock ticks
+};
+
+struct TextureFileLevel {
+    uint64_t offset;        // from the start of the file
+    uint64_t size;
+};
+
+inline std::string cookedTexturePath(const std::string& sourcePath)
+{
+    return sourcePath + TEXTURE_FILE_EXTENSION;
+}
+
+// Size and write time of a source image, as recorded in a cooked header.
+// False when it does not exist.
+inline bool textureSourceStamp(const std::string& path, uint64_t& size, int64_t& time)
+{
+    std::error_code error;
+    size = (uint64_t)std::filesystem::file_size(path, error);
+    if (error)
+        return false;
+    time = (int64_t)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    return !error;
+}
+
+inline uint32_t textureLevelSize(uint32_t format, uint32_t width, uint32_t height)
+{
+    if (format == TEXTURE_RGBA8)
+        return width * height * 4;
+    uint32_t blocks = std::max(1u, (width + 3) / 4) * std::max(1u, (height + 3) / 4);
+    return blocks * (format == TEXTURE_BC1 ? 8 : 16);
+}
+
+// ==================== MAPPED FILE ====================
+
+// A whole file mapped read-only. Pages come in as the upload touches them
+// and are shared with the OS file cache, so nothing is copied into the heap.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path)
+    {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping)
+            return false;
+        m_Data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!m_Data)
+            return false;
+        m_Size = (size_t)size.QuadPart;
+#else
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return false;
+        struct stat info;
+        void* data = MAP_FAILED;
+        if (fstat(file, &info) == 0 && info.st_size > 0)
+            data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        ::close(file);
+        if (data == MAP_FAILED)
+            return false;
+        m_Data = (const unsigned char*)data;
+        m_Size = (size_t)info.st_size;
+#endif
+        return true;
+    }
+
+    void close()
+    {
+        if (!m_Data)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(m_Data);
+#else
+        munmap((void*)m_Data, m_Size);
+#endif
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+    const unsigned char* data() const { return m_Data; }
+    size_t size() const { return m_Size; }
+
+private:
+    const unsigned char* m_Data = nullptr;
+    size_t m_Size = 0;
+};
+
+// Header and level table of a cooked file in memory, checked against the
+// file's size. False for anything that is not a whole cooked texture.
+inline bool parseTextureFile(const unsigned char* data, size_t size, TextureFileHeader& header, const TextureFileLevel*& levels)
+{
+    if (size < sizeof(TextureFileHeader))
+        return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != TEXTURE_FILE_MAGIC || header.version != TEXTURE_FILE_VERSION ||
+        header.format > TEXTURE_BC3 || header.width == 0 || header.height == 0 ||
+        header.levels == 0 || header.levels > 32 ||
+        size < sizeof(TextureFileHeader) + header.levels * sizeof(TextureFileLevel))
+        return false;
+
+    levels = (const TextureFileLevel*)(data + sizeof(TextureFileHeader));
+    uint32_t width = header.width, height = header.height;
+    for (uint32_t i = 0; i < header.levels; ++i)
+    {
+        if (levels[i].size != textureLevelSize(header.format, width, height) ||
+            levels[i].offset > size || levels[i].size > size - levels[i].offset)
+            return false;
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+    return true;
+}
+
+// ==================== COOKING ====================
+
+// Next mip level of an RGBA8 image: the 2x2 box average, edge texels
+// repeated when a side is odd
+inline void downsampleRGBA(const unsigned char* source, uint32_t width, uint32_t height, std::vector<unsigned char>& out)
+{
+    uint32_t outWidth = std::max(1u, width / 2);
+    uint32_t outHeight = std::max(1u, height / 2);
+    out.resize((size_t)outWidth * outHeight * 4);
+    for (uint32_t y = 0; y < outHeight; ++y)
+    {
+        uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+        for (uint32_t x = 0; x < outWidth; ++x)
+        {
+            uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            for (int c = 0; c < 4; ++c)
+            {
+                uint32_t sum = source[(y0 * width + x0) * 4 + c] + source[(y0 * width + x1) * 4 + c] +
+                    source[(y1 * width + x0) * 4 + c] + source[(y1 * width + x1) * 4 + c];
+                out[(y * outWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+inline uint16_t packRGB565(int r, int g, int b)
+{
+    return (uint16_t)(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+}
+
+inline void unpackRGB565(uint16_t c, int rgb[3])
+{
+    int r = c >> 11 & 31, g = c >> 5 & 63, b = c & 31;
+    rgb[0] = r << 3 | r >> 2;
+    rgb[1] = g << 2 | g >> 4;
+    rgb[2] = b << 3 | b >> 2;
+}
+
+// BC1 colour block for 16 RGBA texels, always in four colour mode. The
+// endpoints are the corners of the block's colour bounding box, the
+// diagonal picked to follow how red and blue vary with green, pulled in by
+// 1/16 so the extremes land on the interpolated colours.
+inline void encodeColorBlock(const unsigned char texels[64], unsigned char out[8])
+{
+    int min[3] = { 255, 255, 255 }, max[3] = { 0, 0, 0 };
+    int mean[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+        {
+            min[c] = std::min(min[c], (int)texels[i * 4 + c]);
+            max[c] = std::max(max[c], (int)texels[i * 4 + c]);
+            mean[c] += texels[i * 4 + c];
+        }
+    int covRG = 0, covBG = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        int g = texels[i * 4 + 1] * 16 - mean[1];
+        covRG += (texels[i * 4 + 0] * 16 - mean[0]) * g;
+        covBG += (texels[i * 4 + 2] * 16 - mean[2]) * g;
+    }
+    if (covRG < 0)
+        std::swap(min[0], max[0]);
+    if (covBG < 0)
+        std::swap(min[2], max[2]);
+    for (int c = 0; c < 3; ++c)
+    {
+        int inset = (max[c] - min[c]) / 16;
+        min[c] += inset;
+        max[c] -= inset;
+    }
+
+    uint16_t c0 = packRGB565(max[0], max[1], max[2]);
+    uint16_t c1 = packRGB565(min[0], min[1], min[2]);
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    uint32_t indices = 0;
+    if (c0 != c1)
+    {
+        int palette[4][3];
+        unpackRGB565(c0, palette[0]);
+        unpackRGB565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 4; ++p)
+            {
+                int error = 0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    int d = texels[i * 4 + c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError)
+                {
+                    best = p;
+                    bestError = error;
+                }
+            }
+            indices |= (uint32_t)best << (i * 2);
+        }
+    }
+
+    out[0] = (unsigned char)(c0 & 0xFF);
+    out[1] = (unsigned char)(c0 >> 8);
+    out[2] = (unsigned char)(c1 & 0xFF);
+    out[3] = (unsigned char)(c1 >> 8);
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+// BC3 alpha block: the block's alpha range in eight steps
+inline void encodeAlphaBlock(const unsigned char texels[64], unsigned char out[8])
+{
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; ++i)
+    {
+        a0 = std::max(a0, (int)texels[i * 4 + 3]);
+        a1 = std::min(a1, (int)texels[i * 4 + 3]);
+    }
+    int palette[8] = { a0, a1 };
+    for (int p = 1; p < 7; ++p)
+        palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+
+    uint64_t indices = 0;
+    if (a0 != a1)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestError = 256;
+            for (int p = 0; p < 8; ++p)
+            {
+                int error = std::abs(texels[i * 4 + 3] - palette[p]);
+                if (error < bestError)
+                {
+                    best = p;
+                    bestError = error;
+                }
+            }
+            indices |= (uint64_t)best << (i * 3);
+        }
+    }
+
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+// One level of RGBA8 as BC1 or BC3; partial blocks at the edges repeat the
+// last row and column
+inline void compressLevel(const unsigned char* rgba, uint32_t width, uint32_t height, uint32_t format, unsigned char* out)
+{
+    unsigned char texels[64];
+    for (uint32_t by = 0; by < std::max(1u, (height + 3) / 4); ++by)
+        for (uint32_t bx = 0; bx < std::max(1u, (width + 3) / 4); ++bx)
+        {
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                uint32_t x = std::min(bx * 4 + i % 4, width - 1);
+                uint32_t y = std::min(by * 4 + i / 4, height - 1);
+                std::memcpy(&texels[i * 4], &rgba[(y * width + x) * 4], 4);
+            }
+            if (format == TEXTURE_BC3)
+            {
+                encodeAlphaBlock(texels, out);
+                out += 8;
+            }
+            encodeColorBlock(texels, out);
+            out += 8;
+        }
+}
+
+// A whole cooked file for an RGBA8 image whose rows are already bottom-up.
+// With 'compress', BC1 or BC3 depending on whether it has any alpha.
+inline void cookTexture(const unsigned char* rgba, uint32_t width, uint32_t height, bool compress,
+    uint64_t sourceSize, int64_t sourceTime, std::vector<unsigned char>& out)
+{
+    uint32_t format = TEXTURE_RGBA8;
+    if (compress)
+    {
+        format = TEXTURE_BC1;
+        for (size_t i = 3; i < (size_t)width * height * 4; i += 4)
+            if (rgba[i] != 255)
+            {
+                format = TEXTURE_BC3;
+                break;
+            }
+    }
+
+    uint32_t levels = 1;
+    while ((width >> levels) > 0 || (height >> levels) > 0)
+        levels++;
+
+    TextureFileHeader header = { TEXTURE_FILE_MAGIC, TEXTURE_FILE_VERSION, format, width, height, levels, sourceSize, sourceTime };
+    std::vector<TextureFileLevel> table(levels);
+    size_t offset = sizeof(header) + levels * sizeof(TextureFileLevel);
+    for (uint32_t i = 0, w = width, h = height; i < levels; ++i)
+    {
+        offset = (offset + TEXTURE_FILE_ALIGN - 1) / TEXTURE_FILE_ALIGN * TEXTURE_FILE_ALIGN;
+        table[i] = { offset, textureLevelSize(format, w, h) };
+        offset += table[i].size;
+        w = std::max(1u, w / 2);
+        h = std::max(1u, h / 2);
+    }
+
+    out.assign(offset, 0);
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + sizeof(header), table.data(), levels * sizeof(TextureFileLevel));
+
+    std::vector<unsigned char> level(rgba, rgba + (size_t)width * height * 4);
+    std::vector<unsigned char> next;
+    for (uint32_t i = 0, w = width, h = height; i < levels; ++i)
+    {
+        if (format == TEXTURE_RGBA8)
+            std::memcpy(out.data() + table[i].offset, level.data(), level.size());
+        else
+            compressLevel(level.data(), w, h, format, out.data() + table[i].offset);
+        if (i + 1 < levels)
+        {
+            downsampleRGBA(level.data(), w, h, next);
+            level.swap(next);
+            w = std::max(1u, w / 2);
+            h = std::max(1u, h / 2);
+        }
+    }
+}
+
+inline bool writeTextureFile(const std::string& path, const std::vector<unsigned char>& bytes)
+{
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+#endif
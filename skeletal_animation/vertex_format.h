@@ -0,0 +1,96 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Skinned vertex layouts. SkinnedVertex is the importer's, all floats (88
+// bytes). CompactSkinnedVertex keeps what the skinning shaders read (24
+// bytes): float position, unorm16 UVs, uint8 bone ids, unorm8 weights that
+// add up to exactly 255. Meshes with UVs outside [0, 1] or bone ids past 255
+// stay full.
+
+const int MAX_SKIN_INFLUENCES = 4;   // must match MAX_BONE_INFLUENCE in anim_model.vs
+
+enum VertexFormat {
+    VERTEX_FULL,
+    VERTEX_COMPACT,
+};
+
+// Same layout as learnopengl's Vertex
+struct SkinnedVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoords;
+    glm::vec3 tangent;
+    glm::vec3 bitangent;
+    int boneIds[MAX_SKIN_INFLUENCES];        // -1 = unused
+    float weights[MAX_SKIN_INFLUENCES];
+};
+
+struct CompactSkinnedVertex {
+    glm::vec3 position;
+    uint16_t texCoords[2];
+    uint8_t boneIds[MAX_SKIN_INFLUENCES];
+    uint8_t weights[MAX_SKIN_INFLUENCES];
+};
+
+static_assert(sizeof(CompactSkinnedVertex) == 24, "CompactSkinnedVertex is tightly packed");
+
+const float COMPACT_UV_SLACK = 1e-4f;   // exporters leave UVs this far past 0 and 1, clamped
+
+// Whether every vertex fits the compact layout
+inline bool canPackCompact(const std::vector<SkinnedVertex>& vertices)
+{
+    const float lo = -COMPACT_UV_SLACK, hi = 1.0f + COMPACT_UV_SLACK;
+    for (const SkinnedVertex& v : vertices)
+    {
+        if (v.texCoords.x < lo || v.texCoords.x > hi || v.texCoords.y < lo || v.texCoords.y > hi)
+            return false;
+        for (int k = 0; k < MAX_SKIN_INFLUENCES; ++k)
+            if (v.boneIds[k] > 255)
+                return false;
+    }
+    return true;
+}
+
+inline void packCompact(const SkinnedVertex& in, CompactSkinnedVertex& out)
+{
+    out.position = in.position;
+    out.texCoords[0] = (uint16_t)std::lround(glm::clamp(in.texCoords.x, 0.0f, 1.0f) * 65535.0f);
+    out.texCoords[1] = (uint16_t)std::lround(glm::clamp(in.texCoords.y, 0.0f, 1.0f) * 65535.0f);
+
+    // Weights renormalized, rounded, and the rounding error given to the
+    // largest so they still add up to one
+    float sum = 0.0f;
+    for (int k = 0; k < MAX_SKIN_INFLUENCES; ++k)
+        sum += in.boneIds[k] >= 0 ? in.weights[k] : 0.0f;
+    int total = 0, largest = 0;
+    for (int k = 0; k < MAX_SKIN_INFLUENCES; ++k)
+    {
+        bool used = in.boneIds[k] >= 0 && sum > 0.0f;
+        out.boneIds[k] = used ? (uint8_t)in.boneIds[k] : 0;
+        out.weights[k] = used ? (uint8_t)std::lround(in.weights[k] / sum * 255.0f) : 0;
+        total += out.weights[k];
+        if (out.weights[k] > out.weights[largest])
+            largest = k;
+    }
+    if (total > 0)
+        out.weights[largest] = (uint8_t)(out.weights[largest] + 255 - total);
+}
+
+// The whole mesh, or false (and 'out' untouched) when it does not fit
+inline bool packCompactVertices(const std::vector<SkinnedVertex>& in, std::vector<CompactSkinnedVertex>& out)
+{
+    if (!canPackCompact(in))
+        return false;
+    out.resize(in.size());
+    for (size_t i = 0; i < in.size(); ++i)
+        packCompact(in[i], out[i]);
+    return true;
+}
+
+#endif